@@ -0,0 +1,187 @@
+#include "epoch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define ADVANCE_ATTEMPTS 2 /// memory retired in epoch e is freed once the global epoch reaches e + 2
+
+/// Epoch state of a thread (reused by another thread once the thread exits).
+typedef struct epoch_record {
+	atomic_ullong state; /// Epoch the thread is in, shifted left by one, with the lowest bit set while it is in a critical section.
+	atomic_int in_use; /// 1 while the record belongs to a thread.
+	struct epoch_record* next; /// Next record (records are never removed until epoch_shutdown).
+} epoch_record;
+
+/// Memory waiting to be freed.
+typedef struct retired_node {
+	void* ptr; /// Memory to free.
+	void (*destroy)(void* ptr); /// Function that frees the memory.
+	unsigned int epoch; /// Global epoch when the memory was retired.
+	struct retired_node* next; /// Next retired memory (oldest first).
+} retired_node;
+
+static atomic_uint global_epoch = 0;
+static _Atomic(epoch_record*) records = NULL; /// Records of all the threads that ever entered a critical section.
+
+static pthread_mutex_t retired_mutex = PTHREAD_MUTEX_INITIALIZER; /// Serializes the retirements (they are rare compared to reads).
+static retired_node* retired_head = NULL;
+static retired_node* retired_tail = NULL;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t record_key; /// Gives the record of a thread back when the thread exits.
+static _Thread_local epoch_record* thread_record = NULL;
+
+/// Releases the record of a thread that exited.
+/// @param record Record of the thread.
+static void release_record(void* record) {
+	atomic_store(&((epoch_record*) record)->state, 0);
+	atomic_store(&((epoch_record*) record)->in_use, 0);
+}
+
+static void create_key() {
+	if (pthread_key_create(&record_key, release_record) != 0) {
+		fprintf(stderr, "Error: Error creating the epoch thread key\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/// Gets the record of the calling thread, taking a free one (or a new one) the first time.
+/// @return Record of the calling thread.
+static epoch_record* get_record() {
+	if (thread_record != NULL) {
+		return thread_record;
+	}
+
+	pthread_once(&key_once, create_key);
+
+	epoch_record* record;
+	for (record = atomic_load(&records); record != NULL; record = record->next) {
+		int free_record = 0;
+		if (atomic_compare_exchange_strong(&record->in_use, &free_record, 1)) {
+			break;
+		}
+	}
+
+	if (record == NULL) {
+		record = malloc(sizeof(epoch_record));
+		if (record == NULL) {
+			fprintf(stderr, "Error: Error allocating memory for the epoch record\n");
+			exit(EXIT_FAILURE);
+		}
+
+		atomic_init(&record->state, 0);
+		atomic_init(&record->in_use, 1);
+		record->next = atomic_load(&records);
+		while (!atomic_compare_exchange_weak(&records, &record->next, record));
+	}
+
+	pthread_setspecific(record_key, record);
+	thread_record = record;
+	return record;
+}
+
+void epoch_enter() {
+	epoch_record* record = get_record();
+	unsigned int epoch = atomic_load(&global_epoch);
+
+	while (1) { /// the published epoch must still be the global one, or the thread could miss a retirement
+		atomic_store(&record->state, (unsigned long long) epoch << 1 | 1);
+
+		unsigned int current = atomic_load(&global_epoch);
+		if (current == epoch) {
+			break;
+		}
+		epoch = current;
+	}
+}
+
+void epoch_exit() {
+	atomic_store(&thread_record->state, 0);
+}
+
+/// Advances the global epoch if every thread in a critical section is in the current one.
+/// @return 1 if the epoch was advanced, 0 otherwise.
+static int try_advance() {
+	unsigned int epoch = atomic_load(&global_epoch);
+
+	for (epoch_record* record = atomic_load(&records); record != NULL; record = record->next) {
+		unsigned long long state = atomic_load(&record->state);
+		if ((state & 1) && (state >> 1) != epoch) {
+			return 0;
+		}
+	}
+
+	return atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+}
+
+/// Frees the retired memory that no thread can be reading anymore (the caller must hold retired_mutex).
+static void free_retired() {
+	unsigned int epoch = atomic_load(&global_epoch);
+
+	while (retired_head != NULL && epoch - retired_head->epoch >= ADVANCE_ATTEMPTS) {
+		retired_node* node = retired_head;
+		retired_head = node->next;
+		if (retired_head == NULL) {
+			retired_tail = NULL;
+		}
+
+		node->destroy(node->ptr);
+		free(node);
+	}
+}
+
+void epoch_retire(void* ptr, void (*destroy)(void* ptr)) {
+	retired_node* node = malloc(sizeof(retired_node));
+	if (node == NULL) {
+		fprintf(stderr, "Error: Error allocating memory for retired memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	node->ptr = ptr;
+	node->destroy = destroy;
+	node->next = NULL;
+
+	pthread_mutex_lock(&retired_mutex);
+
+	node->epoch = atomic_load(&global_epoch);
+	if (retired_tail == NULL) {
+		retired_head = node;
+	} else {
+		retired_tail->next = node;
+	}
+	retired_tail = node;
+
+	for (int i = 0; i < ADVANCE_ATTEMPTS && try_advance(); i++);
+	free_retired();
+
+	pthread_mutex_unlock(&retired_mutex);
+}
+
+void epoch_shutdown() {
+	pthread_mutex_lock(&retired_mutex);
+
+	while (retired_head != NULL) {
+		retired_node* node = retired_head;
+		retired_head = node->next;
+		node->destroy(node->ptr);
+		free(node);
+	}
+	retired_tail = NULL;
+
+	pthread_mutex_unlock(&retired_mutex);
+
+	if (thread_record != NULL) { /// the record of the calling thread is freed below, so it must not be released when the thread exits
+		pthread_setspecific(record_key, NULL);
+	}
+
+	epoch_record* record = atomic_exchange(&records, NULL);
+	while (record != NULL) {
+		epoch_record* next = record->next;
+		free(record);
+		record = next;
+	}
+
+	thread_record = NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+/// Epoch-based memory reclamation: memory unlinked from a shared structure is only freed once every thread that could still
+/// be reading it has left the critical section in which it found it.
+/// Readers only publish the epoch they are in (no locks), so it suits structures that are read far more often than modified.
+
+/// Enters a read-side critical section: the memory reachable from shared structures stays valid until epoch_exit.
+/// @note Critical sections can't be nested.
+void epoch_enter();
+
+/// Leaves a read-side critical section.
+void epoch_exit();
+
+/// Frees memory once no thread can be reading it anymore (the caller must have unlinked it already).
+/// @param ptr Memory to free.
+/// @param destroy Function that frees the memory.
+void epoch_retire(void* ptr, void (*destroy)(void* ptr));
+
+/// Frees all the retired memory and the bookkeeping of the threads.
+/// @note Must be called when no thread is in a critical section (and none will enter one again).
+void epoch_shutdown();
+
+#endif  // EPOCH_H
@@ -6,7 +6,7 @@
 struct EventList* create_list() {
 	struct EventList* list = (struct EventList*)malloc(sizeof(struct EventList));
 	if (!list) return NULL;
-	list->head = NULL;
+	atomic_init(&list->head, NULL);
 	list->tail = NULL;
 	return list;
 }
@@ -18,41 +18,77 @@ int append_to_list(struct EventList* list, struct Event* event) {
 	if (!new_node) return 1;
 
 	new_node->event = event;
-	new_node->next = NULL;
+	atomic_init(&new_node->next, NULL);
 
-	if (list->head == NULL) {
-		list->head = new_node;
-		list->tail = new_node;
+	/// the node is published last (release), so a thread that finds it also sees the event fully initialized
+	if (list->tail == NULL) {
+		atomic_store_explicit(&list->head, new_node, memory_order_release);
 	} else {
-		list->tail->next = new_node;
-		list->tail = new_node;
+		atomic_store_explicit(&list->tail->next, new_node, memory_order_release);
 	}
+	list->tail = new_node;
 
 	return 0;
 }
 
-static void free_event(struct Event* event) {
+struct ListNode* unlink_from_list(struct EventList* list, unsigned int event_id) {
+	if (!list) return NULL;
+
+	struct ListNode* previous = NULL;
+	struct ListNode* current = atomic_load_explicit(&list->head, memory_order_relaxed); /// only the writers (holding the mutex) modify the links
+	while (current && current->event->id != event_id) {
+		previous = current;
+		current = atomic_load_explicit(&current->next, memory_order_relaxed);
+	}
+
+	if (!current) return NULL;
+
+	/// the unlinked node keeps pointing to its successor, so a thread standing on it can still walk the rest of the list
+	struct ListNode* next = atomic_load_explicit(&current->next, memory_order_relaxed);
+	if (previous == NULL) {
+		atomic_store_explicit(&list->head, next, memory_order_release);
+	} else {
+		atomic_store_explicit(&previous->next, next, memory_order_release);
+	}
+
+	if (list->tail == current) {
+		list->tail = previous;
+	}
+
+	return current;
+}
+
+void free_event(struct Event* event) {
 	if (!event) return;
 
-	free(event->data);
+	if (pthread_rwlock_destroy(&event->rwlock) != 0) {
+		fprintf(stderr, "Error: Error destroying rwlock\n");
+		exit(1);
+	}
+
+	for (size_t i = 0; i < event->num_stripes; i++) {
+		pthread_mutex_destroy(&event->stripes[i].mutex);
+	}
+	free(event->stripes);
+
+	seatmap_destroy(&event->seats);
 	free(event);
 }
 
+void free_list_node(void* node) {
+	free_event(((struct ListNode*) node)->event);
+	free(node);
+}
+
 void free_list(struct EventList* list) {
 	if (!list) return;
 
-	struct ListNode* current = list->head;
+	struct ListNode* current = atomic_load(&list->head);
 	while (current) {
 		struct ListNode* temp = current;
-		current = current->next;
-
-		if (pthread_rwlock_destroy(&temp->event->rwlock) != 0) {
-			fprintf(stderr, "Error: Error destroying rwlock\n");
-			exit(1);
-		}
+		current = atomic_load(&current->next);
 
-		free_event(temp->event);
-		free(temp);
+		free_list_node(temp);
 	}
 
 	free(list);
@@ -61,13 +97,13 @@ void free_list(struct EventList* list) {
 struct Event* get_event(struct EventList* list, unsigned int event_id) {
 	if (!list) return NULL;
 
-	struct ListNode* current = list->head;
+	struct ListNode* current = atomic_load_explicit(&list->head, memory_order_acquire);
 	while (current) {
 		struct Event* event = current->event;
 		if (event->id == event_id) {
 			return event;
 		}
-		current = current->next;
+		current = atomic_load_explicit(&current->next, memory_order_acquire);
 	}
 
 	return NULL;
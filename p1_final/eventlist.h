@@ -2,30 +2,47 @@
 #define EVENT_LIST_H
 
 #include <stddef.h> 
+#include <stdint.h>
 #include <pthread.h>
+#include <stdatomic.h>
+
+#include "seatmap.h"
+
+/// Lock of a stripe of rows of an event (striped locking strategy).
+struct EventStripe {
+	pthread_mutex_t mutex; /// Mutex of the rows of the stripe.
+	uint64_t acquired_ns; /// Time at which the current holder acquired the mutex (lock profiling).
+	atomic_ullong release_time; /// Logical time at which the mutex was last released (virtual time mode).
+};
 
 /// Event structure
 struct Event {
 	unsigned int id; /// Event id.
-	unsigned int reservations; /// Number of reservations for the event.
+	atomic_uint reservations; /// Number of reservations for the event (atomic, as some strategies reserve without an exclusive lock).
 
 	size_t cols; /// Number of columns.
 	size_t rows; /// Number of rows.
-	unsigned int* data; /// Array of size rows * cols with the reservations for each seat.
+	struct SeatMap seats; /// Reservations for each of the rows * cols seats (after the event for small events, sparse for large, lightly booked ones).
 
 	pthread_rwlock_t rwlock; /// Read-write lock for the event.
+	atomic_ullong release_time; /// Logical time at which the rwlock was last released (virtual time mode).
+
+	struct EventStripe* stripes; /// Locks of the stripes of rows, NULL unless the striped locking strategy is used.
+	size_t num_stripes; /// Number of stripes (row r belongs to stripe (r - 1) % num_stripes).
 };
 
 /// Linked list node structure
 struct ListNode {
 	struct Event* event; /// Event stored in the node.
-	struct ListNode* next; /// Next node in the list.
+	_Atomic(struct ListNode*) next; /// Next node in the list (read without locks, see get_event).
 };
 
 // Linked list structure
+// The list is modified with the general mutex for events held, but it can be searched without it: removed nodes are
+// only freed through epoch_retire, once no thread that could have found them is still in its epoch critical section.
 struct EventList {
-	struct ListNode* head;  // Head of the list.
-	struct ListNode* tail;  // Tail of the list.
+	_Atomic(struct ListNode*) head;  // Head of the list.
+	struct ListNode* tail;  // Tail of the list (only used to append).
 };
 
 /// Creates a new event list.
@@ -38,12 +55,26 @@ struct EventList* create_list();
 /// @return 0 if the node was appended successfully, 1 otherwise.
 int append_to_list(struct EventList* list, struct Event* data);
 
-/// Removes a node from the list.
+/// Unlinks the node of an event from the list (the node stays valid for the threads that already found it).
 /// @param list Event list to be modified.
-/// @return 0 if the node was removed successfully, 1 otherwise.
+/// @param event_id Event id.
+/// @return Unlinked node (to be freed with free_list_node once no thread can be reading it), NULL if the event is not in the list.
+struct ListNode* unlink_from_list(struct EventList* list, unsigned int event_id);
+
+/// Frees an event that is not in a list (with its locks and seats).
+/// @param event Event to free.
+void free_event(struct Event* event);
+
+/// Frees a node unlinked from the list, with its event.
+/// @param node Node to free (a struct ListNode*, so that it can be given to epoch_retire).
+void free_list_node(void* node);
+
+/// Frees the list with all its events.
+/// @param list Event list to be freed.
 void free_list(struct EventList* list);
 
 /// Retrieves an event in the list.
+/// @note Without the general mutex for events, the caller must be in an epoch critical section while it uses the event.
 /// @param list Event list to be searched.
 /// @param event_id Event id.
 /// @return Pointer to the event if found, NULL otherwise.
@@ -0,0 +1,138 @@
+#include "lockprof.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#define LOCKPROF_ENV "EMS_LOCK_PROFILING" /// environment variable that enables the profiler at run time
+
+#ifdef EMS_LOCK_PROFILING
+static int profiling = 1; /// compiled in
+#else
+static int profiling = 0; /// set once by lockprof_init, before the threads are created
+#endif
+
+/// Returns the current time of the monotonic clock in nanoseconds.
+static uint64_t monotonic_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void lockprof_init() {
+	const char* value = getenv(LOCKPROF_ENV);
+
+	if (value != NULL && strcmp(value, "") != 0 && strcmp(value, "0") != 0) {
+		profiling = 1;
+	}
+}
+
+int lockprof_enabled() {
+	return profiling;
+}
+
+/// Records an acquisition that started waiting at the given time (0 if it didn't have to wait).
+/// @return Time at which the lock was acquired.
+static uint64_t record_acquisition(lock_stats* stats, uint64_t wait_start_ns) {
+	uint64_t now = monotonic_ns();
+
+	atomic_fetch_add_explicit(&stats->acquisitions, 1, memory_order_relaxed);
+
+	if (wait_start_ns != 0) {
+		unsigned long long wait = now - wait_start_ns;
+		unsigned long long max_wait = atomic_load_explicit(&stats->max_wait_ns, memory_order_relaxed);
+
+		atomic_fetch_add_explicit(&stats->contended, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&stats->wait_ns, wait, memory_order_relaxed);
+		while (wait > max_wait && !atomic_compare_exchange_weak_explicit(&stats->max_wait_ns, &max_wait, wait,
+				memory_order_relaxed, memory_order_relaxed));
+	}
+
+	return now;
+}
+
+/// Records how long a lock was held.
+static void record_release(lock_stats* stats, uint64_t acquired_ns) {
+	if (acquired_ns != 0) {
+		atomic_fetch_add_explicit(&stats->hold_ns, monotonic_ns() - acquired_ns, memory_order_relaxed);
+	}
+}
+
+uint64_t lockprof_mutex_lock(pthread_mutex_t* mutex, lock_stats* stats) {
+	if (!profiling) {
+		pthread_mutex_lock(mutex);
+		return 0;
+	}
+
+	uint64_t wait_start = 0;
+	if (pthread_mutex_trylock(mutex) == EBUSY) { /// only a failed try counts as contended
+		wait_start = monotonic_ns();
+		pthread_mutex_lock(mutex);
+	}
+
+	return record_acquisition(stats, wait_start);
+}
+
+void lockprof_mutex_unlock(pthread_mutex_t* mutex, lock_stats* stats, uint64_t acquired_ns) {
+	if (profiling) {
+		record_release(stats, acquired_ns);
+	}
+	pthread_mutex_unlock(mutex);
+}
+
+uint64_t lockprof_rdlock(pthread_rwlock_t* rwlock, lock_stats* stats) {
+	if (!profiling) {
+		pthread_rwlock_rdlock(rwlock);
+		return 0;
+	}
+
+	uint64_t wait_start = 0;
+	if (pthread_rwlock_tryrdlock(rwlock) == EBUSY) {
+		wait_start = monotonic_ns();
+		pthread_rwlock_rdlock(rwlock);
+	}
+
+	return record_acquisition(stats, wait_start);
+}
+
+uint64_t lockprof_wrlock(pthread_rwlock_t* rwlock, lock_stats* stats) {
+	if (!profiling) {
+		pthread_rwlock_wrlock(rwlock);
+		return 0;
+	}
+
+	uint64_t wait_start = 0;
+	if (pthread_rwlock_trywrlock(rwlock) == EBUSY) {
+		wait_start = monotonic_ns();
+		pthread_rwlock_wrlock(rwlock);
+	}
+
+	return record_acquisition(stats, wait_start);
+}
+
+void lockprof_rwlock_unlock(pthread_rwlock_t* rwlock, lock_stats* stats, uint64_t acquired_ns) {
+	if (profiling) {
+		record_release(stats, acquired_ns);
+	}
+	pthread_rwlock_unlock(rwlock);
+}
+
+void lockprof_report(lock_stats* const* stats, int num_locks) {
+	if (!profiling) {
+		return;
+	}
+
+	fprintf(stderr, "Lock profile of process %d:\n", (int) getpid());
+	fprintf(stderr, "%-24s %12s %12s %14s %14s %14s\n", "lock", "acquisitions", "contended", "wait (ms)", "max wait (ms)", "hold (ms)");
+
+	for (int i = 0; i < num_locks; i++) {
+		fprintf(stderr, "%-24s %12llu %12llu %14.3f %14.3f %14.3f\n", stats[i]->name,
+			atomic_load(&stats[i]->acquisitions), atomic_load(&stats[i]->contended),
+			(double) atomic_load(&stats[i]->wait_ns) / 1e6, (double) atomic_load(&stats[i]->max_wait_ns) / 1e6,
+			(double) atomic_load(&stats[i]->hold_ns) / 1e6);
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/// Contention statistics of a named lock (or of a group of locks, like the rwlocks of all the events).
+typedef struct {
+	const char* name; /// Name shown in the report.
+	atomic_ullong acquisitions; /// Number of times the lock was acquired.
+	atomic_ullong contended; /// Number of acquisitions that had to wait for another thread.
+	atomic_ullong wait_ns; /// Total time spent waiting for the lock.
+	atomic_ullong max_wait_ns; /// Longest wait for the lock.
+	atomic_ullong hold_ns; /// Total time the lock was held.
+} lock_stats;
+
+/// Enables the profiler if it was compiled in (-DEMS_LOCK_PROFILING) or if the EMS_LOCK_PROFILING environment variable is set
+/// to a value other than 0. Without it, the lock functions below only lock and unlock.
+/// @note Must be called before the threads that use the locks are created.
+void lockprof_init();
+
+/// Checks if the profiler is enabled.
+/// @return 1 if it is enabled, 0 otherwise.
+int lockprof_enabled();
+
+/// Locks a mutex, recording the acquisition.
+/// @param mutex Mutex to lock.
+/// @param stats Statistics of the mutex.
+/// @return Time at which the mutex was acquired (0 if the profiler is disabled), to be given back when unlocking it.
+uint64_t lockprof_mutex_lock(pthread_mutex_t* mutex, lock_stats* stats);
+
+/// Unlocks a mutex, recording how long it was held.
+/// @param mutex Mutex to unlock.
+/// @param stats Statistics of the mutex.
+/// @param acquired_ns Time returned when the mutex was locked.
+void lockprof_mutex_unlock(pthread_mutex_t* mutex, lock_stats* stats, uint64_t acquired_ns);
+
+/// Locks a rwlock for reading, recording the acquisition.
+/// @param rwlock Rwlock to lock.
+/// @param stats Statistics of the read acquisitions.
+/// @return Time at which the rwlock was acquired (0 if the profiler is disabled), to be given back when unlocking it.
+uint64_t lockprof_rdlock(pthread_rwlock_t* rwlock, lock_stats* stats);
+
+/// Locks a rwlock for writing, recording the acquisition.
+/// @param rwlock Rwlock to lock.
+/// @param stats Statistics of the write acquisitions.
+/// @return Time at which the rwlock was acquired (0 if the profiler is disabled), to be given back when unlocking it.
+uint64_t lockprof_wrlock(pthread_rwlock_t* rwlock, lock_stats* stats);
+
+/// Unlocks a rwlock, recording how long it was held.
+/// @param rwlock Rwlock to unlock.
+/// @param stats Statistics given when it was locked.
+/// @param acquired_ns Time returned when the rwlock was locked.
+void lockprof_rwlock_unlock(pthread_rwlock_t* rwlock, lock_stats* stats, uint64_t acquired_ns);
+
+/// Prints the statistics of the given locks to stderr (does nothing if the profiler is disabled).
+/// @param stats Statistics of each lock.
+/// @param num_locks Number of locks.
+void lockprof_report(lock_stats* const* stats, int num_locks);
+
+#endif // LOCKPROF_H
@@ -0,0 +1,140 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <pthread.h>
+
+#define TRACE_BUFFER_SPANS 32768 /// spans kept per thread (the oldest ones are overwritten)
+
+/// Span recorded by a thread.
+typedef struct {
+	uint64_t start_ns; /// Start time.
+	uint64_t duration_ns; /// Duration.
+	const char* category; /// Category (a string literal).
+	const char* name; /// Name (a string literal).
+	long long arg; /// Event id, or TRACE_NO_ARG.
+} trace_span;
+
+/// Ring buffer of the spans of a thread (written only by its thread, read only after it finished).
+typedef struct trace_buffer {
+	int thread_id; /// Id of the thread shown in the trace.
+	size_t recorded; /// Number of spans recorded (the last TRACE_BUFFER_SPANS are kept).
+	trace_span spans[TRACE_BUFFER_SPANS]; /// Spans, indexed by recorded % TRACE_BUFFER_SPANS.
+	struct trace_buffer* next; /// Next registered buffer.
+} trace_buffer;
+
+int trace_on = 0;
+
+static uint64_t trace_origin_ns = 0; /// time at which tracing was enabled (the trace starts there)
+static trace_buffer* buffers = NULL; /// buffers of all the threads that were registered
+static pthread_mutex_t buffers_mutex = PTHREAD_MUTEX_INITIALIZER; /// only taken to register a thread and to write the trace
+static _Thread_local trace_buffer* thread_buffer = NULL; /// buffer of the calling thread
+
+/// Returns the current time of the monotonic clock in nanoseconds.
+static uint64_t monotonic_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void trace_enable() {
+	trace_origin_ns = monotonic_ns();
+	trace_on = 1;
+}
+
+uint64_t trace_clock_ns() {
+	return trace_on ? monotonic_ns() : 0;
+}
+
+void trace_thread_start(int thread_id) {
+	if (!trace_on) {
+		return;
+	}
+
+	trace_buffer* buffer = malloc(sizeof(trace_buffer));
+	if (buffer == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the trace buffer failed (the thread won't be traced)\n");
+		return;
+	}
+
+	buffer->thread_id = thread_id;
+	buffer->recorded = 0;
+
+	pthread_mutex_lock(&buffers_mutex);
+	buffer->next = buffers;
+	buffers = buffer;
+	pthread_mutex_unlock(&buffers_mutex);
+
+	thread_buffer = buffer;
+}
+
+void trace_record(uint64_t start_ns, const char* category, const char* name, long long arg) {
+	trace_buffer* buffer = thread_buffer;
+	if (buffer == NULL) {
+		return;
+	}
+
+	trace_span* span = &buffer->spans[buffer->recorded % TRACE_BUFFER_SPANS];
+	span->start_ns = start_ns;
+	span->duration_ns = monotonic_ns() - start_ns;
+	span->category = category;
+	span->name = name;
+	span->arg = arg;
+	buffer->recorded++;
+}
+
+/// Writes the spans of a buffer, oldest first.
+static void write_buffer(FILE* file, const trace_buffer* buffer, int pid, int* first) {
+	size_t kept = buffer->recorded < TRACE_BUFFER_SPANS ? buffer->recorded : TRACE_BUFFER_SPANS;
+
+	fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+		*first ? "" : ",", pid, buffer->thread_id, buffer->thread_id);
+	*first = 0;
+
+	for (size_t i = buffer->recorded - kept; i < buffer->recorded; i++) {
+		const trace_span* span = &buffer->spans[i % TRACE_BUFFER_SPANS];
+		uint64_t start_ns = span->start_ns > trace_origin_ns ? span->start_ns - trace_origin_ns : 0;
+
+		/// timestamps are in microseconds
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+			span->name, span->category, (double) start_ns / 1000.0, (double) span->duration_ns / 1000.0, pid, buffer->thread_id);
+
+		if (span->arg != TRACE_NO_ARG) {
+			fprintf(file, ",\"args\":{\"event_id\":%lld}", span->arg);
+		}
+		fprintf(file, "}");
+	}
+
+	if (kept < buffer->recorded) {
+		fprintf(stderr, "Warning: The trace of thread %d lost its %zu oldest spans\n", buffer->thread_id, buffer->recorded - kept);
+	}
+}
+
+int trace_write(const char* filename) {
+	pthread_mutex_lock(&buffers_mutex);
+
+	FILE* file = fopen(filename, "w");
+	int pid = (int) getpid();
+	int first = 1;
+
+	if (file != NULL) {
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+		for (trace_buffer* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+			write_buffer(file, buffer, pid, &first);
+		}
+		fprintf(file, "\n]}\n");
+	}
+
+	while (buffers != NULL) {
+		trace_buffer* next = buffers->next;
+		free(buffers);
+		buffers = next;
+	}
+
+	pthread_mutex_unlock(&buffers_mutex);
+
+	return file == NULL || fclose(file) != 0;
+}
@@ -0,0 +1,53 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_NO_ARG -1 /// argument of the spans that don't refer to an event
+
+extern int trace_on; /// 1 when tracing is enabled (set once before the threads are created, so it's only read concurrently)
+
+/// Enables tracing: the threads registered with trace_thread_start record spans until the trace is written.
+/// @note Must be called before the threads that process the files are created.
+void trace_enable();
+
+/// Gets the current time for the start of a span.
+/// @return Current time in nanoseconds, 0 if tracing is disabled (so that a disabled trace costs a single branch).
+uint64_t trace_clock_ns();
+
+/// Gives the calling thread its own ring buffer, where its spans are recorded without locking.
+/// When the buffer is full, the oldest spans are overwritten. Does nothing if tracing is disabled.
+/// @param thread_id Id of the thread shown in the trace.
+void trace_thread_start(int thread_id);
+
+/// Records a span of the calling thread (does nothing if the thread has no buffer).
+/// @param start_ns Start of the span, from trace_begin.
+/// @param category Category of the span (a string literal).
+/// @param name Name of the span (a string literal).
+/// @param arg Event id the span refers to, or TRACE_NO_ARG.
+void trace_record(uint64_t start_ns, const char* category, const char* name, long long arg);
+
+/// Starts a span.
+/// @return Start of the span, 0 if tracing is disabled.
+static inline uint64_t trace_begin() {
+	return trace_on ? trace_clock_ns() : 0;
+}
+
+/// Ends a span started with trace_begin.
+/// @param start_ns Start of the span.
+/// @param category Category of the span (a string literal).
+/// @param name Name of the span (a string literal).
+/// @param arg Event id the span refers to, or TRACE_NO_ARG.
+static inline void trace_end(uint64_t start_ns, const char* category, const char* name, long long arg) {
+	if (trace_on) {
+		trace_record(start_ns, category, name, arg);
+	}
+}
+
+/// Writes the spans of all the threads to a file in the Chrome trace event format (chrome://tracing, Perfetto),
+/// then frees their buffers. Must be called after the threads finished.
+/// @param filename Name of the file to write.
+/// @return 0 if the trace was written successfully, 1 otherwise.
+int trace_write(const char* filename);
+
+#endif // TRACE_H
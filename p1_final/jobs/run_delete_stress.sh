@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Stress test of DELETE: events are created and deleted while other threads show and reserve them.
+# Meant to be run with a build instrumented with -fsanitize=address or -fsanitize=thread, which report any use of a freed event.
+# Usage: run_delete_stress.sh <path to ems> [number of threads] [repetitions]
+
+# Color codes
+GREEN='\033[0;32m'  # Green for PASS
+RED='\033[0;31m'    # Red for FAIL
+NC='\033[0m'        # No color (reset)
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <path to ems> [number of threads] [repetitions]"
+    exit 1
+fi
+
+ems="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+threads="${2:-8}"
+repetitions="${3:-5}"
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# Workload: a few event ids are created and deleted over and over, and every line around them shows or reserves them
+# (the threads take the lines in turns, so a thread deletes an event while the others are using it)
+events=4
+{
+    for round in $(seq 1 200); do
+        for event in $(seq 1 $events); do
+            echo "CREATE $event 10 10"
+            echo "RESERVE $event [($((round % 10 + 1)),1) ($((round % 10 + 1)),2)]"
+            echo "SHOW $((event % events + 1))"
+            echo "RESERVE $((event % events + 1)) [(1,$((round % 10 + 1)))]"
+            echo "DELETE $event"
+            echo "SHOW $event"
+        done
+        if [ $((round % 50)) -eq 0 ]; then
+            echo "LIST"
+        fi
+    done
+} > "$work_dir/stress.jobs"
+
+failed=0
+for strategy in global rwlock striped lockfree; do
+    strategy_failed=0
+    for repetition in $(seq 1 "$repetitions"); do
+        rm -f "$work_dir"/*.out
+        "$ems" --strategy="$strategy" "$work_dir" 1 "$threads" 0 > /dev/null 2> "$work_dir/stderr.log"
+        status=$?
+
+        if [ $status -ne 0 ] || grep -q -e "Sanitizer" -e "runtime error" -e "Error:" "$work_dir/stderr.log"; then
+            echo -e "${RED}FAIL:${NC} $strategy (repetition $repetition, exit status $status)"
+            grep -e "Sanitizer" -e "runtime error" -e "Error:" "$work_dir/stderr.log" | head -5
+            strategy_failed=1
+            failed=1
+            break
+        fi
+    done
+
+    if [ $strategy_failed -eq 0 ]; then
+        echo -e "${GREEN}PASS:${NC} $strategy ($repetitions runs with $threads threads)"
+    fi
+done
+
+exit $failed
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Differential test of the RESERVE decoder: random and adversarial RESERVE lines (overlong numbers, missing separators,
+# whitespace variants, lines split across the buffers they are read in) must be parsed the same by the decoder and
+# by the byte by byte parser (see tests/reserve_decoder_fuzz.c).
+# Usage: run_reserve_fuzz.sh [number of cases] [number of seeds]
+# CC and CFLAGS choose the compiler and its flags (e.g. CFLAGS="-fsanitize=address,undefined").
+
+# Color codes
+GREEN='\033[0;32m'  # Green for PASS
+RED='\033[0;31m'    # Red for FAIL
+NC='\033[0m'        # No color (reset)
+
+cases="${1:-20000}"
+seeds="${2:-5}"
+
+source_dir="$(cd "$(dirname "$0")/.." && pwd)"
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+if ! ${CC:-cc} -std=c17 -O2 -D_POSIX_C_SOURCE=200809L ${CFLAGS:-} -I"$source_dir" -o "$work_dir/reserve_decoder_fuzz" \
+        "$source_dir/tests/reserve_decoder_fuzz.c" "$source_dir/parser.c" "$source_dir/reserve_decoder.c"; then
+    echo -e "${RED}FAIL:${NC} the test could not be built"
+    exit 1
+fi
+
+failed=0
+for seed in $(seq 1 "$seeds"); do
+    if "$work_dir/reserve_decoder_fuzz" "$cases" "$seed" > /dev/null 2> "$work_dir/stderr.log"; then
+        echo -e "${GREEN}PASS:${NC} seed $seed ($cases cases)"
+    else
+        echo -e "${RED}FAIL:${NC} seed $seed"
+        head -5 "$work_dir/stderr.log"
+        failed=1
+    fi
+done
+
+exit $failed
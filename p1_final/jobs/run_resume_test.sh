@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Checks that a run interrupted after a checkpoint and resumed with --resume produces the same output as an uninterrupted run.
+# Usage: run_resume_test.sh <path to ems>
+
+# Color codes
+GREEN='\033[0;32m'  # Green for PASS
+RED='\033[0;31m'    # Red for FAIL
+NC='\033[0m'        # No color (reset)
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <path to ems>"
+    exit 1
+fi
+
+ems="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+mkdir "$work_dir/uninterrupted" "$work_dir/resumed"
+
+# The run is killed during the WAIT, after the checkpoint of the first BARRIER (a small event and a large, sparse one)
+cat > "$work_dir/resume.jobs" << 'JOBS'
+CREATE 1 10 20
+CREATE 2 300 400
+RESERVE 1 [(1,1) (1,2) (1,3) (2,5)]
+RESERVE 2 [(1,1) (300,400) (150,7)]
+RESERVE 2 [(150,7) (1,2)]
+SHOW 1
+BARRIER
+WAIT 2000
+RESERVE 1 [(3,1) (3,2)]
+RESERVE 2 [(2,2)]
+CREATE 3 2 2
+DELETE 2
+LIST
+SHOW 1
+JOBS
+cp "$work_dir/resume.jobs" "$work_dir/uninterrupted/"
+cp "$work_dir/resume.jobs" "$work_dir/resumed/"
+
+failed=0
+for strategy in global rwlock striped lockfree; do
+    rm -f "$work_dir"/uninterrupted/*.out "$work_dir"/resumed/*.out
+    "$ems" --strategy="$strategy" "$work_dir/uninterrupted" 1 1 0 > /dev/null 2>&1
+
+    "$ems" --strategy="$strategy" --checkpoint "$work_dir/resumed" 1 1 0 > /dev/null 2>&1 &
+    pid=$!
+    sleep 1
+    pkill -KILL -P $pid
+    kill -KILL $pid
+    wait $pid 2> /dev/null
+
+    if [ ! -f "$work_dir/resumed/resume.ckpt" ]; then
+        echo -e "${RED}FAIL:${NC} $strategy (no checkpoint was taken)"
+        failed=1
+        continue
+    fi
+
+    "$ems" --strategy="$strategy" --resume "$work_dir/resumed" 1 1 0 > /dev/null 2>&1
+
+    if [ -f "$work_dir/resumed/resume.ckpt" ]; then
+        echo -e "${RED}FAIL:${NC} $strategy (the checkpoint was not removed)"
+        failed=1
+    elif diff_output=$(diff "$work_dir/resumed/resume.out" "$work_dir/uninterrupted/resume.out"); then
+        echo -e "${GREEN}PASS:${NC} $strategy"
+    else
+        echo -e "${RED}FAIL:${NC} $strategy"
+        echo "$diff_output"
+        failed=1
+    fi
+done
+
+exit $failed
@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Compares the layouts of the seat maps on many small events (see tests/seatmap_bench.c), building the seat maps
+# with different thresholds: the inline capacity (1 keeps every event on the heap, as before the inline layout)
+# and the occupancy at which a sparse map is promoted to a dense one.
+# The EMS itself is not run: with this many events its time goes to finding the events in the list.
+# Usage: run_seatmap_bench.sh [number of events] [repetitions]
+# CC and CFLAGS choose the compiler and its flags.
+
+events="${1:-100000}"
+repetitions="${2:-5}"
+
+source_dir="$(cd "$(dirname "$0")/.." && pwd)"
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# Builds the benchmark with an inline capacity and a promotion divisor, and prints the path of the program.
+build() {
+    local capacity=$1 divisor=$2
+    local program="$work_dir/seatmap_bench_${capacity}_${divisor}"
+    if [ ! -x "$program" ]; then
+        ${CC:-cc} -std=c17 -O2 -D_POSIX_C_SOURCE=200809L ${CFLAGS:-} -DSEATMAP_INLINE_CAPACITY="$capacity" \
+            -DSEATMAP_PROMOTE_DIVISOR="$divisor" -I"$source_dir" -o "$program" \
+            "$source_dir/tests/seatmap_bench.c" "$source_dir/seatmap.c" || exit 1
+    fi
+    echo "$program"
+}
+
+# Runs a workload and prints a row of the table.
+run() {
+    local capacity=$1 divisor=$2 rows=$3 cols=$4 reserved=$5
+    local program
+    program=$(build "$capacity" "$divisor") || exit 1
+    read -r layout size create reserve show show_by_layout destroy _ < <("$program" "$events" "$rows" "$cols" "$reserved" "$repetitions")
+    printf "%8s %7s %7s %8s %6s %5s %10s %11s %9s %9s %11s\n" "$capacity" "$divisor" "${rows}x${cols}" "$reserved" \
+        "$layout" "$size" "$create" "$reserve" "$show" "$show_by_layout" "$destroy"
+}
+
+header() {
+    printf "%8s %7s %7s %8s %6s %5s %10s %11s %9s %9s %11s\n" "inline" "divisor" "seats" "reserved" "layout" "size" \
+        "create" "reserve" "show" "show (1)" "destroy"
+}
+
+echo "Small events: $events events, best of $repetitions repetitions, times in ms (show (1): one loop per layout)"
+header
+for shape in "4 4 4" "8 8 4" "8 8 16" "16 16 16"; do
+    for capacity in 1 16 64 256; do
+        run "$capacity" 8 $shape
+    done
+done
+
+echo
+echo "Larger events, promotion from sparse to dense: $((events / 10)) events"
+events=$((events / 10))
+header
+for reserved in 32 64 128 256; do
+    for divisor in 4 8 16 32; do
+        run 64 "$divisor" 32 32 "$reserved"
+    done
+done
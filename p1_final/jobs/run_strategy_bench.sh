@@ -0,0 +1,77 @@
+#!/bin/bash
+
+# Compares the concurrency strategies of the EMS on the same generated workload.
+# Usage: run_strategy_bench.sh <path to ems> [number of threads] [delay in ms] [repetitions]
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <path to ems> [number of threads] [delay in ms] [repetitions]"
+    exit 1
+fi
+
+ems="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+threads="${2:-8}"
+delay="${3:-1}"
+repetitions="${4:-3}"
+
+strategies="global rwlock striped lockfree"
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# Workload: a few events, each with many small reservations spread over its rows, and a SHOW every 100 reservations
+events=4
+rows=20
+cols=20
+{
+    for event in $(seq 1 $events); do
+        echo "CREATE $event $rows $cols"
+    done
+    for i in $(seq 0 399); do
+        event=$((i % events + 1))
+        row=$((i / events % rows + 1))
+        col=$((i / (events * rows) * 2 % cols + 1))
+        echo "RESERVE $event [($row,$col) ($row,$((col + 1)))]"
+        if [ $((i % 100)) -eq 99 ]; then
+            echo "SHOW $event"
+        fi
+    done
+    echo "LIST"
+} > "$work_dir/workload.jobs"
+
+# Runs the workload with a strategy, number of threads and delay, and prints the elapsed time in ms.
+run() {
+    local strategy=$1 number_of_threads=$2 run_delay=$3
+    rm -f "$work_dir"/*.out
+    local start=$(date +%s%N)
+    "$ems" --strategy="$strategy" "$work_dir" 1 "$number_of_threads" "$run_delay" > /dev/null 2>&1
+    local end=$(date +%s%N)
+    echo $(((end - start) / 1000000))
+}
+
+# With a single thread every strategy must produce the same output (checked without delay)
+run rwlock 1 0 > /dev/null
+cp "$work_dir/workload.out" "$work_dir/expected.result"
+
+echo "Workload: $events events of ${rows}x${cols}, 400 reservations, $threads threads, ${delay} ms delay, $repetitions repetitions"
+printf "%-10s %10s %10s %10s  %s\n" "strategy" "best (ms)" "mean (ms)" "worst (ms)" "1 thread"
+
+for strategy in $strategies; do
+    run "$strategy" 1 0 > /dev/null
+    if diff -q "$work_dir/workload.out" "$work_dir/expected.result" > /dev/null; then
+        check="same output"
+    else
+        check="DIFFERENT OUTPUT"
+    fi
+
+    best=""
+    worst=0
+    total=0
+    for repetition in $(seq 1 "$repetitions"); do
+        elapsed=$(run "$strategy" "$threads" "$delay")
+        total=$((total + elapsed))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+        if [ "$elapsed" -gt "$worst" ]; then worst=$elapsed; fi
+    done
+
+    printf "%-10s %10d %10d %10d  %s\n" "$strategy" "$best" $((total / repetitions)) "$worst" "$check"
+done
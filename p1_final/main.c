@@ -1,38 +1,132 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "constants.h"
 #include "parser.h"
 #include "operations.h"
 #include "processing/processing.h"
+#include "processing/stream_processing.h"
+
+#define MAX_POSITIONAL_ARGS 4 /// <directory> <number of processes> <number of threads> [delay in ms] (or <input> <output> <number of threads> [delay in ms] with --stream)
 
 typedef struct Data Data;
 
+/// Parses an option (an argument starting with "--").
+/// @param option The option to parse.
+/// @param options Pointer to the options to update.
+/// @return 0 if the option is valid, 1 otherwise.
+static int parse_option(const char *option, processing_options *options) {
+	if (strcmp(option, "--adaptive") == 0) {
+		options->adaptive_threads = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--incremental") == 0) {
+		options->incremental = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--virtual-time") == 0) {
+		options->virtual_time = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--trace") == 0) {
+		options->trace = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--watch") == 0) {
+		options->watch = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--checkpoint") == 0) {
+		options->checkpoint = 1;
+		return 0;
+	}
+
+	if (strcmp(option, "--resume") == 0) {
+		options->resume = 1;
+		options->checkpoint = 1; /// a resumed file keeps taking checkpoints
+		return 0;
+	}
+
+	if (strcmp(option, "--stream") == 0) {
+		options->stream = 1;
+		return 0;
+	}
+
+	if (strncmp(option, "--strategy=", strlen("--strategy=")) == 0) {
+		return ems_set_strategy(option + strlen("--strategy=")); /// inherited by the processes that handle the files
+	}
+
+	fprintf(stderr, "Error: Unknown option: %s\n", option);
+	return 1;
+}
+
+/// Prints the usage of the program.
+/// @param program_name Name of the program.
+static void print_usage(const char *program_name) {
+	fprintf(stderr, "Usage: %s [--adaptive] [--incremental] [--virtual-time] [--watch] [--trace] [--checkpoint] [--resume] [--strategy=<strategy>] <directory> <number of processes> <number of threads> [delay in ms]\n", program_name);
+	fprintf(stderr, "       %s --stream [--strategy=<strategy>] <input file, FIFO or -> <output file or -> <number of threads> [delay in ms]\n", program_name);
+	fprintf(stderr, "Strategies: global, rwlock (default), striped, lockfree\n");
+}
+
 int main(int argc, char *argv[]) {
 	unsigned int state_access_delay_ms = STATE_ACCESS_DELAY_MS; /// default delay
+	processing_options options = {0}; /// all the optional modes are disabled by default
+
+	char *args[MAX_POSITIONAL_ARGS]; /// the arguments that are not options
+	int num_args = 0;
 
-	if (argc == 5) {  // if the delay is specified
+	for (int i = 1; i < argc; i++) { /// separate the options from the positional arguments
+		if (strncmp(argv[i], "--", 2) == 0) {
+			if (parse_option(argv[i], &options) != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+		} else if (num_args < MAX_POSITIONAL_ARGS) {
+			args[num_args++] = argv[i];
+		} else {
+			num_args++; /// too many arguments (reported below)
+		}
+	}
+
+	if (num_args == 4) {  // if the delay is specified
 		char *endptr;
-		unsigned long int delay = strtoul(argv[4], &endptr, 10);
+		unsigned long int delay = strtoul(args[3], &endptr, 10);
 
 		if (delay > UINT_MAX) { // if the delay is too large
 			fprintf(stderr, "Error: Invalid delay value or value too large\n");
 			return 1;
-		} 
+		}
 
 		state_access_delay_ms = (unsigned int) delay; // set the delay to the specified value
 	}
 
-	if (argc == 4 || argc == 5) { // if the correct number of arguments are passed
-		if (process_directory_files(argv[1], atoi(argv[2]), atoi(argv[3]), state_access_delay_ms) != 0) { /// process the directory files
-			fprintf(stderr, "Error: Failed to process the directory files.\n"); 
+	if (options.stream && (options.adaptive_threads || options.incremental || options.virtual_time || options.watch || options.trace || options.checkpoint)) {
+		fprintf(stderr, "Error: --adaptive, --incremental, --virtual-time, --watch, --trace, --checkpoint and --resume only apply to job directories.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (options.stream && (num_args == 3 || num_args == 4)) { // if the commands are read from a stream
+		if (process_stream(args[0], args[1], atoi(args[2]), state_access_delay_ms) != 0) {
+			fprintf(stderr, "Error: Failed to process the stream.\n");
+			return 1;
+		}
+	} else if (num_args == 3 || num_args == 4) { // if the correct number of arguments are passed
+		if (process_directory_files(args[0], atoi(args[1]), atoi(args[2]), state_access_delay_ms, &options) != 0) { /// process the directory files
+			fprintf(stderr, "Error: Failed to process the directory files.\n");
 			return 1;
 		}
 	} else { // if the incorrect number of arguments are passed
 		fprintf(stderr, "Error: Incorrect number of arguments.\n");
-		fprintf(stderr, "Usage: %s <directory> <number of processes> <number of threads> [delay in ms]\n", argv[0]);
+		print_usage(argv[0]);
 		return 1;
-	} 
+	}
 }
@@ -2,52 +2,169 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
-#include <time.h>
+#include <stdint.h>
 #include <pthread.h>
 
 #include "utils/utils.h"
 #include "eventlist.h"
+#include "seat_renderer.h"
+#include "vclock.h"
+#include "epoch.h"
+#include "instrumentation/trace.h"
+#include "instrumentation/lockprof.h"
+#include "strategies/strategy.h"
+
+#define MAX_PROFILED_LOCKS 8 /// the shared mutexes and the locks of the strategy
 
 static struct EventList* event_list = NULL;
 static unsigned int state_access_delay_ms = 0;
+static const ems_strategy* strategy = &event_rwlock_strategy; /// concurrency strategy of the operations
+
+static const ems_strategy* const strategies[] = {&global_lock_strategy, &event_rwlock_strategy, &striped_locks_strategy, &lock_free_strategy};
+
+mutex_info events_general_info = {{"events_general_mutex", 0, 0, 0, 0, 0}, 0, 0}; /// general mutex for events
+mutex_info output_info = {{"output_write_mutex", 0, 0, 0, 0, 0}, 0, 0}; /// mutex of the output
+
+void lock_mutex(pthread_mutex_t* mutex, mutex_info* info) {
+	uint64_t wait_start = trace_begin();
+	uint64_t acquired_ns = lockprof_mutex_lock(mutex, &info->stats);
+	info->acquired_ns = acquired_ns; /// only written by the holder
+	trace_end(wait_start, "lock wait", info->stats.name, TRACE_NO_ARG);
+	vclock_acquire(&info->release_time);
+}
 
-/// Calculates a timespec from a delay in milliseconds.
-/// @param delay_ms Delay in milliseconds.
-/// @return Timespec with the given delay.
-static struct timespec delay_to_timespec(unsigned int delay_ms) {
-	return (struct timespec){delay_ms / 1000, (delay_ms % 1000) * 1000000};
+void unlock_mutex(pthread_mutex_t* mutex, mutex_info* info) {
+	vclock_release(&info->release_time);
+	lockprof_mutex_unlock(mutex, &info->stats, info->acquired_ns);
 }
 
-/// Gets the event with the given ID from the state.
-/// @note Will wait to simulate a real system accessing a costly memory resource.
-/// @param event_id The ID of the event to get.
-/// @return Pointer to the event if found, NULL otherwise.
-static struct Event* get_event_with_delay(unsigned int event_id) {
-	struct timespec delay = delay_to_timespec(state_access_delay_ms);
-	nanosleep(&delay, NULL);  // Should not be removed
+void state_access_delay(const char* name, unsigned int event_id) {
+	uint64_t delay_start = trace_begin();
+	vclock_delay(state_access_delay_ms);  // Should not be removed
+	trace_end(delay_start, "delay", name, event_id);
+}
+
+struct Event* get_event_with_delay(unsigned int event_id) {
+	state_access_delay("event lookup", event_id);
 
 	return get_event(event_list, event_id);
 }
 
-/// Gets the seat with the given index from the state.
-/// @note Will wait to simulate a real system accessing a costly memory resource.
-/// @param event Event to get the seat from.
-/// @param index Index of the seat to get.
-/// @return Pointer to the seat.
-static unsigned int* get_seat_with_delay(struct Event* event, size_t index) {
-	struct timespec delay = delay_to_timespec(state_access_delay_ms);
-	nanosleep(&delay, NULL);  // Should not be removed
+unsigned int get_seat_with_delay(struct Event* event, size_t index) {
+	state_access_delay("seat read", event->id);
+
+	return seatmap_get(&event->seats, index);
+}
+
+int set_seat_with_delay(struct Event* event, size_t index, unsigned int reservation_id) {
+	state_access_delay("seat write", event->id);
+
+	return seatmap_set(&event->seats, index, reservation_id);
+}
+
+unsigned int* copy_event_seats(struct Event* event, unsigned int (*read_seat)(struct Event* event, size_t index)) {
+	uint64_t copy_start = trace_begin();
+	unsigned int* seats = malloc((event->rows * event->cols > 0 ? event->rows * event->cols : 1) * sizeof(unsigned int));
+
+	if (seats == NULL) {
+		fprintf(stderr, "Error: Error allocating memory for seats\n");
+		return NULL;
+	}
+
+	if (read_seat != NULL) {
+		for (size_t i = 0; i < event->rows * event->cols; i++) {
+			seats[i] = read_seat(event, i);
+		}
+	} else {
+		for (size_t i = 0; i < event->rows * event->cols; i++) {
+			state_access_delay("seat read", event->id); /// each seat is still an access to the state
+		}
+		seatmap_copy(&event->seats, seats); /// but the seat map is read with one loop for its layout
+	}
 
-	return &event->data[index];
+	trace_end(copy_start, "state", "SHOW copy", event->id);
+	return seats;
 }
 
-/// Gets the index of a seat.
-/// @note This function assumes that the seat exists.
-/// @param event Event to get the seat index from.
-/// @param row Row of the seat.
-/// @param col Column of the seat.
-/// @return Index of the seat.
-static size_t seat_index(struct Event* event, size_t row, size_t col) { return (row - 1) * event->cols + col - 1; }
+int write_event_seats(int output_fd, struct Event* event, unsigned int* seats, pthread_mutex_t* output_write_mutex) {
+	uint64_t render_start = trace_begin();
+	rendered_seats rendered;
+	int result = render_seats(seats, event->rows, event->cols, &rendered);
+	free(seats);
+	trace_end(render_start, "state", "SHOW render", event->id);
+
+	if (result != 0) {
+		fprintf(stderr, "Error: Error allocating memory for the output\n");
+		return 1;
+	}
+
+	lock_mutex(output_write_mutex, &output_info); /// lock the output stream for writing
+	uint64_t output_start = trace_begin();
+	result = write_rendered_seats(output_fd, &rendered);
+	trace_end(output_start, "output", "SHOW output", event->id);
+	unlock_mutex(output_write_mutex, &output_info); /// unlock the output stream
+
+	free_rendered_seats(&rendered);
+	return result;
+}
+
+/// Allocates a new event with all its seats free, prepared for the current strategy.
+/// @param event_id Id of the event.
+/// @param num_rows Number of rows of the event.
+/// @param num_cols Number of columns of the event.
+/// @return The new event (not yet in the events list), NULL on failure.
+static struct Event* new_event(unsigned int event_id, size_t num_rows, size_t num_cols) {
+	struct Event* event = malloc(sizeof(struct Event) + seatmap_inline_size(num_rows * num_cols)); /// small events keep their seats right after them
+
+	if (event == NULL) {
+		fprintf(stderr, "Error: Error allocating memory for event\n");
+		return NULL;
+	}
+	
+	pthread_rwlock_init(&event->rwlock, NULL); /// it will be used for synchronization between threads accessing the same event
+	atomic_init(&event->release_time, vclock_now());
+	event->id = event_id;
+	event->rows = num_rows;
+	event->cols = num_cols;
+	atomic_init(&event->reservations, 0);
+	event->stripes = NULL;
+	event->num_stripes = 0;
+
+	/// all the seats start free (large events don't allocate memory for them yet, unless the strategy accesses them concurrently)
+	unsigned int* inline_seats = (unsigned int*) (event + 1);
+	int seats_failed = strategy->array_seats ? seatmap_init_array(&event->seats, num_rows * num_cols, inline_seats) : seatmap_init(&event->seats, num_rows * num_cols, inline_seats);
+	if (seats_failed != 0) {
+		fprintf(stderr, "Error: Error allocating memory for event data\n");
+		pthread_rwlock_destroy(&event->rwlock);
+		free(event);
+		return NULL;
+	}
+
+	if (strategy->init_event != NULL && strategy->init_event(event) != 0) {
+		fprintf(stderr, "Error: Error allocating memory for event locks\n");
+		free_event(event);
+		return NULL;
+	}
+
+	return event;
+}
+
+int ems_set_strategy(const char* name) {
+	if (event_list != NULL) {
+		fprintf(stderr, "Error: The strategy must be chosen before the EMS state is initialized\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+		if (strcmp(strategies[i]->name, name) == 0) {
+			strategy = strategies[i];
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "Error: Unknown strategy: %s (expected global, rwlock, striped or lockfree)\n", name);
+	return 1;
+}
 
 int ems_init(unsigned int delay_ms) {
 	if (event_list != NULL) {
@@ -57,6 +174,7 @@ int ems_init(unsigned int delay_ms) {
 
 	event_list = create_list();
 	state_access_delay_ms = delay_ms;
+	lockprof_init();
 
 	return event_list == NULL;
 }
@@ -67,202 +185,263 @@ int ems_terminate() {
 		return 1;
 	}
 	
+	lock_stats* profiled_locks[MAX_PROFILED_LOCKS] = {&events_general_info.stats, &output_info.stats};
+	int num_profiled_locks = 2;
+	for (int i = 0; i < strategy->num_profiled_locks && num_profiled_locks < MAX_PROFILED_LOCKS; i++) {
+		profiled_locks[num_profiled_locks++] = strategy->profiled_locks[i];
+	}
+	lockprof_report(profiled_locks, num_profiled_locks);
+
+	epoch_shutdown(); /// frees the deleted events no thread was reading anymore
 	free_list(event_list);
 	return 0;
 }
 
 int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols, pthread_mutex_t* events_general_mutex) {
-	pthread_mutex_lock(events_general_mutex); /// lock the general mutex for events (this mutex is used exclusively for manipulating the events list; in addition, each event has its own read-write lock)
+	lock_mutex(events_general_mutex, &events_general_info); /// lock the general mutex for events (this mutex is used exclusively for manipulating the events list; in addition, each event has its own read-write lock)
 
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 		return 1;
 	}
 
 	if (get_event_with_delay(event_id) != NULL) {
 		fprintf(stderr, "Event already exists\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 		return 1;
 	}
 
-	struct Event* event = malloc(sizeof(struct Event));
+	struct Event* event = new_event(event_id, num_rows, num_cols);
 
 	if (event == NULL) {
-		fprintf(stderr, "Error: Error allocating memory for event\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
-		return 1;
-	}
-	
-	pthread_rwlock_init(&event->rwlock, NULL); /// it will be used for synchronization between threads accessing the same event
-	event->id = event_id;
-	event->rows = num_rows;
-	event->cols = num_cols;
-	event->reservations = 0;
-	event->data = malloc(num_rows * num_cols * sizeof(unsigned int));
-	
-
-	if (event->data == NULL) {
-		fprintf(stderr, "Error: Error allocating memory for event data\n");
-		free(event);
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 		return 1;
 	}
 
-	for (size_t i = 0; i < num_rows * num_cols; i++) {
-		event->data[i] = 0;
-	}
-
 	if (append_to_list(event_list, event) != 0) {
 		fprintf(stderr, "Error: Error appending event to list\n");
-		free(event->data);
-		free(event);
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+		free_event(event);
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 		return 1;
 	}
 
-	pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+	unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 	return 0;
 }
 
 int ems_reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex) {
-	pthread_mutex_lock(events_general_mutex); /// lock the general mutex for events (this mutex is used exclusively for manipulating the events list; in addition, each event has its own read-write lock)
+	if (event_list == NULL) {
+		fprintf(stderr, "EMS state must be initialized\n");
+		return 1;
+	}
+
+	epoch_enter(); /// the event can't be freed while it is being reserved, even if it is deleted meanwhile
+	int result = strategy->reserve(event_id, num_seats, xs, ys, events_general_mutex);
+	epoch_exit();
 
+	return result;
+}
+
+int ems_show(unsigned int event_id, int output_stream, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
 		return 1;
 	}
 
-	struct Event* event = get_event_with_delay(event_id);
+	epoch_enter(); /// the event can't be freed while it is being shown, even if it is deleted meanwhile
+	int result = strategy->show(event_id, output_stream, output_write_mutex, events_general_mutex);
+	epoch_exit();
 
-	if (event == NULL) {
+	return result;
+}
+
+int ems_delete(unsigned int event_id, pthread_mutex_t* events_general_mutex) {
+	if (event_list == NULL) {
+		fprintf(stderr, "EMS state must be initialized\n");
+		return 1;
+	}
+
+	lock_mutex(events_general_mutex, &events_general_info); /// lock the general mutex for events (the list is only modified with it)
+	state_access_delay("event lookup", event_id);
+	struct ListNode* node = unlink_from_list(event_list, event_id);
+	unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+
+	if (node == NULL) {
 		fprintf(stderr, "Event not found\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
 		return 1;
 	}
 
-	pthread_rwlock_wrlock(&event->rwlock); /// lock the event-specific rwlock for writing
-	unsigned int reservation_id = ++event->reservations;
-	pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events cause the individual event rwlock is already locked
+	epoch_retire(node, free_list_node); /// freed once the threads that may have found the event are done with it
+	return 0;
+}
 
-	size_t i = 0;
-	
-	for (; i < num_seats; i++) {
-		size_t row = xs[i];
-		size_t col = ys[i];
-
-		if (row <= 0 || row > event->rows || col <= 0 || col > event->cols) {
-			fprintf(stderr, "Invalid seat\n");
-			pthread_rwlock_unlock(&event->rwlock); /// unlock the event-specific rwlock
-			break;
-		}
+int ems_list_events(int output_stream, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
+	lock_mutex(events_general_mutex, &events_general_info); /// lock the general mutex for events 
 
-		if (*get_seat_with_delay(event, seat_index(event, row, col)) != 0) {
-			fprintf(stderr, "Seat already reserved\n");
-			pthread_rwlock_unlock(&event->rwlock); /// unlock the event-specific rwlock
-			break;
-		}
+	if (event_list == NULL) {
+		fprintf(stderr, "EMS state must be initialized\n");
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+		return 1;
+	}
+
+	lock_mutex(output_write_mutex, &output_info); /// lock the output stream for writing
 
-		*get_seat_with_delay(event, seat_index(event, row, col)) = reservation_id;
+	if (atomic_load(&event_list->head) == NULL) {
+		write(output_stream, "No events\n", strlen("No events\n"));
+		unlock_mutex(output_write_mutex, &output_info); /// unlock the output stream
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+		return 0;
 	}
 
-	// If the reservation was not successful, free the seats that were reserved.
-	if (i < num_seats) {
-		event->reservations--;
-		for (size_t j = 0; j < i; j++) {
-			*get_seat_with_delay(event, seat_index(event, xs[j], ys[j])) = 0;
-		}
-		return 1;
+	uint64_t output_start = trace_begin();
+	struct ListNode* current = atomic_load(&event_list->head);
+	while (current != NULL) {
+		char* event_id_string = uint_to_string((current->event)->id); /// get the event id as a string
+
+		write(output_stream, "Event: ", strlen("Event: "));
+		write(output_stream, event_id_string, strlen(event_id_string));
+		write(output_stream, "\n", strlen("\n"));
+		current = atomic_load(&current->next);
+		
+		free(event_id_string);
 	}
 
-	pthread_rwlock_unlock(&event->rwlock); /// unlock the event-specific rwlock
+	trace_end(output_start, "output", "LIST output", TRACE_NO_ARG);
+	unlock_mutex(output_write_mutex, &output_info); /// unlock the output stream
+	unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
 
 	return 0;
 }
 
-int ems_show(unsigned int event_id, int output_stream, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
-	pthread_mutex_lock(events_general_mutex); /// lock the general mutex for events (this mutex is used exclusively for manipulating the events list; in addition, each event has its own read-write lock)
+/// Run of consecutive seats with the same reservation, as stored in a state dump.
+typedef struct {
+	uint64_t start; /// Index of the first seat.
+	uint64_t length; /// Number of seats (0 marks the end of the seats of an event).
+	uint32_t reservation_id; /// Reservation id of the seats.
+} seat_run;
+
+/// Writes a run of seats to a state dump.
+/// @return 0 if the run was written successfully, 1 otherwise.
+static int write_run(FILE* file, const seat_run* run) {
+	return fwrite(&run->start, sizeof(run->start), 1, file) != 1 || fwrite(&run->length, sizeof(run->length), 1, file) != 1 ||
+		fwrite(&run->reservation_id, sizeof(run->reservation_id), 1, file) != 1;
+}
+
+/// Reads a run of seats from a state dump.
+/// @return 0 if the run was read successfully, 1 otherwise.
+static int read_run(FILE* file, seat_run* run) {
+	return fread(&run->start, sizeof(run->start), 1, file) != 1 || fread(&run->length, sizeof(run->length), 1, file) != 1 ||
+		fread(&run->reservation_id, sizeof(run->reservation_id), 1, file) != 1;
+}
 
+int ems_save_state(FILE* file) {
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
 		return 1;
 	}
 
-	struct Event* event = get_event_with_delay(event_id);
+	uint64_t num_events = 0;
+	for (struct ListNode* node = atomic_load(&event_list->head); node != NULL; node = atomic_load(&node->next)) {
+		num_events++;
+	}
 
-	if (event == NULL) {
-		fprintf(stderr, "Event not found\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+	if (fwrite(&num_events, sizeof(num_events), 1, file) != 1) {
 		return 1;
 	}
-	
-	pthread_rwlock_rdlock(&event->rwlock); /// lock the event-specific rwlock for reading
-	pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events cause the individual event rwlock is already locked
 
-	pthread_mutex_lock(output_write_mutex); /// lock the output stream for writing
+	for (struct ListNode* node = atomic_load(&event_list->head); node != NULL; node = atomic_load(&node->next)) {
+		struct Event* event = node->event;
+		uint32_t id = event->id;
+		uint64_t rows = event->rows;
+		uint64_t cols = event->cols;
+		uint32_t reservations = atomic_load(&event->reservations);
+
+		if (fwrite(&id, sizeof(id), 1, file) != 1 || fwrite(&rows, sizeof(rows), 1, file) != 1 ||
+				fwrite(&cols, sizeof(cols), 1, file) != 1 || fwrite(&reservations, sizeof(reservations), 1, file) != 1) {
+			return 1;
+		}
 
-	for (size_t i = 1; i <= event->rows; i++) {
-		for (size_t j = 1; j <= event->cols; j++) {
-			unsigned int* seat = get_seat_with_delay(event, seat_index(event, i, j));
-			char* seat_string = uint_to_string(*seat); /// get the seat id as a string
-			
-			write(output_stream, seat_string, strlen(seat_string));
+		/// only the occupied seats are stored, merged into runs (a reservation usually takes consecutive seats)
+		seat_run run = {0, 0, 0};
+		size_t cursor = 0, index;
+		unsigned int reservation_id;
 
-			free(seat_string);
+		while (seatmap_next_occupied(&event->seats, &cursor, &index, &reservation_id)) {
+			if (run.length > 0 && index == run.start + run.length && reservation_id == run.reservation_id) {
+				run.length++;
+				continue;
+			}
 
-			if (j < event->cols) {
-				write(output_stream, " ", strlen(" "));
+			if (run.length > 0 && write_run(file, &run) != 0) {
+				return 1;
 			}
+			run.start = index;
+			run.length = 1;
+			run.reservation_id = reservation_id;
 		}
 
-		write(output_stream, "\n", strlen("\n"));
+		seat_run end = {0, 0, 0};
+		if ((run.length > 0 && write_run(file, &run) != 0) || write_run(file, &end) != 0) {
+			return 1;
+		}
 	}
 
-	pthread_mutex_unlock(output_write_mutex); /// unlock the output stream
-	pthread_rwlock_unlock(&event->rwlock); /// unlock the event-specific rwlock
-
 	return 0;
 }
 
-int ems_list_events(int output_stream, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
-	pthread_mutex_lock(events_general_mutex); /// lock the general mutex for events 
-
+int ems_load_state(FILE* file) {
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
 		return 1;
 	}
 
-	pthread_mutex_lock(output_write_mutex); /// lock the output stream for writing
-
-	if (event_list->head == NULL) {
-		write(output_stream, "No events\n", strlen("No events\n"));
-		pthread_mutex_unlock(output_write_mutex); /// unlock the output stream
-		pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
-		return 0;
+	uint64_t num_events;
+	if (fread(&num_events, sizeof(num_events), 1, file) != 1) {
+		return 1;
 	}
 
-	struct ListNode* current = event_list->head;
-	while (current != NULL) {
-		char* event_id_string = uint_to_string((current->event)->id); /// get the event id as a string
+	for (uint64_t i = 0; i < num_events; i++) {
+		uint32_t id, reservations;
+		uint64_t rows, cols;
 
-		write(output_stream, "Event: ", strlen("Event: "));
-		write(output_stream, event_id_string, strlen(event_id_string));
-		write(output_stream, "\n", strlen("\n"));
-		current = current->next;
-		
-		free(event_id_string);
-	}
+		if (fread(&id, sizeof(id), 1, file) != 1 || fread(&rows, sizeof(rows), 1, file) != 1 ||
+				fread(&cols, sizeof(cols), 1, file) != 1 || fread(&reservations, sizeof(reservations), 1, file) != 1) {
+			return 1;
+		}
 
-	pthread_mutex_unlock(output_write_mutex); /// unlock the output stream
-	pthread_mutex_unlock(events_general_mutex); /// unlock the general mutex for events
+		struct Event* event = new_event(id, (size_t) rows, (size_t) cols);
+		if (event == NULL) {
+			return 1;
+		}
+		atomic_store(&event->reservations, reservations);
+
+		seat_run run;
+		int damaged; /// 1 if the dump ended before the end of the seats of the event
+		while ((damaged = read_run(file, &run)) == 0 && run.length > 0) {
+			if (run.start + run.length > event->seats.num_seats) { /// damaged dump
+				free_event(event);
+				return 1;
+			}
+
+			for (uint64_t seat = run.start; seat < run.start + run.length; seat++) {
+				if (seatmap_set(&event->seats, (size_t) seat, run.reservation_id) != 0) {
+					fprintf(stderr, "Error: Error allocating memory for event data\n");
+					free_event(event);
+					return 1;
+				}
+			}
+		}
+
+		if (damaged || append_to_list(event_list, event) != 0) {
+			free_event(event);
+			return 1;
+		}
+	}
 
 	return 0;
 }
 
 void ems_wait(unsigned int delay_ms) {
-	struct timespec delay = delay_to_timespec(delay_ms);
-	nanosleep(&delay, NULL);
+	vclock_delay(delay_ms);
 }
@@ -2,6 +2,7 @@
 #define EMS_OPERATIONS_H
 
 #include <stddef.h>
+#include <stdio.h>
 #include <pthread.h>
 
 /// Initializes the EMS state.
@@ -9,6 +10,12 @@
 /// @return 0 if the EMS state was initialized successfully, 1 otherwise.
 int ems_init(unsigned int delay_ms);
 
+/// Chooses the concurrency strategy of the operations (the per-event rwlock one is used by default).
+/// @note Must be called before ems_init.
+/// @param name Name of the strategy: "global", "rwlock", "striped" or "lockfree".
+/// @return 0 if the strategy was chosen successfully, 1 otherwise.
+int ems_set_strategy(const char* name);
+
 /// Destroys the EMS state.
 int ems_terminate();
 
@@ -29,6 +36,12 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols, pthread_
 /// @return 0 if the reservation was created successfully, 1 otherwise.
 int ems_reserve(unsigned int event_id, size_t num_seats, size_t *xs, size_t *ys, pthread_mutex_t* events_general_mutex);
 
+/// Deletes the given event. Threads that already found the event can keep using it until their operation ends.
+/// @param event_id Id of the event to delete.
+/// @param events_general_mutex Mutex to safely create events, access the events list, etc.
+/// @return 0 if the event was deleted successfully, 1 otherwise.
+int ems_delete(unsigned int event_id, pthread_mutex_t* events_general_mutex);
+
 /// Prints the given event.
 /// @param event_id Id of the event to print.
 /// @param output_fd file descriptor to write the event.
@@ -44,6 +57,18 @@ int ems_show(unsigned int event_id, int output_fd, pthread_mutex_t* output_write
 /// @return 0 if the events were printed successfully, 1 otherwise.
 int ems_list_events(int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex);
 
+/// Writes a compact dump of the events and their reservations (only the occupied seats are stored).
+/// @note Must be called while no other operation is running.
+/// @param file File to write the dump to.
+/// @return 0 if the dump was written successfully, 1 otherwise.
+int ems_save_state(FILE* file);
+
+/// Adds the events of a dump written by ems_save_state to the EMS state.
+/// @note Must be called while no other operation is running.
+/// @param file File to read the dump from.
+/// @return 0 if the dump was read successfully, 1 otherwise (some events may have been added).
+int ems_load_state(FILE* file);
+
 /// Waits for a given amount of time.
 /// @param delay_us Delay in milliseconds.
 void ems_wait(unsigned int delay_ms);
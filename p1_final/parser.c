@@ -1,44 +1,110 @@
 #include "parser.h"
 
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-#include "constants.h"
+#include "reserve_decoder.h"
+
+#define INITIAL_COORDS_CAPACITY 256 /// coordinates that fit in a new parser scratch
+#define INITIAL_LINE_CAPACITY 8192 /// bytes of a line that fit in a new parser scratch
 
 static int read_uint(int fd, unsigned int *value, char *next) {
-	char buf[16];
-	memset(buf, 0, 16);
+	unsigned long long ull = 0;
 
-	int i = 0;
 	while (1) {
-		if (read(fd, buf + i, 1) == 0) {
+		char ch;
+		if (read(fd, &ch, 1) != 1) {
 			*next = '\0';
 			break;
 		}
 
-		*next = buf[i];
+		*next = ch;
 
-		if (buf[i] > '9' || buf[i] < '0') {
-			buf[i] = '\0';
+		if (ch > '9' || ch < '0') {
 			break;
 		}
 
-		i++;
+		if (ull <= UINT_MAX) { /// the digits after a value too large are read, but it stays too large
+			ull = ull * 10 + (unsigned long long)(ch - '0');
+		}
 	}
 
-	unsigned long ul = strtoul(buf, NULL, 10);
-
-	if (ul > UINT_MAX) {
+	if (ull > UINT_MAX) {
 		return 1;
 	}
 
-	*value = (unsigned int)ul;
+	*value = (unsigned int)ull;
 
 	return 0;
 }
 
+/// Makes room for at least the given number of coordinates in a parser scratch.
+static void reserve_coords(struct ParserScratch *scratch, size_t num_coords) {
+	if (num_coords <= scratch->coords_capacity) {
+		return;
+	}
+
+	size_t capacity = scratch->coords_capacity == 0 ? INITIAL_COORDS_CAPACITY : scratch->coords_capacity;
+	while (capacity < num_coords) {
+		capacity *= 2;
+	}
+
+	size_t *xs = realloc(scratch->xs, capacity * sizeof(size_t));
+	if (xs != NULL) {
+		scratch->xs = xs;
+	}
+	size_t *ys = realloc(scratch->ys, capacity * sizeof(size_t));
+	if (ys != NULL) {
+		scratch->ys = ys;
+	}
+
+	if (xs == NULL || ys == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the coordinates failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	scratch->coords_capacity = capacity;
+}
+
+/// Makes room for a line of at least the given number of bytes in a parser scratch (keeping its contents).
+static void reserve_line(struct ParserScratch *scratch, size_t length) {
+	if (length <= scratch->line_capacity) {
+		return;
+	}
+
+	size_t capacity = scratch->line_capacity == 0 ? INITIAL_LINE_CAPACITY : scratch->line_capacity;
+	while (capacity < length) {
+		capacity *= 2;
+	}
+
+	char *line = realloc(scratch->line, capacity + RESERVE_DECODER_PADDING);
+	if (line != NULL) {
+		scratch->line = line;
+	}
+	uint64_t *digit_mask = realloc(scratch->digit_mask, RESERVE_DECODER_MASK_WORDS(capacity) * sizeof(uint64_t));
+	if (digit_mask != NULL) {
+		scratch->digit_mask = digit_mask;
+	}
+
+	if (line == NULL || digit_mask == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the line buffer failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	scratch->line_capacity = capacity;
+}
+
+void parser_scratch_free(struct ParserScratch *scratch) {
+	free(scratch->xs);
+	free(scratch->ys);
+	free(scratch->line);
+	free(scratch->digit_mask);
+	memset(scratch, 0, sizeof(struct ParserScratch));
+}
+
 void cleanup(int fd) {
 	char ch;
 	while (read(fd, &ch, 1) == 1 && ch != '\n');
@@ -75,6 +141,14 @@ enum Command get_next(int fd) {
 
 			return CMD_SHOW;
 
+		case 'D':
+			if (read(fd, buf + 1, 6) != 6 || strncmp(buf, "DELETE ", 7) != 0) {
+				cleanup(fd);
+				return CMD_INVALID;
+			}
+
+			return CMD_DELETE;
+
 		case 'L':
 			if (read(fd, buf + 1, 3) != 3 || strncmp(buf, "LIST", 4) != 0) {
 				cleanup(fd);
@@ -160,7 +234,8 @@ int parse_create(int fd, unsigned int *event_id, size_t *num_rows, size_t *num_c
 	return 0;
 }
 
-size_t parse_reserve(int fd, size_t max, unsigned int *event_id, size_t *xs, size_t *ys) {
+/// Parses the arguments of a RESERVE command reading one byte at a time (used when the line can't be read ahead).
+static size_t parse_reserve_bytes(int fd, unsigned int *event_id, struct ParserScratch *scratch) {
 	char ch;
 
 	if (read_uint(fd, event_id, &ch) != 0 || ch != ' ') {
@@ -174,25 +249,27 @@ size_t parse_reserve(int fd, size_t max, unsigned int *event_id, size_t *xs, siz
 	}
 
 	size_t num_coords = 0;
-	while (num_coords < max) {
+	while (1) {
 		if (read(fd, &ch, 1) != 1 || ch != '(') {
 			cleanup(fd);
 			return 0;
 		}
 
+		reserve_coords(scratch, num_coords + 1);
+
 		unsigned int x;
 		if (read_uint(fd, &x, &ch) != 0 || ch != ',') {
 			cleanup(fd);
 			return 0;
 		}
-		xs[num_coords] = (size_t)x;
+		scratch->xs[num_coords] = (size_t)x;
 
 		unsigned int y;
 		if (read_uint(fd, &y, &ch) != 0 || ch != ')') {
 			cleanup(fd);
 			return 0;
 		}
-		ys[num_coords] = (size_t)y;
+		scratch->ys[num_coords] = (size_t)y;
 
 		num_coords++;
 
@@ -206,14 +283,57 @@ size_t parse_reserve(int fd, size_t max, unsigned int *event_id, size_t *xs, siz
 		}
 	}
 
-	if (num_coords == max) {
+	if (read(fd, &ch, 1) != 1 || (ch != '\n' && ch != '\0')) {
 		cleanup(fd);
 		return 0;
 	}
 
-	if (read(fd, &ch, 1) != 1 || (ch != '\n' && ch != '\0')) {
+	return num_coords;
+}
+
+size_t parse_reserve(int fd, unsigned int *event_id, struct ParserScratch *scratch) {
+	off_t offset = lseek(fd, 0, SEEK_CUR);
+
+	if (offset == -1) { /// pipes and FIFOs can't be read ahead
+		return parse_reserve_bytes(fd, event_id, scratch);
+	}
+
+	size_t length = 0;
+	char *newline = NULL;
+
+	reserve_line(scratch, INITIAL_LINE_CAPACITY);
+
+	while (newline == NULL) { /// read until the end of the line (growing the buffer) or the end of the file
+		ssize_t bytes_read = pread(fd, scratch->line + length, scratch->line_capacity - length, offset + (off_t) length);
+		if (bytes_read == -1) {
+			return parse_reserve_bytes(fd, event_id, scratch);
+		}
+
+		newline = memchr(scratch->line + length, '\n', (size_t) bytes_read);
+		length += (size_t) bytes_read;
+
+		if (newline == NULL && length < scratch->line_capacity) { /// end of the file
+			break;
+		}
+		if (newline == NULL) {
+			reserve_line(scratch, length * 2);
+		}
+	}
+
+	if (newline != NULL) { /// the rest of the input doesn't matter
+		length = (size_t) (newline - scratch->line) + 1;
+	}
+
+	memset(scratch->line + length, 0, RESERVE_DECODER_PADDING);
+	reserve_coords(scratch, RESERVE_DECODER_MAX_COORDS(length));
+
+	size_t consumed;
+	size_t num_coords = decode_reserve(scratch->line, length, scratch->digit_mask, event_id, scratch->xs, scratch->ys, &consumed);
+
+	lseek(fd, offset + (off_t) consumed, SEEK_SET); /// leave the fd where the byte by byte parser would have left it
+
+	if (num_coords == 0) {
 		cleanup(fd);
-		return 0;
 	}
 
 	return num_coords;
@@ -230,6 +350,17 @@ int parse_show(int fd, unsigned int *event_id) {
 	return 0;
 }
 
+int parse_delete(int fd, unsigned int *event_id) {
+	char ch;
+
+	if (read_uint(fd, event_id, &ch) != 0 || (ch != '\n' && ch != '\0')) {
+		cleanup(fd);
+		return 1;
+	}
+
+	return 0;
+}
+
 int parse_wait(int fd, unsigned int *delay, unsigned int *thread_id) {
 	char ch;
 
@@ -2,12 +2,14 @@
 #define EMS_PARSER_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /// Enumerates the possible commands read from the input file with get_next().
 enum Command {
 	CMD_CREATE,
 	CMD_RESERVE,
 	CMD_SHOW,
+	CMD_DELETE,
 	CMD_LIST_EVENTS,
 	CMD_BARRIER,
 	CMD_WAIT,
@@ -17,6 +19,22 @@ enum Command {
 	EOC  /// End of commands
 };
 
+/// Buffers used to parse RESERVE commands, which grow as needed and are reused between commands (one per thread).
+/// Must be zero-initialized before the first use.
+struct ParserScratch {
+	size_t *xs; /// Rows of the seats of the last RESERVE parsed.
+	size_t *ys; /// Columns of the seats of the last RESERVE parsed.
+	size_t coords_capacity; /// Number of entries of xs and ys.
+
+	char *line; /// Line being decoded (followed by the padding needed by the decoder).
+	uint64_t *digit_mask; /// Digit mask of the line being decoded.
+	size_t line_capacity; /// Number of bytes of the line that fit in the buffer.
+};
+
+/// Frees the buffers of a parser scratch (it can be used again afterwards).
+/// @param scratch Parser scratch to free.
+void parser_scratch_free(struct ParserScratch *scratch);
+
 /// Reads a line and returns the corresponding command.
 /// @param fd File descriptor to read from.
 /// @return The command read.
@@ -30,14 +48,12 @@ enum Command get_next(int fd);
 /// @return 0 if the command was parsed successfully, 1 otherwise.
 int parse_create(int fd, unsigned int *event_id, size_t *num_rows, size_t *num_cols);
 
-/// Parses a RESERVE command.
+/// Parses a RESERVE command (with any number of coordinates).
 /// @param fd File descriptor to read from.
-/// @param max Maximum number of coordinates to read.
 /// @param event_id Pointer to the variable to store the event ID in.
-/// @param xs Pointer to the array to store the X coordinates in.
-/// @param ys Pointer to the array to store the Y coordinates in.
+/// @param scratch Buffers of the calling thread. The coordinates are stored in scratch->xs and scratch->ys.
 /// @return Number of coordinates read. 0 on failure.
-size_t parse_reserve(int fd, size_t max, unsigned int *event_id, size_t *xs, size_t *ys);
+size_t parse_reserve(int fd, unsigned int *event_id, struct ParserScratch *scratch);
 
 /// Parses a SHOW command.
 /// @param fd File descriptor to read from.
@@ -45,6 +61,12 @@ size_t parse_reserve(int fd, size_t max, unsigned int *event_id, size_t *xs, siz
 /// @return 0 if the command was parsed successfully, 1 otherwise.
 int parse_show(int fd, unsigned int *event_id);
 
+/// Parses a DELETE command.
+/// @param fd File descriptor to read from.
+/// @param event_id Pointer to the variable to store the event ID in.
+/// @return 0 if the command was parsed successfully, 1 otherwise.
+int parse_delete(int fd, unsigned int *event_id);
+
 /// Parses a WAIT command.
 /// @param fd File descriptor to read from.
 /// @param delay Pointer to the variable to store the wait delay in.
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../operations.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "EMSCKPT1" /// first bytes of a checkpoint file (the version of the format is the last one)
+#define CHECKPOINT_TMP_EXTENSION ".tmp" /// a checkpoint is written next to the previous one and renamed over it
+
+/// Gets the time of the monotonic clock.
+/// @return Time in nanoseconds.
+static uint64_t monotonic_ns() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+/// Writes a checkpoint file, replacing the previous one only once the new one is complete.
+/// @return 0 if the checkpoint was written successfully, 1 otherwise.
+static int write_checkpoint(const char* filename, const checkpoint_position* position) {
+	char* tmp_filename = malloc(strlen(filename) + strlen(CHECKPOINT_TMP_EXTENSION) + 1);
+	if (tmp_filename == NULL) {
+		return 1;
+	}
+	strcpy(tmp_filename, filename);
+	strcat(tmp_filename, CHECKPOINT_TMP_EXTENSION);
+
+	FILE* file = fopen(tmp_filename, "wb");
+	if (file == NULL) {
+		free(tmp_filename);
+		return 1;
+	}
+
+	int failed = fwrite(CHECKPOINT_MAGIC, strlen(CHECKPOINT_MAGIC), 1, file) != 1 || fwrite(position, sizeof(*position), 1, file) != 1 ||
+		ems_save_state(file) != 0 || fflush(file) != 0 || fsync(fileno(file)) != 0;
+
+	if (fclose(file) != 0 || failed || rename(tmp_filename, filename) != 0) {
+		remove(tmp_filename);
+		free(tmp_filename);
+		return 1;
+	}
+
+	free(tmp_filename);
+	return 0;
+}
+
+void checkpoint_at_barrier(checkpoint_schedule* schedule, int input_fd, int next_line_num, unsigned long long barrier_time) {
+	uint64_t start = monotonic_ns();
+	if (start < schedule->next_checkpoint_ns) {
+		return;
+	}
+
+	checkpoint_position position;
+	struct stat out_stat;
+	off_t input_offset = lseek(input_fd, 0, SEEK_CUR);
+
+	/// the output must be on disk before a checkpoint that counts on it
+	if (input_offset == -1 || fdatasync(schedule->output_fd) != 0 || fstat(schedule->output_fd, &out_stat) != 0) {
+		fprintf(stderr, "Error: Unable to write the checkpoint: %s\n", schedule->filename);
+		return;
+	}
+
+	position.input_hash = schedule->input_hash;
+	position.input_offset = (uint64_t) input_offset;
+	position.line_num = (uint64_t) next_line_num;
+	position.out_length = (uint64_t) out_stat.st_size;
+	position.barrier_time = barrier_time;
+
+	if (write_checkpoint(schedule->filename, &position) != 0) {
+		fprintf(stderr, "Error: Unable to write the checkpoint: %s\n", schedule->filename);
+	}
+
+	uint64_t end = monotonic_ns();
+	uint64_t wait_ns = (end - start) * CHECKPOINT_OVERHEAD_FACTOR;
+	if (wait_ns < CHECKPOINT_INTERVAL_MS * 1000000ULL) {
+		wait_ns = CHECKPOINT_INTERVAL_MS * 1000000ULL;
+	}
+	schedule->next_checkpoint_ns = end + wait_ns;
+}
+
+int checkpoint_restore(const char* filename, uint64_t input_hash, const char* out_filename, checkpoint_position* position) {
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL) { /// the last run finished (or never took a checkpoint)
+		return 1;
+	}
+
+	char magic[sizeof(CHECKPOINT_MAGIC)] = {0};
+	checkpoint_position saved;
+	struct stat out_stat;
+
+	if (fread(magic, strlen(CHECKPOINT_MAGIC), 1, file) != 1 || strcmp(magic, CHECKPOINT_MAGIC) != 0 ||
+			fread(&saved, sizeof(saved), 1, file) != 1) {
+		fclose(file);
+		return -1;
+	}
+
+	/// a checkpoint of another version of the file, or whose output was lost, can't be continued
+	if (saved.input_hash != input_hash || stat(out_filename, &out_stat) != 0 || (uint64_t) out_stat.st_size < saved.out_length) {
+		fclose(file);
+		return 1;
+	}
+
+	int result = ems_load_state(file) == 0 ? 0 : -1;
+	fclose(file);
+
+	*position = saved;
+	return result;
+}
@@ -0,0 +1,45 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#define CHECKPOINT_EXTENSION ".ckpt" /// checkpoint of a .jobs file being processed (removed once the file is done)
+#define CHECKPOINT_INTERVAL_MS 1000 /// minimum time between two checkpoints of a file
+#define CHECKPOINT_OVERHEAD_FACTOR 20 /// the time until the next checkpoint is at least this many times the cost of the last one (at most 5% overhead)
+
+/// Where the processing of a .jobs file was when a checkpoint was taken (always right after a BARRIER).
+typedef struct {
+	uint64_t input_hash; /// Hash of the .jobs file (checkpoints of other versions of the file are ignored).
+	uint64_t input_offset; /// Byte offset of the line after the BARRIER.
+	uint64_t line_num; /// Number of the line after the BARRIER.
+	uint64_t out_length; /// Length of the .out file.
+	uint64_t barrier_time; /// Logical time at which the BARRIER opened (virtual time mode).
+} checkpoint_position;
+
+/// When and where the checkpoints of a .jobs file are written.
+typedef struct {
+	char* filename; /// Name of the checkpoint file.
+	uint64_t input_hash; /// Hash of the .jobs file.
+	int output_fd; /// File descriptor of the .out file.
+	uint64_t next_checkpoint_ns; /// Earliest time for the next checkpoint (monotonic clock).
+} checkpoint_schedule;
+
+/// Takes a checkpoint at a BARRIER if enough time passed since the last one.
+/// @note Must be called by the last thread to reach the BARRIER, while all the others wait in it.
+/// @param schedule Checkpoint schedule of the file.
+/// @param input_fd File descriptor of the .jobs file of the calling thread, right after the BARRIER line.
+/// @param next_line_num Number of the line after the BARRIER.
+/// @param barrier_time Logical time at which the BARRIER opens (virtual time mode).
+void checkpoint_at_barrier(checkpoint_schedule* schedule, int input_fd, int next_line_num, unsigned long long barrier_time);
+
+/// Restores the EMS state from the checkpoint of a file.
+/// @note Must be called before the threads that process the file are created.
+/// @param filename Name of the checkpoint file.
+/// @param input_hash Hash of the .jobs file.
+/// @param out_filename Name of the .out file (it must still have the checkpointed output).
+/// @param position Pointer to the variable to store the position of the checkpoint in.
+/// @return 0 if the state was restored, 1 if there is no usable checkpoint (nothing is restored), -1 if the checkpoint is damaged
+/// (the state may have been partially restored).
+int checkpoint_restore(const char* filename, uint64_t input_hash, const char* out_filename, checkpoint_position* position);
+
+#endif // CHECKPOINT_H
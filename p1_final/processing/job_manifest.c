@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <sys/stat.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../utils/hash.h"
+#include "job_manifest.h"
+
+#define MANIFEST_TMP_FILENAME ".ems_manifest.tmp"
+
+/// Finds the entry of a file in the manifest.
+/// @return Pointer to the entry, NULL if the file is not in the manifest.
+static manifest_entry* find_entry(const job_manifest* manifest, const char* name) {
+	for (size_t i = 0; i < manifest->count; i++) {
+		if (strcmp(manifest->entries[i].name, name) == 0) {
+			return &manifest->entries[i];
+		}
+	}
+
+	return NULL;
+}
+
+/// Adds an entry to the manifest (the name is copied).
+/// @return Pointer to the new entry, NULL on failure.
+static manifest_entry* add_entry(job_manifest* manifest, const manifest_entry* entry) {
+	if (manifest->count == manifest->capacity) {
+		size_t capacity = manifest->capacity == 0 ? 16 : manifest->capacity * 2;
+		manifest_entry* entries = realloc(manifest->entries, capacity * sizeof(manifest_entry));
+		if (entries == NULL) {
+			return NULL;
+		}
+		manifest->entries = entries;
+		manifest->capacity = capacity;
+	}
+
+	char* name = strdup(entry->name);
+	if (name == NULL) {
+		return NULL;
+	}
+
+	manifest_entry* new_entry = &manifest->entries[manifest->count++];
+	*new_entry = *entry;
+	new_entry->name = name;
+	return new_entry;
+}
+
+int manifest_load(job_manifest* manifest) {
+	manifest->entries = NULL;
+	manifest->count = 0;
+	manifest->capacity = 0;
+
+	FILE* file = fopen(MANIFEST_FILENAME, "r");
+	if (file == NULL) { /// first run in this directory
+		return 0;
+	}
+
+	char* line = NULL;
+	size_t line_capacity = 0;
+	ssize_t length;
+
+	while ((length = getline(&line, &line_capacity, file)) != -1) {
+		manifest_entry entry;
+		int name_offset = 0;
+
+		if (length > 0 && line[length - 1] == '\n') {
+			line[length - 1] = '\0';
+		}
+
+		/// <hash> <delay> <threads> <adaptive> <out size> <out mtime sec> <out mtime nsec> <name>
+		if (sscanf(line, "%" SCNx64 " %u %d %d %lld %lld %lld %n", &entry.hash, &entry.delay, &entry.number_of_threads,
+				&entry.adaptive_threads, &entry.out_size, &entry.out_mtime_sec, &entry.out_mtime_nsec, &name_offset) != 7 || name_offset == 0) {
+			continue; /// ignore damaged lines (the file will just be processed again)
+		}
+
+		entry.name = line + name_offset;
+		if (add_entry(manifest, &entry) == NULL) {
+			free(line);
+			fclose(file);
+			manifest_free(manifest);
+			return 1;
+		}
+	}
+
+	free(line);
+	fclose(file);
+	return 0;
+}
+
+int manifest_save(const job_manifest* manifest) {
+	FILE* file = fopen(MANIFEST_TMP_FILENAME, "w");
+	if (file == NULL) {
+		return 1;
+	}
+
+	for (size_t i = 0; i < manifest->count; i++) {
+		const manifest_entry* entry = &manifest->entries[i];
+		fprintf(file, "%016" PRIx64 " %u %d %d %lld %lld %lld %s\n", entry->hash, entry->delay, entry->number_of_threads,
+			entry->adaptive_threads, entry->out_size, entry->out_mtime_sec, entry->out_mtime_nsec, entry->name);
+	}
+
+	if (fclose(file) != 0) {
+		remove(MANIFEST_TMP_FILENAME);
+		return 1;
+	}
+
+	return rename(MANIFEST_TMP_FILENAME, MANIFEST_FILENAME) != 0; /// an interrupted save never leaves a truncated manifest
+}
+
+void manifest_free(job_manifest* manifest) {
+	for (size_t i = 0; i < manifest->count; i++) {
+		free(manifest->entries[i].name);
+	}
+
+	free(manifest->entries);
+	manifest->entries = NULL;
+	manifest->count = 0;
+	manifest->capacity = 0;
+}
+
+int manifest_is_unchanged(const job_manifest* manifest, const manifest_entry* expected, const char* out_filename) {
+	const manifest_entry* entry = find_entry(manifest, expected->name);
+	struct stat out_stat;
+
+	if (entry == NULL || entry->hash != expected->hash || entry->delay != expected->delay ||
+			entry->number_of_threads != expected->number_of_threads || entry->adaptive_threads != expected->adaptive_threads) {
+		return 0;
+	}
+
+	if (stat(out_filename, &out_stat) != 0) { /// the output was removed
+		return 0;
+	}
+
+	/// the output must be exactly the one produced by the recorded run
+	return entry->out_size == (long long) out_stat.st_size && entry->out_mtime_sec == (long long) out_stat.st_mtim.tv_sec &&
+		entry->out_mtime_nsec == (long long) out_stat.st_mtim.tv_nsec;
+}
+
+int manifest_record(job_manifest* manifest, const manifest_entry* entry, const char* out_filename) {
+	struct stat out_stat;
+	if (stat(out_filename, &out_stat) != 0) {
+		return 1;
+	}
+
+	manifest_entry* recorded = find_entry(manifest, entry->name);
+	if (recorded == NULL) {
+		recorded = add_entry(manifest, entry);
+		if (recorded == NULL) {
+			return 1;
+		}
+	} else {
+		char* name = recorded->name;
+		*recorded = *entry;
+		recorded->name = name;
+	}
+
+	recorded->out_size = (long long) out_stat.st_size;
+	recorded->out_mtime_sec = (long long) out_stat.st_mtim.tv_sec;
+	recorded->out_mtime_nsec = (long long) out_stat.st_mtim.tv_nsec;
+	return 0;
+}
+
+/// Data shared by the threads that hash the files.
+typedef struct {
+	char** filenames; /// Names of the files to hash.
+	size_t num_files; /// Number of files.
+	uint64_t* hashes; /// Hash of each file.
+	int* ok; /// 1 for each file that was hashed successfully.
+	atomic_size_t next_file; /// Index of the next file to hash (each thread takes the next one when it finishes one).
+} hashing_work;
+
+/// Thread function that hashes files until there are none left.
+/// @param args Pointer to the shared hashing_work.
+static void* hash_files_thread(void* args) {
+	hashing_work* work = (hashing_work*) args;
+	size_t i;
+
+	while ((i = atomic_fetch_add(&work->next_file, 1)) < work->num_files) {
+		work->ok[i] = hash_file(work->filenames[i], &work->hashes[i]) == 0;
+	}
+
+	return NULL;
+}
+
+void hash_files_in_parallel(char** filenames, size_t num_files, uint64_t* hashes, int* ok, int number_of_threads) {
+	hashing_work work = {filenames, num_files, hashes, ok, 0};
+	atomic_init(&work.next_file, 0);
+
+	if (number_of_threads < 1) {
+		number_of_threads = 1;
+	}
+	if ((size_t) number_of_threads > num_files) {
+		number_of_threads = (int) num_files;
+	}
+
+	pthread_t* threads = malloc(sizeof(pthread_t) * (size_t) number_of_threads);
+	int created = 0;
+
+	if (threads != NULL) {
+		for (int i = 0; i < number_of_threads; i++) {
+			if (pthread_create(&threads[created], NULL, hash_files_thread, &work) == 0) {
+				created++;
+			}
+		}
+	}
+
+	hash_files_thread(&work); /// the calling thread helps too (and does everything if no thread could be created)
+
+	for (int i = 0; i < created; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	free(threads);
+}
@@ -0,0 +1,64 @@
+#ifndef JOB_MANIFEST_H
+#define JOB_MANIFEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MANIFEST_FILENAME ".ems_manifest" /// name of the manifest inside the processed directory (it must not contain the ".jobs" extension)
+
+/// What is recorded about a .jobs file after it was processed successfully.
+typedef struct {
+	char* name; /// Name of the .jobs file.
+	uint64_t hash; /// Hash of the contents of the .jobs file.
+	unsigned int delay; /// State access delay used.
+	int number_of_threads; /// Number of threads given in the command line.
+	int adaptive_threads; /// 1 if the adaptive thread count was used.
+	long long out_size; /// Size of the .out file produced.
+	long long out_mtime_sec; /// Modification time of the .out file produced (seconds).
+	long long out_mtime_nsec; /// Modification time of the .out file produced (nanoseconds).
+} manifest_entry;
+
+/// Entries of the manifest of a directory.
+typedef struct {
+	manifest_entry* entries; /// Array of entries.
+	size_t count; /// Number of entries.
+	size_t capacity; /// Allocated number of entries.
+} job_manifest;
+
+/// Loads the manifest of the current directory (an empty manifest if it doesn't exist).
+/// @param manifest Pointer to the manifest to fill.
+/// @return 0 if the manifest was loaded successfully, 1 otherwise.
+int manifest_load(job_manifest* manifest);
+
+/// Saves the manifest of the current directory (replacing the previous one atomically).
+/// @param manifest Manifest to save.
+/// @return 0 if the manifest was saved successfully, 1 otherwise.
+int manifest_save(const job_manifest* manifest);
+
+/// Frees the memory used by a manifest.
+/// @param manifest Manifest to free.
+void manifest_free(job_manifest* manifest);
+
+/// Checks if a .jobs file can be skipped: its hash and settings match the manifest and its .out is intact.
+/// @param manifest Manifest of the directory.
+/// @param expected Entry with the name, hash and settings of the file to process.
+/// @param out_filename Name of the .out file of the .jobs file.
+/// @return 1 if the file can be skipped, 0 otherwise.
+int manifest_is_unchanged(const job_manifest* manifest, const manifest_entry* expected, const char* out_filename);
+
+/// Records a .jobs file that was processed successfully (with the current state of its .out file).
+/// @param manifest Manifest to update.
+/// @param entry Entry with the name, hash and settings of the processed file.
+/// @param out_filename Name of the .out file of the .jobs file.
+/// @return 0 if the entry was recorded successfully, 1 otherwise.
+int manifest_record(job_manifest* manifest, const manifest_entry* entry, const char* out_filename);
+
+/// Hashes the contents of several files, using up to the given number of threads.
+/// @param filenames Names of the files to hash.
+/// @param num_files Number of files.
+/// @param hashes Array to store the hash of each file in.
+/// @param ok Array to store 1 for each file that was hashed successfully, 0 otherwise.
+/// @param number_of_threads Maximum number of threads to use.
+void hash_files_in_parallel(char** filenames, size_t num_files, uint64_t* hashes, int* ok, int number_of_threads);
+
+#endif // JOB_MANIFEST_H
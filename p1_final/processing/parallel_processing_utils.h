@@ -4,6 +4,19 @@
 #include <pthread.h>
 #include <semaphore.h>
 
+#include "checkpoint.h"
+
+/// Message written for the HELP command.
+#define HELP_MESSAGE "Available commands:\n" \
+                     "  CREATE <event_id> <num_rows> <num_columns>\n" \
+                     "  RESERVE <event_id> [(<x1>,<y1>) (<x2>,<y2>) ...]\n" \
+                     "  SHOW <event_id>\n" \
+                     "  DELETE <event_id>\n" \
+                     "  LIST\n" \
+                     "  WAIT <delay_ms> [thread_id]\n" \
+                     "  BARRIER\n" \
+                     "  HELP\n"
+
 /// Data type used to store the shared data between threads for synchronization purposes.
 typedef struct {
     pthread_mutex_t output_write_mutex; /// Mutex to safely write to the output file descriptor.
@@ -14,6 +27,10 @@ typedef struct {
     sem_t barrier_sem_2; /// Component of the barrier implementation.
     sem_t barrier_sem_1; /// Component of the barrier implementation.
     int blocked_threads_counter; /// Number of threads blocked in the barrier.
+    unsigned long long barrier_time; /// Latest logical time of the threads that reached a barrier (virtual time mode).
+    unsigned long long makespan; /// Latest logical time of the threads that finished (virtual time mode).
+
+    checkpoint_schedule* checkpoint; /// Checkpoints taken at the barriers, NULL if checkpoints are disabled.
 } thread_shared_data;
 
 
@@ -23,6 +40,7 @@ typedef struct {
     int thread_id; /// Thread id.
 
     int input_fd; /// Input file descriptor.
+    int first_line; /// Number of the line the input file descriptor is at (1, unless resuming from a checkpoint).
     int output_fd; /// Output file descriptor.
     
     thread_shared_data* shared_data; /// Shared data between threads for synchronization purposes.
@@ -1,6 +1,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
 
 #include <unistd.h>
 #include <dirent.h> /// for directory related functions
@@ -9,33 +14,81 @@
 #include <sys/stat.h> /// permission-related constants
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/inotify.h>
+#include <poll.h>
 
 #include <pthread.h>
 #include <semaphore.h> 
 
 #include "../operations.h"
 #include "../utils/utils.h"
+#include "../utils/hash.h"
 #include "../parser.h"
-#include "../constants.h"
+#include "../vclock.h"
+#include "../instrumentation/trace.h"
 #include "processing.h"
 #include "parallel_processing_utils.h"
+#include "thread_cost_model.h"
+#include "job_manifest.h"
+#include "checkpoint.h"
 
 #define EXTENSION_TO_PROCESS ".jobs"
 #define OUTPUT_EXTENSION ".out"
+#define WATCH_DEBOUNCE_MS 200 /// a new file is only processed after it has been quiet for this long (writers may close it several times)
+#define WATCH_REAP_INTERVAL_MS 100 /// how often finished child processes are collected while watching
+#define TRACE_EXTENSION ".trace.json"
+
+static thread_cost_model cost_model; /// calibrated once at startup (and inherited by the child processes) when the adaptive mode is enabled
+
+/// Records the span of a command processed by the calling thread in the trace.
+/// @param start Start of the span (before the command was parsed).
+/// @param command The command.
+/// @param event_id Event id of the command (if it has one).
+static void trace_command(uint64_t start, int command, unsigned int event_id) {
+	switch (command) {
+		case CMD_CREATE:
+			trace_end(start, "command", "CREATE", event_id);
+		break;
+
+		case CMD_RESERVE:
+			trace_end(start, "command", "RESERVE", event_id);
+		break;
+
+		case CMD_SHOW:
+			trace_end(start, "command", "SHOW", event_id);
+		break;
+
+		case CMD_DELETE:
+			trace_end(start, "command", "DELETE", event_id);
+		break;
+
+		case CMD_LIST_EVENTS:
+			trace_end(start, "command", "LIST", TRACE_NO_ARG);
+		break;
+
+		default:
+			/// WAIT and BARRIER are traced where the threads actually wait, the others are not worth a span
+		break;
+	}
+}
 
 void* process_file(void* args) {
 	thread_args* args_data = (thread_args*) args;
+	trace_thread_start(args_data->thread_id);
 
-	unsigned int event_id, delay;
+	unsigned int event_id = 0, delay; /// event_id is only set by the commands that parse one
 	size_t num_rows, num_columns, num_coords;
-	size_t xs[MAX_RESERVATION_SIZE], ys[MAX_RESERVATION_SIZE];
+	struct ParserScratch scratch = {0}; /// coordinates of the RESERVE commands (reused between them)
 	
-	int line_num = 1; /// the line number which is currently being read
+	int line_num = args_data->first_line; /// the line number which is currently being read
+	vclock_advance_to(args_data->shared_data->barrier_time); /// a resumed file continues from the time of its checkpoint
 	int command; /// the command read from the input fd
 	int to_continue = 1; /// indicates if the while loop has finished or not
 	
 	while (to_continue) {
+		uint64_t command_start = trace_begin();
 		command = get_next(args_data->input_fd);
+		event_id = 0; /// not left over from the previous command (e.g. when the parsing fails)
 		
 		/// check if the current line should be processed by this thread or not
 		int should_process = (line_num % args_data->number_of_threads == args_data->thread_id) || (line_num % args_data->number_of_threads == 0 && args_data->thread_id == args_data->number_of_threads);
@@ -58,13 +111,13 @@ void* process_file(void* args) {
 
 			case CMD_RESERVE:
 				if(should_process) {
-					num_coords = parse_reserve(args_data->input_fd, MAX_RESERVATION_SIZE, &event_id, xs, ys);
+					num_coords = parse_reserve(args_data->input_fd, &event_id, &scratch);
 
 					if (num_coords == 0) {
 						fprintf(stderr, "Invalid command. See HELP for usage\n");
 						break;
 					}
-					if (ems_reserve(event_id, num_coords, xs, ys, &args_data->shared_data->events_general_mutex)) {
+					if (ems_reserve(event_id, num_coords, scratch.xs, scratch.ys, &args_data->shared_data->events_general_mutex)) {
 						fprintf(stderr, "Failed to reserve seats\n");
 					}
 				} else {
@@ -86,6 +139,20 @@ void* process_file(void* args) {
 				}
 			break;
 
+			case CMD_DELETE:
+				if(should_process) {
+					if (parse_delete(args_data->input_fd, &event_id) != 0) {
+						fprintf(stderr, "Invalid command. See HELP for usage\n");
+						break;
+					}
+					if (ems_delete(event_id, &args_data->shared_data->events_general_mutex)) {
+						fprintf(stderr, "Failed to delete event\n");
+					}
+				} else {
+					cleanup(args_data->input_fd); /// pass to the next line
+				}
+			break;
+
 			case CMD_LIST_EVENTS:
 				if (should_process && ems_list_events(args_data->output_fd, &args_data->shared_data->output_write_mutex, &args_data->shared_data->events_general_mutex)) {
 					fprintf(stderr, "Failed to list events\n");
@@ -102,9 +169,11 @@ void* process_file(void* args) {
 					if (!have_thread_id) { /// if the command doesn't have a specified thread id all threads will execute it
 						fprintf(stdout, "Waiting...\n");
 						ems_wait(delay);
+						trace_end(command_start, "command", "WAIT", TRACE_NO_ARG);
 					} else if ((int) parsed_thread_id == args_data->thread_id) { /// if the command has a thread id only the specified thread will execute it
 						fprintf(stdout, "Waiting...\n");
 						ems_wait(delay);
+						trace_end(command_start, "command", "WAIT", TRACE_NO_ARG);
 					}
 				}
 			}
@@ -118,16 +187,7 @@ void* process_file(void* args) {
 
 			case CMD_HELP:
 				if (should_process) {
-					const char* help_message = "Available commands:\n"
-												"  CREATE <event_id> <num_rows> <num_columns>\n"
-												"  RESERVE <event_id> [(<x1>,<y1>) (<x2>,<y2>) ...]\n"
-												"  SHOW <event_id>\n"
-												"  LIST\n"
-												"  WAIT <delay_ms> [thread_id]\n"
-												"  BARRIER\n"
-												"  HELP\n";
-			
-					write(args_data->input_fd, help_message, strlen(help_message));
+					write(args_data->input_fd, HELP_MESSAGE, strlen(HELP_MESSAGE));
 				}
 			break;
 
@@ -135,7 +195,13 @@ void* process_file(void* args) {
 				/// For this to work we need to use 2 semaphores (one initialized with 0 and one with 1) and a mutex...
 				pthread_mutex_lock(&args_data->shared_data->barrier_mod_mutex); /// get exclusive access to the shared variables
 				args_data->shared_data->blocked_threads_counter++;
+				if (vclock_now() > args_data->shared_data->barrier_time) { /// the barrier opens at the logical time of the last thread to reach it
+					args_data->shared_data->barrier_time = vclock_now();
+				}
 				if (args_data->shared_data->blocked_threads_counter == args_data->number_of_threads) { /// if all threads have reached the barrier
+					if (args_data->shared_data->checkpoint != NULL) { /// every other thread is waiting here, so nothing changes while the state is saved
+						checkpoint_at_barrier(args_data->shared_data->checkpoint, args_data->input_fd, line_num + 1, args_data->shared_data->barrier_time);
+					}
 					sem_wait(&args_data->shared_data->barrier_sem_1); /// this semaphore was initialized with 1, so it will become 0
 					sem_post(&args_data->shared_data->barrier_sem_2); /// "free" this semaphore so one thread can pass through it
 				}				
@@ -146,6 +212,7 @@ void* process_file(void* args) {
 				/// For restarting the barrier (more specifically the blocked threads counter and the semaphores):
 				pthread_mutex_lock(&args_data->shared_data->barrier_mod_mutex); /// get exclusive access to the shared variables again
 				args_data->shared_data->blocked_threads_counter--;
+				vclock_advance_to(args_data->shared_data->barrier_time); /// every thread has reached the barrier by now, so the barrier time is final
 				if (args_data->shared_data->blocked_threads_counter == 0) {
 					sem_wait(&args_data->shared_data->barrier_sem_2); /// this semaphore ended up with a value of 1, so it will become 0 again (like it was initialized)
 					sem_post(&args_data->shared_data->barrier_sem_1); /// "free" this semaphore so one thread can pass through it
@@ -155,6 +222,7 @@ void* process_file(void* args) {
 				sem_post(&args_data->shared_data->barrier_sem_1); /// the thread that has passed will increment the semaphore, so the next thread can pass through it too
 				
 				/// At the end, both semaphores will have their initial value, so the barrier can be used again.
+				trace_end(command_start, "command", "BARRIER", TRACE_NO_ARG);
 			break;
 			
 			case CMD_EMPTY:
@@ -166,24 +234,94 @@ void* process_file(void* args) {
 			break;
 		}
 
+		if (should_process) {
+			trace_command(command_start, command, event_id);
+		}
+
 		line_num++;
 	}
 
+	pthread_mutex_lock(&args_data->shared_data->barrier_mod_mutex);
+	if (vclock_now() > args_data->shared_data->makespan) { /// the file is done when its last thread is done
+		args_data->shared_data->makespan = vclock_now();
+	}
+	pthread_mutex_unlock(&args_data->shared_data->barrier_mod_mutex);
+
 	close(args_data->input_fd);
+	parser_scratch_free(&scratch);
 	free(args_data);
 	return NULL;
 }
 
-int thread_manager_for_file_processing(char* input_filename, int number_of_threads) {
+/// Prepares the checkpoints of a file and, with --resume, restores the EMS state from its last checkpoint.
+/// @param input_filename Name of the .jobs file.
+/// @param output_filename Name of the .out file.
+/// @param options Optional processing modes.
+/// @param schedule Checkpoint schedule to prepare (its filename stays NULL if checkpoints can't be taken).
+/// @param position Pointer to the variable to store the position to continue from in.
+/// @return 1 if the file continues from a checkpoint, 0 if it starts from the beginning.
+static int prepare_checkpoints(const char* input_filename, const char* output_filename, const processing_options* options, checkpoint_schedule* schedule, checkpoint_position* position) {
+	schedule->filename = filename_extension_changer(input_filename, CHECKPOINT_EXTENSION);
+
+	if (schedule->filename == NULL || hash_file(input_filename, &schedule->input_hash) != 0) {
+		fprintf(stderr, "Error: Unable to prepare the checkpoints of the file: %s\n", input_filename);
+		free(schedule->filename);
+		schedule->filename = NULL;
+		return 0;
+	}
+
+	if (!options->resume) {
+		return 0;
+	}
+
+	int restored = checkpoint_restore(schedule->filename, schedule->input_hash, output_filename, position);
+	if (restored == -1) { /// the state may be partially restored, so the file can't be processed
+		fprintf(stderr, "Error: Damaged checkpoint (remove it to start over): %s\n", schedule->filename);
+		exit(EXIT_FAILURE);
+	}
+
+	if (restored == 0) {
+		printf("Resuming %s from line %llu\n", input_filename, (unsigned long long) position->line_num);
+	}
+	return restored == 0;
+}
+
+int thread_manager_for_file_processing(char* input_filename, int number_of_threads, const processing_options* options) {
+	if (options->adaptive_threads) { /// pick the number of threads from a pre-scan of the file (never more than the given number)
+		job_file_profile profile;
+
+		if (profile_job_file(input_filename, &profile) == 0) {
+			number_of_threads = choose_number_of_threads(&cost_model, &profile, number_of_threads);
+			/// the choice is reported on stderr (stdout is the program's output)
+			fprintf(stderr, "Processing %s with %d thread(s) (%zu lines)\n", input_filename, number_of_threads, profile.lines);
+		} else {
+			fprintf(stderr, "Error: Unable to pre-scan the file: %s\n", input_filename);
+		}
+	}
+
+	if (options->trace) { /// only this file is traced (each file is processed by its own process)
+		trace_enable();
+	}
+
 	char* output_filename = filename_extension_changer(input_filename, OUTPUT_EXTENSION); /// get the output filename by changing the extension of the input filename
 	
 	if (output_filename != NULL) { 
+		checkpoint_schedule schedule = {NULL, 0, -1, 0}; /// the first BARRIER always takes a checkpoint
+		checkpoint_position position = {0, 0, 1, 0, 0}; /// from the beginning of the file, unless it is resumed
+		int resumed = options->checkpoint && prepare_checkpoints(input_filename, output_filename, options, &schedule, &position);
+
 		int output_fd; /// file descriptor for the output file (will be used by all threads)
-		if ((output_fd = open(output_filename, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1) {
+		if ((output_fd = open(output_filename, O_CREAT | O_WRONLY | (resumed ? 0 : O_TRUNC), S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1) {
 			fprintf(stderr, "Error: Unable to create a the file: %s\n", output_filename);
 			exit(EXIT_FAILURE);
 		}
 
+		if (resumed && (ftruncate(output_fd, (off_t) position.out_length) != 0 || lseek(output_fd, 0, SEEK_END) == -1)) { /// drop the output written after the checkpoint
+			fprintf(stderr, "Error: Unable to truncate the file: %s\n", output_filename);
+			exit(EXIT_FAILURE);
+		}
+		schedule.output_fd = output_fd;
+
 		pthread_t *threads = malloc(sizeof(pthread_t) * (long unsigned int) number_of_threads); /// allocate memory for the threads
 		if (threads == NULL) {
 			fprintf(stderr, "Error: Memory allocation for threads failed\n");
@@ -197,6 +335,9 @@ int thread_manager_for_file_processing(char* input_filename, int number_of_threa
 		sem_init(&shared_data.barrier_sem_2, 0, 0); /// initialize the semaphore 2 for the barrier (explained on the barrier implementation)
 		pthread_mutex_init(&shared_data.barrier_mod_mutex, NULL); /// initialize the mutex for the barrier (explained on the barrier implementation)
 		shared_data.blocked_threads_counter = 0;
+		shared_data.barrier_time = position.barrier_time;
+		shared_data.makespan = 0;
+		shared_data.checkpoint = schedule.filename != NULL ? &schedule : NULL;
 
 		int i;
 		for (i = 0; i < number_of_threads; i++) {
@@ -210,6 +351,12 @@ int thread_manager_for_file_processing(char* input_filename, int number_of_threa
 				fprintf(stderr, "Error: Unable to open the file: %s\n", input_filename);
 				exit(EXIT_FAILURE);
 			}
+
+			if (lseek(args->input_fd, (off_t) position.input_offset, SEEK_SET) == -1) { /// every thread starts after the checkpointed BARRIER
+				fprintf(stderr, "Error: Unable to seek in the file: %s\n", input_filename);
+				exit(EXIT_FAILURE);
+			}
+			args->first_line = (int) position.line_num;
 			
 			args->output_fd = output_fd;
 			args->shared_data = &shared_data;
@@ -225,6 +372,23 @@ int thread_manager_for_file_processing(char* input_filename, int number_of_threa
 		for (i = 0; i < number_of_threads; i++) { /// wait for all created threads to finish
 			pthread_join(threads[i], NULL);
 		}
+
+		if (vclock_enabled()) {
+			printf("Simulated makespan of %s: %llu ms\n", input_filename, shared_data.makespan);
+		}
+
+		if (schedule.filename != NULL) { /// the file is done, so there is nothing to resume anymore
+			remove(schedule.filename);
+			free(schedule.filename);
+		}
+
+		if (options->trace) {
+			char* trace_filename = filename_extension_changer(input_filename, TRACE_EXTENSION);
+			if (trace_write(trace_filename) != 0) {
+				fprintf(stderr, "Error: Unable to write the trace: %s\n", trace_filename);
+			}
+			free(trace_filename);
+		}
 		
 		if (pthread_mutex_destroy(&shared_data.output_write_mutex) != 0) { /// destroy the mutex used to safely write to the output file descriptor
 			fprintf(stderr, "Error: Failed to destroy the output mutex\n");
@@ -262,72 +426,434 @@ int thread_manager_for_file_processing(char* input_filename, int number_of_threa
 	return 0;
 }
 
-int process_directory_files(const char *dir_path, int number_of_processes, int number_of_threads, unsigned int delay) {
-		DIR *dir; /// the specified directory
-		struct dirent *entry; 
-		int active_processes = 0; /// number of active processes
+/// Child process that is processing a file.
+typedef struct {
+	pid_t pid; /// Process id of the child (0 if the slot is free).
+	manifest_entry job; /// Name, hash and settings of the file being processed (the name points to file_name).
+	char file_name[NAME_MAX + 1]; /// Copy of the name of the file, so that it outlives the caller's string.
+} running_job;
+
+/// Child processes spawned to process the files of a directory (at most number_of_processes at a time).
+typedef struct {
+	running_job* jobs; /// Slots of the running child processes.
+	int number_of_processes; /// Number of slots.
+	int active_processes; /// Number of used slots.
+	int number_of_threads; /// Maximum number of threads to spawn per file.
+	unsigned int delay; /// State access delay in milliseconds.
+	const processing_options* options; /// Optional processing modes.
+	job_manifest manifest; /// What was processed successfully in previous runs (incremental mode).
+	DIR* dir; /// The directory being processed (closed by the child processes).
+} process_pool;
+
+/// Frees the slot of a child process that finished.
+/// @param pool Pool of child processes.
+/// @param child_pid Process id of the child.
+/// @param status Status of the child returned by wait.
+/// @param report 1 if the exit status of the child should be printed, 0 otherwise.
+static void finish_child(process_pool* pool, pid_t child_pid, int status, int report) {
+	int succeeded = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+
+	if (report) {
+		if (WIFEXITED(status)) {
+			int exit_status = WEXITSTATUS(status); /// the exit status of the child process
+
+			if (exit_status == EXIT_SUCCESS) {
+				printf("The child process %d returned without errors (exit status: %d)\n", child_pid, exit_status);
+			} else {
+				printf("The child process %d returned with errors (exit status: %d)\n", child_pid, exit_status);
+			}
+		} else {
+			printf("Child process %d terminated atypically\n", child_pid);
+		}
+	}
 
-		if ((dir = opendir(dir_path)) == NULL) {
-			printf("Error: Unable to open the directory: %s\n", dir_path);
-			exit(EXIT_FAILURE);
+	for (int i = 0; i < pool->number_of_processes; i++) {
+		if (pool->jobs[i].pid == child_pid) {
+			if (succeeded && pool->options->incremental) { /// remember the file so that it can be skipped while it stays unchanged
+				char* output_filename = filename_extension_changer(pool->jobs[i].job.name, OUTPUT_EXTENSION);
+				if (manifest_record(&pool->manifest, &pool->jobs[i].job, output_filename) != 0) {
+					fprintf(stderr, "Error: Unable to record %s in the manifest\n", pool->jobs[i].job.name);
+				}
+				free(output_filename);
+			}
+
+			pool->jobs[i].pid = 0;
+			pool->active_processes--;
+			return;
+		}
+	}
+}
+
+/// Waits for a child process to finish and frees its slot.
+/// @param pool Pool of child processes.
+/// @param report 1 if the exit status of the child should be printed, 0 otherwise.
+static void wait_for_child(process_pool* pool, int report) {
+	int status; /// the status of the child process
+	pid_t child_pid = wait(&status);
+
+	if (child_pid <= 0) {
+		fprintf(stderr, "Error: Error while waiting for a child process\n");
+		exit(EXIT_FAILURE);
+	}
+
+	finish_child(pool, child_pid, status, report);
+}
+
+/// Frees the slots of the child processes that already finished (without blocking).
+/// @param pool Pool of child processes.
+static void reap_finished_children(process_pool* pool) {
+	int status; /// the status of the child process
+	pid_t child_pid;
+
+	while (pool->active_processes > 0 && (child_pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		finish_child(pool, child_pid, status, 1);
+	}
+}
+
+/// Spawns a child process to process a file (waiting for a free slot first).
+/// @param pool Pool of child processes.
+/// @param job Name, hash and settings of the file to process.
+static void spawn_file_processing(process_pool* pool, const manifest_entry* job) {
+	while (pool->active_processes >= pool->number_of_processes) { /// wait for a process slot to be available
+		wait_for_child(pool, 0);
+	}
+
+	fflush(stdout); /// otherwise the child would inherit (and print again) what is still buffered
+
+	pid_t pid = fork();
+
+	if (pid == -1) { /// if the fork failed
+		fprintf(stderr, "Error: Unable to fork\n");
+		exit(EXIT_FAILURE);
+	} else if (pid == 0) { /// code for the child process
+		ems_init(pool->delay);
+		thread_manager_for_file_processing(job->name, pool->number_of_threads, pool->options); /// process the file with threads
+		ems_terminate();
+		closedir(pool->dir); /// close the directory in the child process
+		exit(EXIT_SUCCESS); /// exit the child process
+	}
+
+	/// code for the parent process
+	for (int i = 0; i < pool->number_of_processes; i++) {
+		if (pool->jobs[i].pid == 0) {
+			pool->jobs[i].pid = pid;
+			pool->jobs[i].job = *job;
+			strncpy(pool->jobs[i].file_name, job->name, NAME_MAX);
+			pool->jobs[i].file_name[NAME_MAX] = '\0';
+			pool->jobs[i].job.name = pool->jobs[i].file_name;
+			break;
+		}
+	}
+	pool->active_processes++;
+}
+
+static volatile sig_atomic_t stop_watching = 0; /// set by SIGINT/SIGTERM to leave the watch mode
+
+/// Signal handler that stops the watch mode (the running files still finish).
+/// @param signum Signal received.
+static void handle_stop_signal(int signum) {
+	(void) signum;
+	stop_watching = 1;
+}
+
+/// Returns the current time of the monotonic clock in milliseconds.
+static long long monotonic_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// File written to the watched directory that is waiting to be processed.
+typedef struct {
+	char* name; /// Name of the file.
+	long long ready_at_ms; /// Time at which the file is considered complete (it is pushed back by every new write).
+} pending_file;
+
+/// Files waiting to be processed in the watch mode.
+typedef struct {
+	pending_file* files; /// Array of pending files.
+	size_t count; /// Number of pending files.
+	size_t capacity; /// Allocated number of pending files.
+} pending_files;
+
+/// Adds a file to the pending files, or postpones it if it was already pending.
+/// @param pending Pending files.
+/// @param name Name of the file.
+static void add_pending_file(pending_files* pending, const char* name) {
+	long long ready_at_ms = monotonic_ms() + WATCH_DEBOUNCE_MS;
+
+	for (size_t i = 0; i < pending->count; i++) {
+		if (strcmp(pending->files[i].name, name) == 0) {
+			pending->files[i].ready_at_ms = ready_at_ms;
+			return;
 		}
+	}
 
-		if (chdir(dir_path) != 0) { /// change the directory to the specified directory
-			fprintf(stderr, "Error: Unable to change the directory to: %s\n", dir_path);
+	if (pending->count == pending->capacity) {
+		pending->capacity = pending->capacity == 0 ? 16 : pending->capacity * 2;
+		pending->files = realloc(pending->files, pending->capacity * sizeof(pending_file));
+		if (pending->files == NULL) {
+			fprintf(stderr, "Error: Memory allocation for the pending files failed\n");
 			exit(EXIT_FAILURE);
 		}
+	}
+
+	if ((pending->files[pending->count].name = strdup(name)) == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the pending files failed\n");
+		exit(EXIT_FAILURE);
+	}
+	pending->files[pending->count].ready_at_ms = ready_at_ms;
+	pending->count++;
+}
+
+/// Checks if a file is being processed by a child process.
+/// @param pool Pool of child processes.
+/// @param name Name of the file.
+/// @return 1 if the file is being processed, 0 otherwise.
+static int is_running(const process_pool* pool, const char* name) {
+	for (int i = 0; i < pool->number_of_processes; i++) {
+		if (pool->jobs[i].pid != 0 && strcmp(pool->jobs[i].file_name, name) == 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// Processes the pending files that are complete, while there are free process slots.
+/// A file that is still being processed from a previous write waits for that run to finish (both would write the same .out).
+/// @param pool Pool of child processes.
+/// @param pending Pending files.
+static void dispatch_pending_files(process_pool* pool, pending_files* pending) {
+	long long now = monotonic_ms();
+	size_t i = 0;
+
+	while (i < pending->count && pool->active_processes < pool->number_of_processes) {
+		pending_file* file = &pending->files[i];
+
+		if (file->ready_at_ms > now || is_running(pool, file->name)) {
+			i++;
+			continue;
+		}
+
+		manifest_entry job = {file->name, 0, pool->delay, pool->number_of_threads, pool->options->adaptive_threads, 0, 0, 0};
+		int skip = 0;
+
+		if (pool->options->incremental && hash_file(file->name, &job.hash) == 0) {
+			char* output_filename = filename_extension_changer(file->name, OUTPUT_EXTENSION);
+			skip = manifest_is_unchanged(&pool->manifest, &job, output_filename);
+			free(output_filename);
+		}
+
+		if (skip) {
+			printf("Skipping %s (unchanged since the last run)\n", file->name);
+		} else {
+			spawn_file_processing(pool, &job); /// never waits, there is a free slot
+		}
+
+		free(file->name);
+		pending->files[i] = pending->files[--pending->count]; /// the order between complete files doesn't matter
+	}
+}
+
+/// Returns how long the watch loop can sleep before it has something to do (-1 to sleep until an event arrives).
+/// @param pool Pool of child processes.
+/// @param pending Pending files.
+static int watch_timeout_ms(const process_pool* pool, const pending_files* pending) {
+	long long timeout = pool->active_processes > 0 ? WATCH_REAP_INTERVAL_MS : -1;
+	long long now = monotonic_ms();
+
+	for (size_t i = 0; i < pending->count; i++) {
+		long long remaining = pending->files[i].ready_at_ms > now ? pending->files[i].ready_at_ms - now : 0;
+		if (timeout == -1 || remaining < timeout) {
+			timeout = remaining;
+		}
+	}
 
-		while ((entry = readdir(dir)) != NULL) {
-			if (strstr(entry->d_name, EXTENSION_TO_PROCESS)) { /// if the file has the ".jobs" extension
-				while (active_processes >= number_of_processes) { /// wait for a process slot to be available
-					pid_t child_pid = wait(NULL);
+	return (int) timeout;
+}
 
-					if (child_pid > 0) { /// if the child process has finished
-						active_processes--;
+/// Keeps processing the .jobs files written to (or moved into) the current directory until SIGINT or SIGTERM.
+/// At most number_of_processes files are processed at a time; the others wait in the pending files.
+/// @param pool Pool of child processes (the files found when the directory was opened may still be running).
+/// @param inotify_fd Inotify instance watching the current directory.
+static void watch_directory(process_pool* pool, int inotify_fd) {
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = handle_stop_signal; /// no SA_RESTART, so that poll is interrupted
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	pending_files pending = {NULL, 0, 0};
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event)))); /// inotify events are aligned like their struct
+
+	printf("Watching for new job files (SIGINT or SIGTERM to stop)\n");
+	fflush(stdout);
+
+	while (!stop_watching) {
+		struct pollfd poll_fd = {inotify_fd, POLLIN, 0};
+		int ready = poll(&poll_fd, 1, watch_timeout_ms(pool, &pending));
+
+		if (ready == -1 && errno != EINTR) {
+			fprintf(stderr, "Error: Error while watching the directory\n");
+			break;
+		}
+
+		if (ready > 0) {
+			ssize_t length;
+			while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+				for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + ((struct inotify_event*) ptr)->len) {
+					struct inotify_event* event = (struct inotify_event*) ptr;
+
+					if (event->len > 0 && strstr(event->name, EXTENSION_TO_PROCESS)) { /// if the file has the ".jobs" extension
+						add_pending_file(&pending, event->name);
 					}
 				}
+			}
+		}
+
+		reap_finished_children(pool);
+		dispatch_pending_files(pool, &pending);
+	}
 
-				pid_t pid = fork(); 
+	printf("Stopped watching (%zu pending file(s) not processed)\n", pending.count);
+
+	for (size_t i = 0; i < pending.count; i++) {
+		free(pending.files[i].name);
+	}
+	free(pending.files);
+}
 
-				if (pid == -1) { /// if the fork failed
-					fprintf(stderr, "Error: Unable to fork\n");
+/// Lists the files of a directory with the ".jobs" extension.
+/// @param dir Directory to list.
+/// @param num_files Pointer to the variable to store the number of files in.
+/// @return Array with the (allocated) names of the files.
+static char** list_job_files(DIR* dir, size_t* num_files) {
+	struct dirent *entry;
+	char** files = NULL;
+	size_t capacity = 0;
+
+	*num_files = 0;
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (strstr(entry->d_name, EXTENSION_TO_PROCESS)) { /// if the file has the ".jobs" extension
+			if (*num_files == capacity) {
+				capacity = capacity == 0 ? 16 : capacity * 2;
+				files = realloc(files, capacity * sizeof(char*));
+				if (files == NULL) {
+					fprintf(stderr, "Error: Memory allocation for the file list failed\n");
 					exit(EXIT_FAILURE);
-				} else if (pid == 0) { /// code for the child process
-					ems_init(delay);
-					thread_manager_for_file_processing(entry->d_name, number_of_threads); /// process the file with threads
-					ems_terminate();
-					closedir(dir); /// close the directory in the child process
-					exit(EXIT_SUCCESS); /// exit the child process
-				} else { /// code for the parent process
-					active_processes++;
 				}
 			}
+
+			if ((files[*num_files] = strdup(entry->d_name)) == NULL) {
+				fprintf(stderr, "Error: Memory allocation for the file list failed\n");
+				exit(EXIT_FAILURE);
+			}
+			(*num_files)++;
+		}
+	}
+
+	return files;
+}
+
+int process_directory_files(const char *dir_path, int number_of_processes, int number_of_threads, unsigned int delay, const processing_options* options) {
+	DIR *dir; /// the specified directory
+
+	if ((dir = opendir(dir_path)) == NULL) {
+		printf("Error: Unable to open the directory: %s\n", dir_path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (chdir(dir_path) != 0) { /// change the directory to the specified directory
+		fprintf(stderr, "Error: Unable to change the directory to: %s\n", dir_path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->virtual_time) { /// inherited by the child processes
+		vclock_enable();
+	}
+
+	if (options->adaptive_threads && calibrate_thread_cost_model(&cost_model, delay) != 0) {
+		fprintf(stderr, "Error: Unable to calibrate the thread cost model\n");
+		exit(EXIT_FAILURE);
+	}
+
+	process_pool pool = {NULL, number_of_processes, 0, number_of_threads, delay, options, {NULL, 0, 0}, dir};
+	if ((pool.jobs = calloc((size_t) number_of_processes, sizeof(running_job))) == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the process slots failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	int inotify_fd = -1;
+	if (options->watch) { /// watch before listing, so that no file written in between is missed
+		if ((inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1 || inotify_add_watch(inotify_fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+			fprintf(stderr, "Error: Unable to watch the directory: %s\n", dir_path);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	size_t num_files;
+	char** files = list_job_files(dir, &num_files);
+	uint64_t* hashes = calloc(num_files + 1, sizeof(uint64_t));
+	int* hashed = calloc(num_files + 1, sizeof(int));
+
+	if (hashes == NULL || hashed == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the file hashes failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (options->incremental) {
+		if (manifest_load(&pool.manifest) != 0) {
+			fprintf(stderr, "Error: Unable to load the manifest\n");
+			exit(EXIT_FAILURE);
 		}
 
-		while (active_processes > 0) { /// wait for all child processes to finish
-			int status; /// the status of the child process
-			pid_t child_pid = wait(&status);
+		hash_files_in_parallel(files, num_files, hashes, hashed, number_of_threads); /// much cheaper than processing the files
+	}
 
-			if (child_pid > 0) { 
-				active_processes--;
+	for (size_t i = 0; i < num_files; i++) {
+		manifest_entry job = {files[i], hashes[i], delay, number_of_threads, options->adaptive_threads, 0, 0, 0};
 
-				if (WIFEXITED(status)) {
-					int exit_status = WEXITSTATUS(status); /// the exit status of the child process
+		if (options->incremental && hashed[i]) {
+			char* output_filename = filename_extension_changer(files[i], OUTPUT_EXTENSION);
+			int unchanged = manifest_is_unchanged(&pool.manifest, &job, output_filename);
+			free(output_filename);
 
-					if (exit_status == EXIT_SUCCESS) {
-						printf("The child process %d returned without errors (exit status: %d)\n", child_pid, exit_status);
-					} else {
-						printf("The child process %d returned with errors (exit status: %d)\n", child_pid, exit_status);
-					}
-				} else {
-						printf("Child process %d terminated atypically\n", child_pid);
-				}
-			} else {
-				fprintf(stderr, "Error: Error while waiting for a child process\n");
-				exit(EXIT_FAILURE);
+			if (unchanged) {
+				printf("Skipping %s (unchanged since the last run)\n", files[i]);
+				continue;
 			}
 		}
 
+		spawn_file_processing(&pool, &job);
+	}
+
+	if (options->watch) {
+		watch_directory(&pool, inotify_fd);
+		close(inotify_fd);
+	}
+
+	while (pool.active_processes > 0) { /// wait for all child processes to finish
+		wait_for_child(&pool, 1);
+	}
+
+	if (options->incremental) {
+		if (manifest_save(&pool.manifest) != 0) {
+			fprintf(stderr, "Error: Unable to save the manifest\n");
+		}
+		manifest_free(&pool.manifest);
+	}
+
+	for (size_t i = 0; i < num_files; i++) {
+		free(files[i]);
+	}
+	free(files);
+	free(hashes);
+	free(hashed);
+	free(pool.jobs);
+
 	closedir(dir);
 	return 0;
 }
@@ -1,19 +1,33 @@
 #ifndef PROCESSING_H
 #define PROCESSING_H
 
+/// Optional modes that change how the job files are processed (all disabled by default).
+typedef struct {
+	int adaptive_threads; /// 1 if the number of threads of each file should be chosen by the cost model (capped by the given number of threads).
+	int incremental; /// 1 if the files whose contents and settings didn't change since the last run (and whose .out is intact) should be skipped.
+	int virtual_time; /// 1 if the delays should advance a logical clock instead of sleeping (the simulated makespan of each file is reported).
+	int trace; /// 1 if the threads, locks, barriers and delays of each file should be traced to <file>.trace.json (Chrome trace format).
+	int watch; /// 1 if the directory should keep being watched for new .jobs files (until SIGINT or SIGTERM).
+	int checkpoint; /// 1 if a checkpoint of each file should be taken at its barriers (at most once every CHECKPOINT_INTERVAL_MS) in <file>.ckpt.
+	int resume; /// 1 if the files with a checkpoint should continue from it instead of from the beginning (implies checkpoint).
+	int stream; /// 1 if the commands should be read from a stream (stdin or a FIFO) instead of a directory of job files.
+} processing_options;
+
 /// Processes the files in the given directory with the given number of processes and threads.
 /// @param dir_path Directory path.
 /// @param number_of_processes Maximum number of processes to spawn. 
 /// @param number_of_threads Maximum number of threads to spawn per file.
 /// @param delay State access delay in milliseconds.
+/// @param options Optional processing modes.
 /// @return 0 if the directory was processed successfully, 1 otherwise.
-int process_directory_files(const char *dir_path, int number_of_processes, int number_of_threads, unsigned int delay);
+int process_directory_files(const char *dir_path, int number_of_processes, int number_of_threads, unsigned int delay, const processing_options* options);
 
 /// Processes the given file with the given number of threads.
 /// @param file_entry_name File name of the file to process.
 /// @param number_of_threads Maximum number of threads to spawn.
+/// @param options Optional processing modes.
 /// @return 0 if the file was processed successfully, 1 otherwise.
-int thread_manager_for_file_processing(char* file_entry_name, int number_of_threads);
+int thread_manager_for_file_processing(char* file_entry_name, int number_of_threads, const processing_options* options);
 
 /// Thread function to process a file.
 /// @param args Thread arguments. They must be of type thread_args.
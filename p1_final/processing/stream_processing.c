@@ -0,0 +1,410 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <unistd.h>
+#include <fcntl.h> /// flags for open, etc.
+
+#include <sys/stat.h> /// permission-related constants
+
+#include <pthread.h>
+
+#include "../operations.h"
+#include "../parser.h"
+#include "parallel_processing_utils.h"
+#include "stream_processing.h"
+
+#define STREAM_QUEUE_SIZE 64 /// maximum number of commands read but not yet taken by a thread
+
+/// Command parsed by the reader, waiting to be executed by a thread.
+typedef struct {
+	enum Command command; /// CMD_CREATE, CMD_RESERVE, CMD_SHOW, CMD_DELETE or CMD_LIST_EVENTS.
+	unsigned int event_id; /// Event id (CREATE, RESERVE, SHOW and DELETE).
+	size_t num_rows; /// Number of rows (CREATE).
+	size_t num_columns; /// Number of columns (CREATE).
+	size_t num_coords; /// Number of seats (RESERVE).
+	size_t* xs; /// Rows of the seats (RESERVE).
+	size_t* ys; /// Columns of the seats (RESERVE).
+	size_t coords_capacity; /// Number of entries of xs and ys.
+} stream_command;
+
+/// Bounded queue between the reader and the threads (a producer-consumer buffer).
+typedef struct {
+	stream_command slots[STREAM_QUEUE_SIZE]; /// Circular buffer of commands.
+	size_t head; /// Index of the next command to be taken.
+	size_t count; /// Number of commands in the buffer.
+	int in_flight; /// Number of commands taken by a thread but not finished yet.
+	int done; /// 1 when the reader reached the end of the stream.
+	unsigned int* pending_waits; /// Delay each thread must wait before taking its next command (WAIT <delay> <thread_id>), indexed by thread id.
+
+	pthread_mutex_t mutex; /// Mutex to protect the queue.
+	pthread_cond_t can_produce; /// Signaled when a slot is freed.
+	pthread_cond_t can_consume; /// Signaled when a command is added, a wait is posted or the stream ends.
+	pthread_cond_t drained; /// Signaled when there are no commands queued or in flight.
+
+	int output_fd; /// File descriptor to write the output to.
+	int number_of_threads; /// Number of threads executing the commands.
+	pthread_mutex_t output_write_mutex; /// Mutex to safely write to the output file descriptor.
+	pthread_mutex_t events_general_mutex; /// Mutex to safely update the general events.
+} command_queue;
+
+/// Arguments of each thread executing commands.
+typedef struct {
+	command_queue* queue; /// Queue to take the commands from.
+	int thread_id; /// Thread id (1..number_of_threads).
+} stream_thread_args;
+
+/// Moves a command to another one, swapping their coordinate buffers (so that they are reused instead of copied).
+/// @param to Command to move to.
+/// @param from Command to move from (it gets the previous coordinate buffers of the other command).
+static void move_command(stream_command* to, stream_command* from) {
+	size_t* xs = to->xs;
+	size_t* ys = to->ys;
+	size_t coords_capacity = to->coords_capacity;
+
+	*to = *from;
+
+	from->xs = xs;
+	from->ys = ys;
+	from->coords_capacity = coords_capacity;
+}
+
+/// Executes a command taken from the queue.
+/// @param queue Queue the command was taken from.
+/// @param cmd Command to execute.
+static void execute_command(command_queue* queue, const stream_command* cmd) {
+	switch (cmd->command) {
+		case CMD_CREATE:
+			if (ems_create(cmd->event_id, cmd->num_rows, cmd->num_columns, &queue->events_general_mutex)) {
+				fprintf(stderr, "Failed to create event\n");
+			}
+		break;
+
+		case CMD_RESERVE:
+			if (ems_reserve(cmd->event_id, cmd->num_coords, cmd->xs, cmd->ys, &queue->events_general_mutex)) {
+				fprintf(stderr, "Failed to reserve seats\n");
+			}
+		break;
+
+		case CMD_SHOW:
+			if (ems_show(cmd->event_id, queue->output_fd, &queue->output_write_mutex, &queue->events_general_mutex)) {
+				fprintf(stderr, "Failed to show event\n");
+			}
+		break;
+
+		case CMD_DELETE:
+			if (ems_delete(cmd->event_id, &queue->events_general_mutex)) {
+				fprintf(stderr, "Failed to delete event\n");
+			}
+		break;
+
+		case CMD_LIST_EVENTS:
+			if (ems_list_events(queue->output_fd, &queue->output_write_mutex, &queue->events_general_mutex)) {
+				fprintf(stderr, "Failed to list events\n");
+			}
+		break;
+
+		case CMD_BARRIER:
+		case CMD_WAIT:
+		case CMD_HELP:
+		case CMD_EMPTY:
+		case CMD_INVALID:
+		case EOC:
+			/// handled by the reader, never queued
+		break;
+	}
+}
+
+/// Thread function that executes the commands of the queue until the stream ends.
+/// @param args Thread arguments. They must be of type stream_thread_args.
+static void* stream_worker(void* args) {
+	stream_thread_args* worker_args = (stream_thread_args*) args;
+	command_queue* queue = worker_args->queue;
+	stream_command cmd = {0}; /// command being executed, moved out of its slot so that the slot can be reused meanwhile
+
+	pthread_mutex_lock(&queue->mutex);
+	while (1) {
+		if (queue->pending_waits[worker_args->thread_id] > 0) { /// a WAIT targeted this thread
+			unsigned int delay = queue->pending_waits[worker_args->thread_id];
+			queue->pending_waits[worker_args->thread_id] = 0;
+			pthread_mutex_unlock(&queue->mutex);
+
+			fprintf(stdout, "Waiting...\n");
+			ems_wait(delay);
+
+			pthread_mutex_lock(&queue->mutex);
+			continue;
+		}
+
+		if (queue->count == 0) {
+			if (queue->done) {
+				break;
+			}
+			pthread_cond_wait(&queue->can_consume, &queue->mutex);
+			continue;
+		}
+
+		move_command(&cmd, &queue->slots[queue->head]);
+
+		queue->head = (queue->head + 1) % STREAM_QUEUE_SIZE;
+		queue->count--;
+		queue->in_flight++;
+		pthread_cond_signal(&queue->can_produce);
+		pthread_mutex_unlock(&queue->mutex);
+
+		execute_command(queue, &cmd);
+
+		pthread_mutex_lock(&queue->mutex);
+		queue->in_flight--;
+		if (queue->count == 0 && queue->in_flight == 0) {
+			pthread_cond_broadcast(&queue->drained);
+		}
+	}
+	pthread_mutex_unlock(&queue->mutex);
+
+	free(cmd.xs);
+	free(cmd.ys);
+	free(worker_args);
+	return NULL;
+}
+
+/// Adds a command to the queue (waiting for a free slot).
+/// @param queue Queue to add the command to.
+/// @param cmd Command to add (without coordinate buffers).
+/// @param scratch Parser scratch with the coordinates of a RESERVE (it gets the previous coordinate buffers of the slot).
+static void enqueue_command(command_queue* queue, const stream_command* cmd, struct ParserScratch* scratch) {
+	pthread_mutex_lock(&queue->mutex);
+	while (queue->count == STREAM_QUEUE_SIZE) {
+		pthread_cond_wait(&queue->can_produce, &queue->mutex);
+	}
+
+	stream_command* slot = &queue->slots[(queue->head + queue->count) % STREAM_QUEUE_SIZE];
+	size_t* xs = slot->xs;
+	size_t* ys = slot->ys;
+	size_t coords_capacity = slot->coords_capacity;
+
+	*slot = *cmd;
+
+	if (cmd->command == CMD_RESERVE) { /// the coordinates are handed over instead of copied
+		slot->xs = scratch->xs;
+		slot->ys = scratch->ys;
+		slot->coords_capacity = scratch->coords_capacity;
+		scratch->xs = xs;
+		scratch->ys = ys;
+		scratch->coords_capacity = coords_capacity;
+	} else {
+		slot->xs = xs;
+		slot->ys = ys;
+		slot->coords_capacity = coords_capacity;
+	}
+
+	queue->count++;
+	pthread_cond_signal(&queue->can_consume);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+/// Waits until every command read so far has finished executing.
+/// @param queue Queue to drain.
+static void drain_queue(command_queue* queue) {
+	pthread_mutex_lock(&queue->mutex);
+	while (queue->count > 0 || queue->in_flight > 0) {
+		pthread_cond_wait(&queue->drained, &queue->mutex);
+	}
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+/// Reads and parses the commands of the stream, handing them to the threads.
+/// @param queue Queue to add the commands to.
+/// @param input_fd File descriptor to read the commands from.
+static void read_commands(command_queue* queue, int input_fd) {
+	stream_command cmd = {0}; /// the coordinates stay in the scratch until the command is queued
+	struct ParserScratch scratch = {0}; /// coordinates of the RESERVE commands (handed to the queue without copying them)
+	unsigned int delay;
+
+	while (1) {
+		cmd.command = get_next(input_fd);
+		cmd.num_coords = 0;
+
+		switch (cmd.command) {
+			case CMD_CREATE:
+				if (parse_create(input_fd, &cmd.event_id, &cmd.num_rows, &cmd.num_columns) != 0) {
+					fprintf(stderr, "Invalid command. See HELP for usage\n");
+					break;
+				}
+				enqueue_command(queue, &cmd, &scratch);
+			break;
+
+			case CMD_RESERVE:
+				cmd.num_coords = parse_reserve(input_fd, &cmd.event_id, &scratch);
+				if (cmd.num_coords == 0) {
+					fprintf(stderr, "Invalid command. See HELP for usage\n");
+					break;
+				}
+				enqueue_command(queue, &cmd, &scratch);
+			break;
+
+			case CMD_SHOW:
+				if (parse_show(input_fd, &cmd.event_id) != 0) {
+					fprintf(stderr, "Invalid command. See HELP for usage\n");
+					break;
+				}
+				enqueue_command(queue, &cmd, &scratch);
+			break;
+
+			case CMD_DELETE:
+				if (parse_delete(input_fd, &cmd.event_id) != 0) {
+					fprintf(stderr, "Invalid command. See HELP for usage\n");
+					break;
+				}
+				enqueue_command(queue, &cmd, &scratch);
+			break;
+
+			case CMD_LIST_EVENTS:
+				enqueue_command(queue, &cmd, &scratch);
+			break;
+
+			case CMD_WAIT: {
+				unsigned int parsed_thread_id; /// the thread id parsed from the input
+				int have_thread_id = parse_wait(input_fd, &delay, &parsed_thread_id);
+
+				if (have_thread_id == -1) {
+					fprintf(stderr, "Invalid command. See HELP for usage\n");
+				} else if (delay > 0 && !have_thread_id) { /// every thread waits, so nothing else runs meanwhile
+					drain_queue(queue);
+					fprintf(stdout, "Waiting...\n");
+					ems_wait(delay);
+				} else if (delay > 0 && parsed_thread_id >= 1 && (int) parsed_thread_id <= queue->number_of_threads) { /// only the given thread waits (before taking its next command)
+					pthread_mutex_lock(&queue->mutex);
+					queue->pending_waits[parsed_thread_id] += delay;
+					pthread_cond_broadcast(&queue->can_consume);
+					pthread_mutex_unlock(&queue->mutex);
+				}
+			}
+			break;
+
+			case CMD_BARRIER: /// the commands after the barrier only start after all the previous ones have finished
+				drain_queue(queue);
+			break;
+
+			case CMD_HELP:
+				pthread_mutex_lock(&queue->output_write_mutex);
+				write(queue->output_fd, HELP_MESSAGE, strlen(HELP_MESSAGE));
+				pthread_mutex_unlock(&queue->output_write_mutex);
+			break;
+
+			case CMD_INVALID:
+				fprintf(stderr, "Invalid command. See HELP for usage\n");
+			break;
+
+			case CMD_EMPTY:
+				/// do nothing
+			break;
+
+			case EOC:
+				parser_scratch_free(&scratch);
+				return;
+		}
+	}
+}
+
+int process_stream(const char *input_path, const char *output_path, int number_of_threads, unsigned int delay) {
+	int input_fd = STDIN_FILENO;
+	int output_fd = STDOUT_FILENO;
+
+	if (number_of_threads < 1) {
+		fprintf(stderr, "Error: Invalid number of threads\n");
+		return 1;
+	}
+
+	if (strcmp(input_path, STREAM_STDIO_PATH) != 0 && (input_fd = open(input_path, O_RDONLY)) == -1) { /// blocks until a FIFO has a writer
+		fprintf(stderr, "Error: Unable to open the input: %s\n", input_path);
+		return 1;
+	}
+
+	if (strcmp(output_path, STREAM_STDIO_PATH) != 0 &&
+			(output_fd = open(output_path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) == -1) {
+		fprintf(stderr, "Error: Unable to open the output: %s\n", output_path);
+		return 1;
+	}
+
+	command_queue* queue = calloc(1, sizeof(command_queue)); /// too large for the stack
+	pthread_t* threads = malloc(sizeof(pthread_t) * (size_t) number_of_threads);
+
+	if (queue == NULL || threads == NULL || (queue->pending_waits = calloc((size_t) number_of_threads + 1, sizeof(unsigned int))) == NULL) {
+		fprintf(stderr, "Error: Memory allocation for the command queue failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	queue->output_fd = output_fd;
+	queue->number_of_threads = number_of_threads;
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->can_produce, NULL);
+	pthread_cond_init(&queue->can_consume, NULL);
+	pthread_cond_init(&queue->drained, NULL);
+	pthread_mutex_init(&queue->output_write_mutex, NULL);
+	pthread_mutex_init(&queue->events_general_mutex, NULL);
+
+	ems_init(delay);
+
+	int created = 0;
+	for (int i = 0; i < number_of_threads; i++) {
+		stream_thread_args* args = malloc(sizeof(stream_thread_args));
+		if (args == NULL) {
+			fprintf(stderr, "Error: Memory allocation for the thread args failed\n");
+			exit(EXIT_FAILURE);
+		}
+
+		args->queue = queue;
+		args->thread_id = i + 1;
+
+		if (pthread_create(&threads[created], NULL, stream_worker, args) != 0) {
+			fprintf(stderr, "Error: Failed to create a thread\n");
+			free(args);
+		} else {
+			created++;
+		}
+	}
+
+	if (created == 0) {
+		fprintf(stderr, "Error: No thread could be created\n");
+		exit(EXIT_FAILURE);
+	}
+
+	read_commands(queue, input_fd);
+
+	pthread_mutex_lock(&queue->mutex);
+	queue->done = 1; /// the threads finish the queued commands and exit
+	pthread_cond_broadcast(&queue->can_consume);
+	pthread_mutex_unlock(&queue->mutex);
+
+	for (int i = 0; i < created; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	ems_terminate();
+
+	pthread_mutex_destroy(&queue->mutex);
+	pthread_cond_destroy(&queue->can_produce);
+	pthread_cond_destroy(&queue->can_consume);
+	pthread_cond_destroy(&queue->drained);
+	pthread_mutex_destroy(&queue->output_write_mutex);
+	pthread_mutex_destroy(&queue->events_general_mutex);
+
+	if (input_fd != STDIN_FILENO) {
+		close(input_fd);
+	}
+	if (output_fd != STDOUT_FILENO) {
+		close(output_fd);
+	}
+
+	for (int i = 0; i < STREAM_QUEUE_SIZE; i++) {
+		free(queue->slots[i].xs);
+		free(queue->slots[i].ys);
+	}
+
+	free(queue->pending_waits);
+	free(queue);
+	free(threads);
+	return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef STREAM_PROCESSING_H
+#define STREAM_PROCESSING_H
+
+#define STREAM_STDIO_PATH "-" /// path that selects stdin (input) or stdout (output)
+
+/// Processes the commands read from a stream (stdin, a FIFO or a file) as they arrive, with the given number of threads.
+/// A single reader parses the commands and hands them to the threads through a bounded queue, so the memory used doesn't
+/// depend on the size of the stream. BARRIER waits for all the previous commands to finish before reading the next ones.
+/// @param input_path Path to read the commands from ("-" for stdin).
+/// @param output_path Path to write the output to ("-" for stdout).
+/// @param number_of_threads Number of threads to execute the commands.
+/// @param delay State access delay in milliseconds.
+/// @return 0 if the stream was processed successfully, 1 otherwise.
+int process_stream(const char *input_path, const char *output_path, int number_of_threads, unsigned int delay);
+
+#endif // STREAM_PROCESSING_H
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h> /// flags for open, etc.
+
+#include <pthread.h>
+
+#include "thread_cost_model.h"
+
+#define CALIBRATION_THREADS 8 /// number of threads created to measure the thread overhead
+#define CALIBRATION_READS 512 /// number of single byte reads used to measure the read cost
+#define CALIBRATION_SLEEPS 16 /// number of zero length sleeps used to measure the state access overhead
+#define SCAN_BUFFER_SIZE 65536 /// size of the chunks read during the pre-scan
+#define SCAN_MAX_TOKENS 4 /// number of numeric tokens of a line kept during the pre-scan
+
+/// Returns the current time of the monotonic clock in nanoseconds.
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/// Thread function that does nothing (used to measure the thread overhead).
+static void* noop_thread(void* args) {
+	return args;
+}
+
+int calibrate_thread_cost_model(thread_cost_model* model, unsigned int delay_ms) {
+	pthread_t threads[CALIBRATION_THREADS];
+	double start;
+	int i, created = 0;
+
+	start = now_ns();
+	for (i = 0; i < CALIBRATION_THREADS; i++) {
+		if (pthread_create(&threads[created], NULL, noop_thread, NULL) == 0) {
+			created++;
+		}
+	}
+	for (i = 0; i < created; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	if (created == 0) {
+		return 1;
+	}
+	model->thread_overhead_ns = (now_ns() - start) / created;
+
+	int fd = open("/dev/zero", O_RDONLY);
+	if (fd == -1) {
+		return 1;
+	}
+	char ch;
+	start = now_ns();
+	for (i = 0; i < CALIBRATION_READS; i++) {
+		if (read(fd, &ch, 1) != 1) { /// a short or failed read would skew the measured cost
+			close(fd);
+			return 1;
+		}
+	}
+	model->byte_read_ns = (now_ns() - start) / CALIBRATION_READS;
+	close(fd);
+
+	/// only the overhead of a sleep is measured, the delay itself is known (sleeping here would slow down the startup)
+	struct timespec no_delay = {0, 0};
+	start = now_ns();
+	for (i = 0; i < CALIBRATION_SLEEPS; i++) {
+		nanosleep(&no_delay, NULL);
+	}
+	model->state_access_ns = (now_ns() - start) / CALIBRATION_SLEEPS + (double) delay_ms * 1e6;
+
+	return 0;
+}
+
+/// Accounts a line whose first character and numeric tokens were collected by the pre-scan.
+static void profile_line(job_file_profile* profile, char kind, const size_t* tokens, int num_tokens, size_t parentheses) {
+	switch (kind) {
+		case 'C': /// CREATE <event_id> <num_rows> <num_columns>
+			profile->creates++;
+			if (num_tokens >= 3) {
+				size_t seats = tokens[1] * tokens[2];
+				profile->created_seats += seats;
+				if (seats > profile->max_event_seats) {
+					profile->max_event_seats = seats;
+				}
+			}
+		break;
+
+		case 'R': /// RESERVE <event_id> [(<x1>,<y1>) ...]
+			profile->reserves++;
+			profile->reserved_seats += parentheses;
+			if (parentheses > profile->max_reserve_seats) {
+				profile->max_reserve_seats = parentheses;
+			}
+		break;
+
+		case 'S':
+			profile->shows++;
+		break;
+
+		case 'L':
+			profile->lists++;
+		break;
+
+		case 'B':
+			profile->barriers++;
+		break;
+
+		case 'W': /// WAIT <delay_ms> [thread_id]
+			if (num_tokens >= 2 && tokens[1] > profile->max_wait_thread_id) {
+				profile->max_wait_thread_id = (unsigned int) tokens[1];
+			}
+		break;
+
+		default:
+			/// comments, empty lines and invalid commands cost (almost) nothing
+		break;
+	}
+}
+
+int profile_job_file(const char* filename, job_file_profile* profile) {
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		return 1;
+	}
+
+	memset(profile, 0, sizeof(job_file_profile));
+
+	char buffer[SCAN_BUFFER_SIZE];
+	ssize_t bytes_read;
+
+	char kind = '\n'; /// first character of the current line
+	size_t tokens[SCAN_MAX_TOKENS]; /// numeric tokens of the current line (event ids, dimensions, etc.)
+	int num_tokens = 0;
+	int in_token = 0; /// 1 while reading the digits of a token
+	size_t parentheses = 0; /// number of '(' in the current line (coordinates of a RESERVE)
+	int at_line_start = 1;
+
+	while ((bytes_read = read(fd, buffer, SCAN_BUFFER_SIZE)) > 0) {
+		profile->bytes += (size_t) bytes_read;
+
+		for (ssize_t i = 0; i < bytes_read; i++) {
+			char ch = buffer[i];
+
+			if (at_line_start) {
+				kind = ch;
+				num_tokens = 0;
+				in_token = 0;
+				parentheses = 0;
+				at_line_start = 0;
+			}
+
+			if (ch >= '0' && ch <= '9') {
+				if (!in_token && num_tokens < SCAN_MAX_TOKENS) {
+					tokens[num_tokens++] = 0;
+					in_token = 1;
+				}
+				if (in_token && tokens[num_tokens - 1] < ((size_t) -1) / 10) { /// saturate instead of overflowing
+					tokens[num_tokens - 1] = tokens[num_tokens - 1] * 10 + (size_t) (ch - '0');
+				}
+				continue;
+			}
+
+			in_token = 0;
+
+			if (ch == '(') {
+				parentheses++;
+			} else if (ch == '\n') {
+				profile->lines++;
+				profile_line(profile, kind, tokens, num_tokens, parentheses);
+				at_line_start = 1;
+			}
+		}
+	}
+
+	if (!at_line_start) { /// the last line has no newline
+		profile->lines++;
+		profile_line(profile, kind, tokens, num_tokens, parentheses);
+	}
+
+	close(fd);
+	return bytes_read == -1;
+}
+
+/// Estimates the time (in nanoseconds) needed to process a file with the given number of threads.
+static double estimated_time_ns(const thread_cost_model* model, const job_file_profile* profile, int number_of_threads, long cpus) {
+	double n = (double) number_of_threads;
+
+	/// every command looks up its event while holding the general mutex, so the lookups are serialized
+	double lookups = (double) (profile->creates + profile->reserves + profile->shows);
+
+	/// the seat accesses (a reservation reads and writes each seat) are split between the threads by command
+	double average_event_seats = profile->creates > 0 ? (double) profile->created_seats / (double) profile->creates : 0;
+	double seat_accesses = 2 * (double) profile->reserved_seats + (double) profile->shows * average_event_seats;
+
+	/// a command runs on a single thread, so there is no gain in having more threads than commands or in splitting the largest one
+	double commands = (double) (profile->creates + profile->reserves + profile->shows + profile->lists);
+	double largest_command = 2 * (double) profile->max_reserve_seats;
+	if (profile->shows > 0 && (double) profile->max_event_seats > largest_command) {
+		largest_command = (double) profile->max_event_seats;
+	}
+
+	double useful_threads = n < commands ? n : commands;
+	double parallel_accesses = useful_threads > 0 ? seat_accesses / useful_threads : 0;
+	if (parallel_accesses < largest_command) {
+		parallel_accesses = largest_command;
+	}
+
+	/// every thread reads the whole file, and threads beyond the number of cpus take turns reading it
+	double reading_rounds = (double) ((number_of_threads + cpus - 1) / cpus);
+
+	return n * model->thread_overhead_ns
+		+ reading_rounds * (double) profile->bytes * model->byte_read_ns
+		+ (lookups + parallel_accesses) * model->state_access_ns;
+}
+
+int choose_number_of_threads(const thread_cost_model* model, const job_file_profile* profile, int max_threads) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1) {
+		cpus = 1;
+	}
+
+	int best = 1;
+	double best_time = estimated_time_ns(model, profile, 1, cpus);
+
+	for (int n = 2; n <= max_threads; n++) {
+		double time = estimated_time_ns(model, profile, n, cpus);
+		if (time < best_time) {
+			best = n;
+			best_time = time;
+		}
+	}
+
+	/// a "WAIT <delay> <thread_id>" must still find the thread it targets
+	if ((int) profile->max_wait_thread_id > best && (int) profile->max_wait_thread_id <= max_threads) {
+		best = (int) profile->max_wait_thread_id;
+	}
+
+	return best;
+}
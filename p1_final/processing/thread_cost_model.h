@@ -0,0 +1,48 @@
+#ifndef THREAD_COST_MODEL_H
+#define THREAD_COST_MODEL_H
+
+#include <stddef.h>
+
+/// Costs (in nanoseconds) measured at startup and used to choose the number of threads for a file.
+typedef struct {
+	double thread_overhead_ns; /// Cost of creating and joining one thread.
+	double byte_read_ns; /// Cost of reading one byte from the input file (the parser reads byte by byte).
+	double state_access_ns; /// Cost of one simulated state access (see STATE_ACCESS_DELAY_MS).
+} thread_cost_model;
+
+/// Summary of a .jobs file, obtained with a quick pre-scan (the commands are not validated).
+typedef struct {
+	size_t bytes; /// Size of the file in bytes.
+	size_t lines; /// Number of lines.
+	size_t creates; /// Number of CREATE commands.
+	size_t reserves; /// Number of RESERVE commands.
+	size_t reserved_seats; /// Total number of coordinates in all RESERVE commands.
+	size_t max_reserve_seats; /// Number of coordinates of the largest RESERVE command.
+	size_t shows; /// Number of SHOW commands.
+	size_t lists; /// Number of LIST commands.
+	size_t barriers; /// Number of BARRIER commands.
+	size_t created_seats; /// Total number of seats of all the created events.
+	size_t max_event_seats; /// Number of seats of the largest created event.
+	unsigned int max_wait_thread_id; /// Highest thread id targeted by a WAIT command (0 if none).
+} job_file_profile;
+
+/// Measures the costs of the cost model on this machine.
+/// @param model Pointer to the model to fill.
+/// @param delay_ms State access delay in milliseconds.
+/// @return 0 if the model was calibrated successfully, 1 otherwise.
+int calibrate_thread_cost_model(thread_cost_model* model, unsigned int delay_ms);
+
+/// Pre-scans a .jobs file to estimate the number and mix of its commands.
+/// @param filename Name of the file to scan.
+/// @param profile Pointer to the profile to fill.
+/// @return 0 if the file was scanned successfully, 1 otherwise.
+int profile_job_file(const char* filename, job_file_profile* profile);
+
+/// Chooses the number of threads that minimizes the estimated processing time of a file.
+/// @param model Calibrated cost model.
+/// @param profile Profile of the file to process.
+/// @param max_threads Maximum number of threads (the value given in the command line).
+/// @return Number of threads to use (1..max_threads).
+int choose_number_of_threads(const thread_cost_model* model, const job_file_profile* profile, int max_threads);
+
+#endif // THREAD_COST_MODEL_H
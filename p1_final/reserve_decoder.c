@@ -0,0 +1,255 @@
+#include "reserve_decoder.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RESERVE_DECODER_X86 1
+#else
+#define RESERVE_DECODER_X86 0
+#endif
+
+#define MAX_SIGNIFICANT_DIGITS 10 /// UINT_MAX has 10 digits, so longer numbers (without leading zeros) never fit
+
+/// State of the decoding of a line.
+typedef struct {
+	const char* line; /// Line being decoded.
+	size_t length; /// Number of bytes of the line.
+	size_t pos; /// Number of bytes read so far.
+	uint64_t* digit_mask; /// Bit i is set if line[i] is a digit.
+} decoder;
+
+#if RESERVE_DECODER_X86
+/// Sets the digit mask of the line 32 bytes at a time.
+__attribute__((target("avx2")))
+static void classify_digits_avx2(decoder* dec) {
+	const __m256i below_zero = _mm256_set1_epi8('0' - 1);
+	const __m256i above_nine = _mm256_set1_epi8('9' + 1);
+
+	for (size_t i = 0; i < dec->length; i += 64) {
+		__m256i low = _mm256_loadu_si256((const __m256i*) (const void*) (dec->line + i));
+		__m256i high = _mm256_loadu_si256((const __m256i*) (const void*) (dec->line + i + 32));
+
+		/// signed comparisons: bytes >= 0x80 are negative, so they are never digits
+		__m256i low_digits = _mm256_and_si256(_mm256_cmpgt_epi8(low, below_zero), _mm256_cmpgt_epi8(above_nine, low));
+		__m256i high_digits = _mm256_and_si256(_mm256_cmpgt_epi8(high, below_zero), _mm256_cmpgt_epi8(above_nine, high));
+
+		dec->digit_mask[i / 64] = (uint64_t) (uint32_t) _mm256_movemask_epi8(low_digits) |
+			(uint64_t) (uint32_t) _mm256_movemask_epi8(high_digits) << 32;
+	}
+}
+
+/// Sets the digit mask of the line 16 bytes at a time.
+static void classify_digits_sse2(decoder* dec) {
+	const __m128i below_zero = _mm_set1_epi8('0' - 1);
+	const __m128i above_nine = _mm_set1_epi8('9' + 1);
+
+	for (size_t i = 0; i < dec->length; i += 64) {
+		uint64_t mask = 0;
+
+		for (unsigned int block = 0; block < 4; block++) {
+			__m128i bytes = _mm_loadu_si128((const __m128i*) (const void*) (dec->line + i + block * 16));
+			__m128i digits = _mm_and_si128(_mm_cmpgt_epi8(bytes, below_zero), _mm_cmpgt_epi8(above_nine, bytes));
+			mask |= (uint64_t) (uint32_t) _mm_movemask_epi8(digits) << (block * 16);
+		}
+
+		dec->digit_mask[i / 64] = mask;
+	}
+}
+#endif
+
+/// Sets the digit mask of the line one byte at a time.
+static void classify_digits_scalar(decoder* dec) {
+	for (size_t i = 0; i < dec->length; i += 64) {
+		uint64_t mask = 0;
+
+		for (unsigned int bit = 0; bit < 64; bit++) {
+			char ch = dec->line[i + bit];
+			mask |= (uint64_t) (ch >= '0' && ch <= '9') << bit;
+		}
+
+		dec->digit_mask[i / 64] = mask;
+	}
+}
+
+/// Sets the digit mask of the line with the widest instructions supported by the cpu.
+static void classify_digits(decoder* dec) {
+#if RESERVE_DECODER_X86
+	if (__builtin_cpu_supports("avx2")) {
+		classify_digits_avx2(dec);
+	} else if (__builtin_cpu_supports("sse2")) {
+		classify_digits_sse2(dec);
+	} else {
+		classify_digits_scalar(dec);
+	}
+#else
+	classify_digits_scalar(dec);
+#endif
+
+	dec->digit_mask[(dec->length + 63) / 64] = 0; /// the padding after the last block is never a digit
+}
+
+/// Counts the digits starting at the given position of the line.
+static size_t digit_run(const decoder* dec, size_t pos) {
+	size_t run = 0;
+
+	while (1) {
+		size_t bit = (pos + run) % 64;
+		uint64_t non_digits = ~(dec->digit_mask[(pos + run) / 64] >> bit); /// the bits shifted in count as non digits
+		size_t available = 64 - bit;
+		size_t digits = non_digits == 0 ? 64 : (size_t) __builtin_ctzll(non_digits);
+
+		run += digits;
+		if (digits < available || pos + run >= dec->length) {
+			break;
+		}
+	}
+
+	return run < dec->length - pos ? run : dec->length - pos;
+}
+
+/// Converts up to 8 digits with a few multiplications (the digits are multiplied and added in pairs, then in groups of 4).
+/// @param digits Digits to convert (the 8 bytes from there must be readable).
+/// @param count Number of digits (1 to 8).
+/// @return Value of the digits.
+static uint32_t convert_digits(const char* digits, size_t count) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t value;
+	memcpy(&value, digits, sizeof(value));
+
+	value -= 0x3030303030303030ULL; /// the bytes after the digits may borrow, but only from the bytes after them
+	value <<= 8 * (8 - count); /// drop the bytes after the digits, as if they were preceded by zeros
+
+	value = value * 10 + (value >> 8); /// pairs of digits
+	value = (((value & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+		(((value >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32; /// groups of 4 digits, then the 8 digits
+	return (uint32_t) value;
+#else
+	uint32_t value = 0;
+	for (size_t i = 0; i < count; i++) {
+		value = value * 10 + (uint32_t) (digits[i] - '0');
+	}
+	return value;
+#endif
+}
+
+/// Reads an unsigned integer and the byte after it, like read_uint does.
+/// @param dec Decoder.
+/// @param value Pointer to the variable to store the value in (0 if there are no digits).
+/// @param next Pointer to the variable to store the byte after the digits in ('\0' at the end of the input).
+/// @return 0 if the value fits in an unsigned int, 1 otherwise.
+static int decode_uint(decoder* dec, unsigned int* value, char* next) {
+	size_t start = dec->pos;
+	size_t run = digit_run(dec, start);
+
+	if (start + run >= dec->length) { /// the digits reach the end of the input
+		*next = '\0';
+		dec->pos = dec->length;
+	} else {
+		*next = dec->line[start + run];
+		dec->pos = start + run + 1;
+	}
+
+	while (run > 0 && dec->line[start] == '0') { /// leading zeros don't count
+		start++;
+		run--;
+	}
+
+	if (run > MAX_SIGNIFICANT_DIGITS) {
+		return 1;
+	}
+
+	uint64_t result = 0;
+	if (run > 8) {
+		result = (uint64_t) convert_digits(dec->line + start, run - 8) * 100000000ULL;
+		start += run - 8;
+		run = 8;
+	}
+	if (run > 0) {
+		result += convert_digits(dec->line + start, run);
+	}
+
+	if (result > UINT_MAX) {
+		return 1;
+	}
+
+	*value = (unsigned int) result;
+	return 0;
+}
+
+/// Reads a byte, like read does.
+/// @param dec Decoder.
+/// @param ch Pointer to the variable to store the byte in.
+/// @return 1 if a byte was read, 0 at the end of the input.
+static int decode_byte(decoder* dec, char* ch) {
+	if (dec->pos >= dec->length) {
+		return 0;
+	}
+
+	*ch = dec->line[dec->pos++];
+	return 1;
+}
+
+size_t decode_reserve(const char *line, size_t length, uint64_t *digit_mask, unsigned int *event_id, size_t *xs, size_t *ys, size_t *consumed) {
+	decoder dec;
+	dec.line = line;
+	dec.length = length;
+	dec.pos = 0;
+	dec.digit_mask = digit_mask;
+	classify_digits(&dec);
+
+	char ch;
+	size_t num_coords = 0;
+
+	if (decode_uint(&dec, event_id, &ch) != 0 || ch != ' ') {
+		*consumed = dec.pos;
+		return 0;
+	}
+
+	if (decode_byte(&dec, &ch) != 1 || ch != '[') {
+		*consumed = dec.pos;
+		return 0;
+	}
+
+	while (1) { /// the caller's arrays fit every coordinate the line can have
+		if (decode_byte(&dec, &ch) != 1 || ch != '(') {
+			*consumed = dec.pos;
+			return 0;
+		}
+
+		unsigned int x;
+		if (decode_uint(&dec, &x, &ch) != 0 || ch != ',') {
+			*consumed = dec.pos;
+			return 0;
+		}
+		xs[num_coords] = (size_t)x;
+
+		unsigned int y;
+		if (decode_uint(&dec, &y, &ch) != 0 || ch != ')') {
+			*consumed = dec.pos;
+			return 0;
+		}
+		ys[num_coords] = (size_t)y;
+
+		num_coords++;
+
+		if (decode_byte(&dec, &ch) != 1 || (ch != ' ' && ch != ']')) {
+			*consumed = dec.pos;
+			return 0;
+		}
+
+		if (ch == ']') {
+			break;
+		}
+	}
+
+	if (decode_byte(&dec, &ch) != 1 || (ch != '\n' && ch != '\0')) {
+		*consumed = dec.pos;
+		return 0;
+	}
+
+	*consumed = dec.pos;
+	return num_coords;
+}
@@ -0,0 +1,26 @@
+#ifndef RESERVE_DECODER_H
+#define RESERVE_DECODER_H
+
+#include <stddef.h>
+
+#include <stdint.h>
+
+#define RESERVE_DECODER_PADDING 64 /// zeroed bytes that must follow a line given to the decoder (it reads whole vector blocks)
+#define RESERVE_DECODER_MASK_WORDS(length) ((length) / 64 + 2) /// words of the digit mask needed to decode a line of the given length
+#define RESERVE_DECODER_MAX_COORDS(length) ((length) / 4 + 1) /// most coordinates a line of the given length can have (the shortest is "(,) ")
+
+/// Decodes the arguments of a RESERVE command from a line in memory, with the same grammar as the byte by byte parser:
+/// "<event_id> [(<x1>,<y1>) (<x2>,<y2>) ...]" followed by '\n' (or a '\0' byte).
+/// Digits are classified with vector instructions (AVX2 or SSE2 when available) and converted 8 at a time.
+/// @param line Bytes that follow "RESERVE " (followed by RESERVE_DECODER_PADDING zeroed bytes).
+/// @param length Number of bytes of the line. It must include the first '\n', or reach the end of the input.
+/// @param digit_mask Array of RESERVE_DECODER_MASK_WORDS(length) words used while decoding.
+/// @param event_id Pointer to the variable to store the event ID in.
+/// @param xs Pointer to the array to store the X coordinates in (RESERVE_DECODER_MAX_COORDS(length) entries).
+/// @param ys Pointer to the array to store the Y coordinates in (RESERVE_DECODER_MAX_COORDS(length) entries).
+/// @param consumed Pointer to the variable to store the number of bytes the byte by byte parser would have read in.
+/// On failure, the rest of the line must still be skipped from there.
+/// @return Number of coordinates read. 0 on failure.
+size_t decode_reserve(const char *line, size_t length, uint64_t *digit_mask, unsigned int *event_id, size_t *xs, size_t *ys, size_t *consumed);
+
+#endif  // RESERVE_DECODER_H
@@ -0,0 +1,169 @@
+#include "seat_renderer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MAX_SEAT_LENGTH 11 /// digits of UINT_MAX plus the separator after the seat
+
+/// Chunks of rows shared by the threads formatting an event.
+typedef struct {
+	const unsigned int* seats; /// Seats of the event.
+	size_t rows; /// Number of rows.
+	size_t cols; /// Number of columns.
+	size_t rows_per_chunk; /// Number of rows of each chunk (the last one may have less).
+	rendered_seats* rendered; /// Text of the chunks.
+	atomic_size_t next_chunk; /// Index of the next chunk to format (each thread takes the next one when it finishes one).
+	atomic_int failed; /// 1 if the memory for a chunk couldn't be allocated.
+} render_work;
+
+/// Formats an unsigned integer in decimal.
+/// @param out Buffer to write the digits to (at least MAX_SEAT_LENGTH - 1 bytes).
+/// @param value Value to format.
+/// @return Number of digits written.
+static size_t format_uint(char* out, unsigned int value) {
+	char digits[MAX_SEAT_LENGTH];
+	size_t length = 0;
+
+	do { /// the digits come out in reverse order
+		digits[length++] = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	for (size_t i = 0; i < length; i++) {
+		out[i] = digits[length - 1 - i];
+	}
+	return length;
+}
+
+/// Formats a chunk of rows into its own buffer.
+/// @param work Chunks being formatted.
+/// @param chunk Index of the chunk.
+static void render_chunk(render_work* work, size_t chunk) {
+	size_t first_row = chunk * work->rows_per_chunk;
+	size_t last_row = first_row + work->rows_per_chunk < work->rows ? first_row + work->rows_per_chunk : work->rows;
+
+	char* buffer = malloc((last_row - first_row) * (work->cols * MAX_SEAT_LENGTH + 1));
+	if (buffer == NULL) {
+		atomic_store(&work->failed, 1);
+		return;
+	}
+
+	size_t length = 0;
+	for (size_t row = first_row; row < last_row; row++) {
+		const unsigned int* seat = work->seats + row * work->cols;
+
+		for (size_t col = 0; col < work->cols; col++) {
+			length += format_uint(buffer + length, seat[col]);
+			buffer[length++] = col + 1 < work->cols ? ' ' : '\n';
+		}
+
+		if (work->cols == 0) { /// an event without columns still has its empty lines
+			buffer[length++] = '\n';
+		}
+	}
+
+	work->rendered->buffers[chunk] = buffer;
+	work->rendered->lengths[chunk] = length;
+}
+
+/// Thread function that formats chunks until there are none left.
+/// @param args Pointer to the shared render_work.
+static void* render_chunks_thread(void* args) {
+	render_work* work = (render_work*) args;
+	size_t chunk;
+
+	while ((chunk = atomic_fetch_add(&work->next_chunk, 1)) < work->rendered->num_chunks) {
+		render_chunk(work, chunk);
+	}
+
+	return NULL;
+}
+
+int render_seats(const unsigned int* seats, size_t rows, size_t cols, rendered_seats* rendered) {
+	render_work work;
+	work.seats = seats;
+	work.rows = rows;
+	work.cols = cols;
+	work.rendered = rendered;
+	atomic_init(&work.next_chunk, 0);
+	atomic_init(&work.failed, 0);
+
+	/// small events are a single chunk, large ones are split in chunks of about RENDER_CHUNK_SEATS seats
+	if (rows * cols < RENDER_PARALLEL_MIN_SEATS) {
+		work.rows_per_chunk = rows > 0 ? rows : 1;
+	} else {
+		work.rows_per_chunk = cols < RENDER_CHUNK_SEATS ? RENDER_CHUNK_SEATS / cols : 1;
+	}
+
+	rendered->num_chunks = (rows + work.rows_per_chunk - 1) / work.rows_per_chunk;
+	rendered->buffers = calloc(rendered->num_chunks > 0 ? rendered->num_chunks : 1, sizeof(char*));
+	rendered->lengths = calloc(rendered->num_chunks > 0 ? rendered->num_chunks : 1, sizeof(size_t));
+	if (rendered->buffers == NULL || rendered->lengths == NULL) {
+		free_rendered_seats(rendered);
+		return 1;
+	}
+
+	long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t number_of_helpers = rendered->num_chunks > 1 ? rendered->num_chunks - 1 : 0;
+	if (number_of_helpers > RENDER_MAX_THREADS - 1) {
+		number_of_helpers = RENDER_MAX_THREADS - 1;
+	}
+	if (online_cpus > 0 && number_of_helpers > (size_t) online_cpus - 1) {
+		number_of_helpers = (size_t) online_cpus - 1;
+	}
+
+	pthread_t helpers[RENDER_MAX_THREADS];
+	size_t created = 0;
+
+	for (size_t i = 0; i < number_of_helpers; i++) {
+		if (pthread_create(&helpers[created], NULL, render_chunks_thread, &work) == 0) {
+			created++;
+		}
+	}
+
+	render_chunks_thread(&work); /// the calling thread formats chunks too (and all of them if no helper could be created)
+
+	for (size_t i = 0; i < created; i++) {
+		pthread_join(helpers[i], NULL);
+	}
+
+	if (atomic_load(&work.failed)) {
+		free_rendered_seats(rendered);
+		return 1;
+	}
+
+	return 0;
+}
+
+int write_rendered_seats(int fd, const rendered_seats* rendered) {
+	for (size_t chunk = 0; chunk < rendered->num_chunks; chunk++) {
+		size_t written = 0;
+
+		while (written < rendered->lengths[chunk]) { /// large chunks may be written in several calls
+			ssize_t result = write(fd, rendered->buffers[chunk] + written, rendered->lengths[chunk] - written);
+			if (result <= 0) {
+				return 1;
+			}
+			written += (size_t) result;
+		}
+	}
+
+	return 0;
+}
+
+void free_rendered_seats(rendered_seats* rendered) {
+	if (rendered->buffers != NULL) {
+		for (size_t chunk = 0; chunk < rendered->num_chunks; chunk++) {
+			free(rendered->buffers[chunk]);
+		}
+	}
+
+	free(rendered->buffers);
+	free(rendered->lengths);
+	rendered->buffers = NULL;
+	rendered->lengths = NULL;
+	rendered->num_chunks = 0;
+}
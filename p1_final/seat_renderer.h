@@ -0,0 +1,35 @@
+#ifndef SEAT_RENDERER_H
+#define SEAT_RENDERER_H
+
+#include <stddef.h>
+
+#define RENDER_PARALLEL_MIN_SEATS (1 << 18) /// events with fewer seats are formatted by the calling thread alone
+#define RENDER_CHUNK_SEATS (1 << 16) /// approximate number of seats of each chunk of rows formatted by a thread
+#define RENDER_MAX_THREADS 8 /// maximum number of threads formatting an event (including the calling one)
+
+/// Seats of an event formatted as text (one line per row, seats separated by spaces), in chunks of rows.
+typedef struct {
+	char** buffers; /// Text of each chunk, in order.
+	size_t* lengths; /// Number of bytes of each chunk.
+	size_t num_chunks; /// Number of chunks.
+} rendered_seats;
+
+/// Formats the seats of an event. Large events are split into chunks of rows formatted in parallel by helper threads.
+/// @param seats Reservation ids of the seats, row by row (a copy, so that no lock is held while formatting).
+/// @param rows Number of rows.
+/// @param cols Number of columns.
+/// @param rendered Pointer to the variable to store the text in (to be freed with free_rendered_seats).
+/// @return 0 if the seats were formatted successfully, 1 otherwise.
+int render_seats(const unsigned int* seats, size_t rows, size_t cols, rendered_seats* rendered);
+
+/// Writes formatted seats to a file descriptor, chunk by chunk.
+/// @param fd File descriptor to write to.
+/// @param rendered Formatted seats.
+/// @return 0 if everything was written, 1 otherwise.
+int write_rendered_seats(int fd, const rendered_seats* rendered);
+
+/// Frees formatted seats.
+/// @param rendered Formatted seats to free.
+void free_rendered_seats(rendered_seats* rendered);
+
+#endif  // SEAT_RENDERER_H
@@ -0,0 +1,221 @@
+#include "seatmap.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEATMAP_INITIAL_TABLE_SIZE 16 /// number of slots of the hash table of a new sparse map
+#ifndef SEATMAP_PROMOTE_DIVISOR /// can be set when building, to compare thresholds (see jobs/run_seatmap_bench.sh)
+#define SEATMAP_PROMOTE_DIVISOR 8 /// a sparse map is promoted once more than 1 / SEATMAP_PROMOTE_DIVISOR of its seats are occupied (a hash table slot at half load costs about 8 dense seats)
+#endif
+
+/// Hashes the key of a seat into a slot of the hash table.
+static size_t slot_of(const struct SeatMap* map, size_t key) {
+	uint64_t hash = (uint64_t) key * 0x9E3779B97F4A7C15ULL;
+	hash ^= hash >> 32;
+	return (size_t) hash & (map->sparse.table_size - 1);
+}
+
+/// Finds the slot holding the given key, or the empty slot where it would be inserted.
+static size_t find_slot(const struct SeatMap* map, size_t key) {
+	size_t mask = map->sparse.table_size - 1;
+	size_t slot = slot_of(map, key);
+
+	while (map->sparse.table[slot].key != 0 && map->sparse.table[slot].key != key) {
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+/// Removes the entry in the given slot, shifting back the entries of the same probe sequence.
+static void remove_slot(struct SeatMap* map, size_t hole) {
+	size_t mask = map->sparse.table_size - 1;
+	size_t next = (hole + 1) & mask;
+
+	while (map->sparse.table[next].key != 0) {
+		size_t home = slot_of(map, map->sparse.table[next].key);
+
+		/// the entry can fill the hole if its home slot is not cyclically inside (hole, next]
+		int home_in_range = hole < next ? (home > hole && home <= next) : (home > hole || home <= next);
+		if (!home_in_range) {
+			map->sparse.table[hole] = map->sparse.table[next];
+			hole = next;
+		}
+
+		next = (next + 1) & mask;
+	}
+
+	map->sparse.table[hole].key = 0;
+	map->sparse.table[hole].reservation_id = 0;
+}
+
+/// Moves the entries of a sparse map to a hash table with the given number of slots.
+/// @return 0 if the table was resized successfully, 1 otherwise.
+static int resize_table(struct SeatMap* map, size_t table_size) {
+	struct SeatEntry* old_table = map->sparse.table;
+	size_t old_size = map->sparse.table_size;
+
+	struct SeatEntry* table = calloc(table_size, sizeof(struct SeatEntry));
+	if (table == NULL) {
+		return 1;
+	}
+
+	map->sparse.table = table;
+	map->sparse.table_size = table_size;
+
+	for (size_t i = 0; i < old_size; i++) {
+		if (old_table[i].key != 0) {
+			map->sparse.table[find_slot(map, old_table[i].key)] = old_table[i];
+		}
+	}
+
+	free(old_table);
+	return 0;
+}
+
+/// Moves the entries of a sparse map to a dense array.
+/// @return 0 if the map was promoted successfully, 1 otherwise.
+static int promote_to_dense(struct SeatMap* map) {
+	unsigned int* dense = calloc(map->num_seats, sizeof(unsigned int));
+	if (dense == NULL) {
+		return 1;
+	}
+
+	for (size_t i = 0; i < map->sparse.table_size; i++) {
+		if (map->sparse.table[i].key != 0) {
+			dense[map->sparse.table[i].key - 1] = map->sparse.table[i].reservation_id;
+		}
+	}
+
+	free(map->sparse.table);
+	map->layout = SEATMAP_DENSE;
+	map->array = dense;
+	return 0;
+}
+
+size_t seatmap_inline_size(size_t num_seats) {
+	return num_seats <= SEATMAP_INLINE_CAPACITY ? num_seats * sizeof(unsigned int) : 0;
+}
+
+int seatmap_init(struct SeatMap* map, size_t num_seats, unsigned int* inline_seats) {
+	map->num_seats = num_seats;
+	map->occupied = 0;
+
+	if (num_seats <= SEATMAP_INLINE_CAPACITY) { /// small events don't need any extra memory
+		map->layout = SEATMAP_INLINE;
+		map->array = inline_seats;
+		memset(inline_seats, 0, seatmap_inline_size(num_seats));
+		return 0;
+	}
+
+	map->layout = SEATMAP_SPARSE;
+	map->sparse.table = calloc(SEATMAP_INITIAL_TABLE_SIZE, sizeof(struct SeatEntry));
+	map->sparse.table_size = SEATMAP_INITIAL_TABLE_SIZE;
+	return map->sparse.table == NULL;
+}
+
+int seatmap_init_array(struct SeatMap* map, size_t num_seats, unsigned int* inline_seats) {
+	if (num_seats <= SEATMAP_INLINE_CAPACITY) {
+		return seatmap_init(map, num_seats, inline_seats);
+	}
+
+	map->num_seats = num_seats;
+	map->occupied = 0;
+	map->layout = SEATMAP_DENSE;
+	map->array = calloc(num_seats, sizeof(unsigned int));
+	return map->array == NULL;
+}
+
+void seatmap_destroy(struct SeatMap* map) {
+	if (map->layout == SEATMAP_DENSE) { /// inline seats are freed with the owner of the map
+		free(map->array);
+	} else if (map->layout == SEATMAP_SPARSE) {
+		free(map->sparse.table);
+	}
+
+	map->layout = SEATMAP_INLINE;
+	map->num_seats = 0;
+}
+
+unsigned int seatmap_sparse_get(const struct SeatMap* map, size_t index) {
+	size_t slot = find_slot(map, index + 1);
+	return map->sparse.table[slot].reservation_id; /// an empty slot has reservation id 0
+}
+
+int seatmap_sparse_set(struct SeatMap* map, size_t index, unsigned int reservation_id) {
+	size_t key = index + 1;
+	size_t slot = find_slot(map, key);
+
+	if (map->sparse.table[slot].key == key) { /// the seat is occupied
+		if (reservation_id != 0) {
+			map->sparse.table[slot].reservation_id = reservation_id;
+		} else {
+			remove_slot(map, slot);
+			map->occupied--;
+		}
+		return 0;
+	}
+
+	if (reservation_id == 0) { /// the seat is already free
+		return 0;
+	}
+
+	if (map->occupied + 1 > map->num_seats / SEATMAP_PROMOTE_DIVISOR && promote_to_dense(map) == 0) {
+		return seatmap_set(map, index, reservation_id);
+	}
+
+	if ((map->occupied + 1) * 2 > map->sparse.table_size) { /// keep the load of the hash table under 1/2
+		if (resize_table(map, map->sparse.table_size * 2) != 0) {
+			return 1;
+		}
+		slot = find_slot(map, key);
+	}
+
+	map->sparse.table[slot].key = key;
+	map->sparse.table[slot].reservation_id = reservation_id;
+	map->occupied++;
+	return 0;
+}
+
+void seatmap_copy(const struct SeatMap* map, unsigned int* seats) {
+	switch (map->layout) {
+		case SEATMAP_INLINE:
+		case SEATMAP_DENSE:
+			memcpy(seats, map->array, map->num_seats * sizeof(unsigned int));
+			break;
+		case SEATMAP_SPARSE:
+		default:
+			memset(seats, 0, map->num_seats * sizeof(unsigned int));
+			for (size_t i = 0; i < map->sparse.table_size; i++) {
+				if (map->sparse.table[i].key != 0) {
+					seats[map->sparse.table[i].key - 1] = map->sparse.table[i].reservation_id;
+				}
+			}
+			break;
+	}
+}
+
+int seatmap_next_occupied(const struct SeatMap* map, size_t* cursor, size_t* index, unsigned int* reservation_id) {
+	if (map->layout == SEATMAP_SPARSE) { /// the cursor is a slot of the hash table
+		for (; *cursor < map->sparse.table_size; (*cursor)++) {
+			if (map->sparse.table[*cursor].key != 0) {
+				*index = map->sparse.table[*cursor].key - 1;
+				*reservation_id = map->sparse.table[(*cursor)++].reservation_id;
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	/// the cursor is the index of a seat
+	const unsigned int* seats = map->array;
+	for (; *cursor < map->num_seats; (*cursor)++) {
+		if (seats[*cursor] != 0) {
+			*index = *cursor;
+			*reservation_id = seats[(*cursor)++];
+			return 1;
+		}
+	}
+	return 0;
+}
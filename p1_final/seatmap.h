@@ -0,0 +1,135 @@
+#ifndef SEAT_MAP_H
+#define SEAT_MAP_H
+
+#include <stddef.h>
+
+#ifndef SEATMAP_INLINE_CAPACITY /// can be set when building, to compare capacities (see jobs/run_seatmap_bench.sh)
+#define SEATMAP_INLINE_CAPACITY 64 /// events with up to this many seats keep them in the memory of the event itself
+#endif
+
+/// Where the seats of a seat map are stored.
+enum SeatLayout {
+	SEATMAP_INLINE, /// In an array allocated with the owner of the seat map (small events, no extra allocation).
+	SEATMAP_DENSE, /// In a heap array with one entry per seat.
+	SEATMAP_SPARSE /// In a heap hash table with only the occupied seats.
+};
+
+/// Occupied seat stored in the hash table of a sparse seat map.
+struct SeatEntry {
+	size_t key; /// Index of the seat + 1 (0 marks an empty slot).
+	unsigned int reservation_id; /// Reservation id of the seat.
+};
+
+/// Reservation ids of the seats of an event.
+/// Small events keep their seats in an array allocated together with the event (sized for their own seats).
+/// Large events start sparse (only the occupied seats are stored, in a hash table) and are promoted to a dense
+/// array once enough seats are occupied. The layout is chosen for each map when it is initialized, and reads
+/// and writes check it (the inline and dense layouts are read the same way).
+struct SeatMap {
+	enum SeatLayout layout; /// Where the seats are stored.
+	size_t num_seats; /// Number of seats (rows * cols).
+	size_t occupied; /// Number of seats with a reservation.
+
+	union {
+		unsigned int* array; /// Array of size num_seats with the reservations for each seat (SEATMAP_INLINE, SEATMAP_DENSE).
+		struct {
+			struct SeatEntry* table; /// Open addressing hash table with the occupied seats.
+			size_t table_size; /// Number of slots of the hash table (power of two).
+		} sparse; /// Occupied seats (SEATMAP_SPARSE).
+	};
+};
+
+/// Gets the size of the memory to allocate with the owner of a seat map for its inline seats.
+/// @param num_seats Number of seats.
+/// @return Size in bytes (0 if the seats are not inline).
+size_t seatmap_inline_size(size_t num_seats);
+
+/// Initializes a seat map with all the seats free.
+/// @param map Seat map to initialize.
+/// @param num_seats Number of seats.
+/// @param inline_seats Memory of seatmap_inline_size(num_seats) bytes that lives as long as the map (allocated with its owner).
+/// @return 0 if the seat map was initialized successfully, 1 otherwise.
+int seatmap_init(struct SeatMap* map, size_t num_seats, unsigned int* inline_seats);
+
+/// Initializes a seat map with all the seats free in an array (inline or dense), which is never promoted or moved.
+/// Different seats of such a map can be accessed concurrently.
+/// @param map Seat map to initialize.
+/// @param num_seats Number of seats.
+/// @param inline_seats Memory of seatmap_inline_size(num_seats) bytes that lives as long as the map (allocated with its owner).
+/// @return 0 if the seat map was initialized successfully, 1 otherwise.
+int seatmap_init_array(struct SeatMap* map, size_t num_seats, unsigned int* inline_seats);
+
+/// Frees the memory used by a seat map.
+/// @param map Seat map to destroy.
+void seatmap_destroy(struct SeatMap* map);
+
+/// Gets the reservation id of a seat of a sparse seat map.
+/// @param map Seat map to read from.
+/// @param index Index of the seat (must be lower than the number of seats).
+/// @return Reservation id of the seat, 0 if the seat is free.
+unsigned int seatmap_sparse_get(const struct SeatMap* map, size_t index);
+
+/// Sets the reservation id of a seat of a sparse seat map (it may be promoted to a dense one).
+/// @param map Seat map to modify.
+/// @param index Index of the seat (must be lower than the number of seats).
+/// @param reservation_id Reservation id to store, 0 to free the seat.
+/// @return 0 if the seat was set successfully, 1 otherwise (out of memory).
+int seatmap_sparse_set(struct SeatMap* map, size_t index, unsigned int reservation_id);
+
+/// Copies the reservation ids of all the seats of a seat map, with one loop for its layout (instead of
+/// checking the layout for every seat, which for a sparse map is a lookup in the hash table per seat).
+/// @param map Seat map to read from.
+/// @param seats Array of map->num_seats entries to store the reservation ids in (0 for the free seats).
+void seatmap_copy(const struct SeatMap* map, unsigned int* seats);
+
+/// Finds the next occupied seat of a seat map (in index order, except for sparse maps).
+/// @param map Seat map to read from.
+/// @param cursor Position of the iteration (0 before the first call), updated by each call.
+/// @param index Pointer to the variable to store the index of the seat in.
+/// @param reservation_id Pointer to the variable to store the reservation id of the seat in.
+/// @return 1 if an occupied seat was found, 0 if there are no more.
+int seatmap_next_occupied(const struct SeatMap* map, size_t* cursor, size_t* index, unsigned int* reservation_id);
+
+/// Gets a pointer to a seat of a seat map whose seats are in an array (inline or dense).
+/// @param map Seat map to read from.
+/// @param index Index of the seat (must be lower than the number of seats).
+/// @return Pointer to the reservation id of the seat.
+static inline unsigned int* seatmap_array_seat(struct SeatMap* map, size_t index) {
+	return &map->array[index];
+}
+
+/// Gets the reservation id of a seat.
+/// @param map Seat map to read from.
+/// @param index Index of the seat (must be lower than the number of seats).
+/// @return Reservation id of the seat, 0 if the seat is free.
+static inline unsigned int seatmap_get(const struct SeatMap* map, size_t index) {
+	if (map->layout == SEATMAP_SPARSE) {
+		return seatmap_sparse_get(map, index);
+	}
+
+	return map->array[index];
+}
+
+/// Sets the reservation id of a seat.
+/// @param map Seat map to modify.
+/// @param index Index of the seat (must be lower than the number of seats).
+/// @param reservation_id Reservation id to store, 0 to free the seat.
+/// @return 0 if the seat was set successfully, 1 otherwise (out of memory).
+static inline int seatmap_set(struct SeatMap* map, size_t index, unsigned int reservation_id) {
+	if (map->layout == SEATMAP_SPARSE) {
+		return seatmap_sparse_set(map, index, reservation_id);
+	}
+
+	unsigned int* seat = seatmap_array_seat(map, index);
+
+	if (*seat == 0 && reservation_id != 0) {
+		map->occupied++;
+	} else if (*seat != 0 && reservation_id == 0) {
+		map->occupied--;
+	}
+
+	*seat = reservation_id;
+	return 0;
+}
+
+#endif  // SEAT_MAP_H
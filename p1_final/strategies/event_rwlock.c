@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <pthread.h>
+
+#include "../vclock.h"
+#include "../instrumentation/trace.h"
+#include "../instrumentation/lockprof.h"
+#include "strategy.h"
+
+static lock_stats event_read_stats = {"event rwlocks (read)", 0, 0, 0, 0, 0}; /// read acquisitions of the rwlocks of all the events
+static lock_stats event_write_stats = {"event rwlocks (write)", 0, 0, 0, 0, 0}; /// write acquisitions of the rwlocks of all the events
+static lock_stats* const profiled_locks[] = {&event_read_stats, &event_write_stats};
+
+static _Thread_local uint64_t event_acquired_ns; /// time at which the calling thread acquired the rwlock of an event (it holds one at most)
+static _Thread_local lock_stats* event_lock_stats; /// statistics of the rwlock of an event held by the calling thread
+
+/// Locks the rwlock of an event for reading.
+/// @param event Event to lock.
+static void rdlock_event(struct Event* event) {
+	uint64_t wait_start = trace_begin();
+	event_acquired_ns = lockprof_rdlock(&event->rwlock, &event_read_stats);
+	event_lock_stats = &event_read_stats;
+	trace_end(wait_start, "lock wait", event_read_stats.name, event->id);
+	vclock_acquire(&event->release_time);
+}
+
+/// Locks the rwlock of an event for writing.
+/// @param event Event to lock.
+static void wrlock_event(struct Event* event) {
+	uint64_t wait_start = trace_begin();
+	event_acquired_ns = lockprof_wrlock(&event->rwlock, &event_write_stats);
+	event_lock_stats = &event_write_stats;
+	trace_end(wait_start, "lock wait", event_write_stats.name, event->id);
+	vclock_acquire(&event->release_time);
+}
+
+/// Unlocks the rwlock of an event.
+/// @param event Event to unlock.
+static void unlock_event(struct Event* event) {
+	vclock_release(&event->release_time);
+	lockprof_rwlock_unlock(&event->rwlock, event_lock_stats, event_acquired_ns);
+}
+
+static int reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+
+	wrlock_event(event); /// lock the event-specific rwlock for writing
+	unsigned int reservation_id = ++event->reservations;
+
+	size_t i = 0;
+	
+	for (; i < num_seats; i++) {
+		size_t row = xs[i];
+		size_t col = ys[i];
+
+		if (!seat_exists(event, row, col)) {
+			fprintf(stderr, "Invalid seat\n");
+			break;
+		}
+
+		if (get_seat_with_delay(event, seat_index(event, row, col)) != 0) {
+			fprintf(stderr, "Seat already reserved\n");
+			break;
+		}
+
+		if (set_seat_with_delay(event, seat_index(event, row, col), reservation_id) != 0) {
+			fprintf(stderr, "Error: Error allocating memory for event data\n");
+			break;
+		}
+	}
+
+	// If the reservation was not successful, free the seats that were reserved (still holding the lock, so no one sees them).
+	if (i < num_seats) {
+		for (size_t j = 0; j < i; j++) {
+			set_seat_with_delay(event, seat_index(event, xs[j], ys[j]), 0); /// freeing a seat never allocates memory
+		}
+		release_reservation_id(event, reservation_id);
+		unlock_event(event); /// unlock the event-specific rwlock
+		return 1;
+	}
+
+	unlock_event(event); /// unlock the event-specific rwlock
+
+	return 0;
+}
+
+static int show(unsigned int event_id, int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+	
+	rdlock_event(event); /// lock the event-specific rwlock for reading
+
+	unsigned int* seats = copy_event_seats(event, NULL); /// the seats can't change while they are copied
+	unlock_event(event); /// unlock the event-specific rwlock (reservations can go on while the copy is written)
+
+	if (seats == NULL) {
+		return 1;
+	}
+
+	return write_event_seats(output_fd, event, seats, output_write_mutex);
+}
+
+const ems_strategy event_rwlock_strategy = {"rwlock", 0, NULL, reserve, show, profiled_locks, 2};
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <pthread.h>
+
+#include "strategy.h"
+
+/// Every operation holds the general mutex for events until it ends, so the per-event rwlocks are never needed.
+
+static int reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex) {
+	lock_mutex(events_general_mutex, &events_general_info); /// lock the general mutex for events (held for the whole reservation)
+
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+		return 1;
+	}
+
+	unsigned int reservation_id = ++event->reservations;
+	size_t i = 0;
+
+	for (; i < num_seats; i++) {
+		size_t row = xs[i];
+		size_t col = ys[i];
+
+		if (!seat_exists(event, row, col)) {
+			fprintf(stderr, "Invalid seat\n");
+			break;
+		}
+
+		if (get_seat_with_delay(event, seat_index(event, row, col)) != 0) {
+			fprintf(stderr, "Seat already reserved\n");
+			break;
+		}
+
+		if (set_seat_with_delay(event, seat_index(event, row, col), reservation_id) != 0) {
+			fprintf(stderr, "Error: Error allocating memory for event data\n");
+			break;
+		}
+	}
+
+	// If the reservation was not successful, free the seats that were reserved (still holding the lock, so no one sees them).
+	if (i < num_seats) {
+		for (size_t j = 0; j < i; j++) {
+			set_seat_with_delay(event, seat_index(event, xs[j], ys[j]), 0); /// freeing a seat never allocates memory
+		}
+		release_reservation_id(event, reservation_id);
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+		return 1;
+	}
+
+	unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+
+	return 0;
+}
+
+static int show(unsigned int event_id, int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
+	lock_mutex(events_general_mutex, &events_general_info); /// lock the general mutex for events (held until the seats are copied)
+
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+		return 1;
+	}
+
+	unsigned int* seats = copy_event_seats(event, NULL); /// the seats can't change while they are copied
+	unlock_mutex(events_general_mutex, &events_general_info); /// unlock the general mutex for events
+
+	if (seats == NULL) {
+		return 1;
+	}
+
+	return write_event_seats(output_fd, event, seats, output_write_mutex);
+}
+
+const ems_strategy global_lock_strategy = {"global", 0, NULL, reserve, show, NULL, 0};
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <pthread.h>
+
+#include "strategy.h"
+
+/// Seats are claimed one by one with a compare-and-swap from free to the reservation id, so reservations never wait for each other
+/// (nor for the general mutex for events, as events are found without locking). A reservation that finds a taken seat frees the seats it claimed.
+/// SHOW reads the seats without locking, so it may see a reservation that is still being made or undone, but never a torn seat.
+/// The seats are kept in an array, so they never move while they are accessed.
+
+/// Gets the reservation id of a seat from the state.
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to get the seat from.
+/// @param index Index of the seat to get.
+/// @return Reservation id of the seat, 0 if the seat is free.
+static unsigned int load_seat(struct Event* event, size_t index) {
+	state_access_delay("seat read", event->id);
+
+	return __atomic_load_n(seatmap_array_seat(&event->seats, index), __ATOMIC_ACQUIRE);
+}
+
+/// Claims a free seat in the state.
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to claim the seat in.
+/// @param index Index of the seat to claim.
+/// @param reservation_id Reservation id to store.
+/// @return 1 if the seat was claimed, 0 if it was already taken.
+static int claim_seat(struct Event* event, size_t index, unsigned int reservation_id) {
+	state_access_delay("seat write", event->id);
+
+	unsigned int expected = 0;
+	return __atomic_compare_exchange_n(seatmap_array_seat(&event->seats, index), &expected, reservation_id, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/// Frees a seat claimed by the calling thread.
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to free the seat in.
+/// @param index Index of the seat to free.
+static void free_seat(struct Event* event, size_t index) {
+	state_access_delay("seat write", event->id);
+
+	__atomic_store_n(seatmap_array_seat(&event->seats, index), 0, __ATOMIC_RELEASE);
+}
+
+static int reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+
+	unsigned int reservation_id = ++event->reservations;
+	size_t i = 0;
+
+	for (; i < num_seats; i++) {
+		size_t row = xs[i];
+		size_t col = ys[i];
+
+		if (!seat_exists(event, row, col)) {
+			fprintf(stderr, "Invalid seat\n");
+			break;
+		}
+
+		/// the read avoids a failing compare-and-swap on seats that are clearly taken
+		if (load_seat(event, seat_index(event, row, col)) != 0 || !claim_seat(event, seat_index(event, row, col), reservation_id)) {
+			fprintf(stderr, "Seat already reserved\n");
+			break;
+		}
+	}
+
+	// If the reservation was not successful, free the seats that were claimed.
+	if (i < num_seats) {
+		for (size_t j = 0; j < i; j++) {
+			free_seat(event, seat_index(event, xs[j], ys[j]));
+		}
+		release_reservation_id(event, reservation_id);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int show(unsigned int event_id, int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+
+	unsigned int* seats = copy_event_seats(event, load_seat);
+
+	if (seats == NULL) {
+		return 1;
+	}
+
+	return write_event_seats(output_fd, event, seats, output_write_mutex);
+}
+
+const ems_strategy lock_free_strategy = {"lockfree", 1, NULL, reserve, show, NULL, 0};
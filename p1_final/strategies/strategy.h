@@ -0,0 +1,130 @@
+#ifndef EMS_STRATEGY_H
+#define EMS_STRATEGY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../eventlist.h"
+#include "../instrumentation/lockprof.h"
+
+/// Concurrency strategy of the EMS engine: how reservations and SHOW commands are synchronized.
+/// Creating, deleting and listing events always holds the general mutex for events, so those are shared by every strategy.
+/// Reservations and SHOW run in an epoch critical section, so the events they find stay valid even if they are deleted meanwhile.
+typedef struct {
+	const char* name; /// Name used to select the strategy (--strategy=<name>).
+	int array_seats; /// 1 if the seats of every event must be stored in an array (different seats can then be accessed concurrently).
+
+	/// Prepares the locks of a new event (NULL if the strategy doesn't need any beyond the event rwlock).
+	/// @param event Event being created (not yet visible to other threads).
+	/// @return 0 if the event was prepared successfully, 1 otherwise.
+	int (*init_event)(struct Event* event);
+
+	/// Creates a new reservation for the given event (see ems_reserve).
+	int (*reserve)(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex);
+
+	/// Prints the given event (see ems_show).
+	int (*show)(unsigned int event_id, int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex);
+
+	lock_stats* const* profiled_locks; /// Statistics of the locks of the strategy, reported by ems_terminate.
+	int num_profiled_locks; /// Number of entries of profiled_locks.
+} ems_strategy;
+
+extern const ems_strategy global_lock_strategy; /// Every operation holds the general mutex for events from start to end.
+extern const ems_strategy event_rwlock_strategy; /// Events are found without locking, each event has its own rwlock (default).
+extern const ems_strategy striped_locks_strategy; /// Each event has a mutex per stripe of rows, reservations only lock the stripes they touch.
+extern const ems_strategy lock_free_strategy; /// Seats are claimed with compare-and-swap, SHOW reads them without locking.
+
+/// Bookkeeping of a mutex shared by all the operations (the mutex itself is owned by the caller).
+typedef struct {
+	lock_stats stats; /// Contention statistics of the mutex (with its name, also used in traces).
+	uint64_t acquired_ns; /// Time at which the current holder acquired the mutex (lock profiling).
+	atomic_ullong release_time; /// Logical time at which the mutex was last released (virtual time mode).
+} mutex_info;
+
+/// The helpers below are shared by the strategies (implemented in operations.c).
+
+extern mutex_info events_general_info; /// Bookkeeping of the general mutex for events.
+extern mutex_info output_info; /// Bookkeeping of the mutex of the output.
+
+/// Locks a mutex and synchronizes the logical clock of the thread with its last release (virtual time mode).
+/// @param mutex Mutex to lock.
+/// @param info Bookkeeping of the mutex.
+void lock_mutex(pthread_mutex_t* mutex, mutex_info* info);
+
+/// Unlocks a mutex, recording the logical time of the release (virtual time mode).
+/// @param mutex Mutex to unlock.
+/// @param info Bookkeeping of the mutex.
+void unlock_mutex(pthread_mutex_t* mutex, mutex_info* info);
+
+/// Waits to simulate a real system accessing a costly memory resource.
+/// @param name Name of the access (used in traces).
+/// @param event_id Id of the event being accessed.
+void state_access_delay(const char* name, unsigned int event_id);
+
+/// Gets the event with the given ID from the state.
+/// The caller must hold the general mutex for events, or be in an epoch critical section (reserve and show always are).
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event_id The ID of the event to get.
+/// @return Pointer to the event if found, NULL otherwise.
+struct Event* get_event_with_delay(unsigned int event_id);
+
+/// Gets the reservation id of the seat with the given index from the state.
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to get the seat from.
+/// @param index Index of the seat to get.
+/// @return Reservation id of the seat, 0 if the seat is free.
+unsigned int get_seat_with_delay(struct Event* event, size_t index);
+
+/// Sets the reservation id of the seat with the given index in the state.
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to set the seat in.
+/// @param index Index of the seat to set.
+/// @param reservation_id Reservation id to store, 0 to free the seat.
+/// @return 0 if the seat was set successfully, 1 otherwise.
+int set_seat_with_delay(struct Event* event, size_t index, unsigned int reservation_id);
+
+/// Gets the index of a seat.
+/// @note This function assumes that the seat exists.
+/// @param event Event to get the seat index from.
+/// @param row Row of the seat.
+/// @param col Column of the seat.
+/// @return Index of the seat.
+static inline size_t seat_index(struct Event* event, size_t row, size_t col) { return (row - 1) * event->cols + col - 1; }
+
+/// Checks if a seat exists in an event.
+/// @param event Event to check.
+/// @param row Row of the seat.
+/// @param col Column of the seat.
+/// @return 1 if the seat exists, 0 otherwise.
+static inline int seat_exists(struct Event* event, size_t row, size_t col) {
+	return row > 0 && row <= event->rows && col > 0 && col <= event->cols;
+}
+
+/// Gives back the id of a failed reservation if no reservation was created after it, so ids stay consecutive.
+/// @param event Event of the reservation.
+/// @param reservation_id Id of the failed reservation (its seats must have been freed).
+static inline void release_reservation_id(struct Event* event, unsigned int reservation_id) {
+	unsigned int expected = reservation_id;
+	atomic_compare_exchange_strong(&event->reservations, &expected, reservation_id - 1);
+}
+
+/// Copies the seats of an event, so that they can be written without holding the locks of the event.
+/// The caller must hold whatever lock keeps reservations of the event from being half done (if any).
+/// @param event Event to copy the seats from.
+/// @param read_seat Function that reads a seat of the event (with the simulated delay), or NULL to read them like
+/// get_seat_with_delay does (with the same delays) but all at once, with one loop for the layout of the seat map.
+/// @return Reservation ids of the seats row by row (to be given to write_event_seats), NULL on failure.
+unsigned int* copy_event_seats(struct Event* event, unsigned int (*read_seat)(struct Event* event, size_t index));
+
+/// Writes a copy of the seats of an event to the output, one row per line, and frees the copy.
+/// The seats are formatted before locking the output (large events in parallel, see render_seats), so the lock is only held while writing.
+/// @param output_fd File descriptor to write the event to.
+/// @param event Event the seats belong to.
+/// @param seats Seats returned by copy_event_seats.
+/// @param output_write_mutex Mutex of the output stream.
+/// @return 0 if the event was written successfully, 1 otherwise.
+int write_event_seats(int output_fd, struct Event* event, unsigned int* seats, pthread_mutex_t* output_write_mutex);
+
+#endif  // EMS_STRATEGY_H
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../vclock.h"
+#include "../instrumentation/trace.h"
+#include "../instrumentation/lockprof.h"
+#include "strategy.h"
+
+/// Each event has a mutex per stripe of rows (row r belongs to stripe (r - 1) % num_stripes), locked in ascending order.
+/// Reservations only lock the stripes of the rows they touch, so reservations of different rows of the same event run in parallel.
+/// SHOW locks every stripe, so it still sees whole reservations. The seats are kept in an array, so writing different seats never races.
+
+#define MAX_STRIPES 64 /// the stripes locked by a reservation are recorded in a 64 bit mask
+
+static lock_stats stripe_stats = {"event row stripes", 0, 0, 0, 0, 0}; /// acquisitions of the stripes of all the events
+static lock_stats* const profiled_locks[] = {&stripe_stats};
+
+static int init_event(struct Event* event) {
+	event->num_stripes = event->rows < MAX_STRIPES ? event->rows : MAX_STRIPES;
+	if (event->num_stripes == 0) {
+		return 0;
+	}
+
+	event->stripes = malloc(event->num_stripes * sizeof(struct EventStripe));
+	if (event->stripes == NULL) {
+		event->num_stripes = 0;
+		return 1;
+	}
+
+	for (size_t i = 0; i < event->num_stripes; i++) {
+		pthread_mutex_init(&event->stripes[i].mutex, NULL);
+		event->stripes[i].acquired_ns = 0;
+		atomic_init(&event->stripes[i].release_time, vclock_now());
+	}
+
+	return 0;
+}
+
+/// Gets the stripes of all the rows of an event.
+/// @param event Event to get the stripes of.
+/// @return Mask with a bit set for each stripe.
+static uint64_t all_stripes(struct Event* event) {
+	return event->num_stripes == MAX_STRIPES ? ~0ULL : (1ULL << event->num_stripes) - 1;
+}
+
+/// Locks the given stripes of an event in ascending order (so two threads never wait for each other's stripes).
+/// @param event Event to lock.
+/// @param stripes Mask with a bit set for each stripe to lock.
+static void lock_stripes(struct Event* event, uint64_t stripes) {
+	for (size_t i = 0; i < event->num_stripes; i++) {
+		if (stripes & (1ULL << i)) {
+			struct EventStripe* stripe = &event->stripes[i];
+			uint64_t wait_start = trace_begin();
+			uint64_t acquired_ns = lockprof_mutex_lock(&stripe->mutex, &stripe_stats);
+			stripe->acquired_ns = acquired_ns; /// only written by the holder
+			trace_end(wait_start, "lock wait", stripe_stats.name, event->id);
+			vclock_acquire(&stripe->release_time);
+		}
+	}
+}
+
+/// Unlocks the given stripes of an event.
+/// @param event Event to unlock.
+/// @param stripes Mask with a bit set for each stripe to unlock.
+static void unlock_stripes(struct Event* event, uint64_t stripes) {
+	for (size_t i = event->num_stripes; i-- > 0;) {
+		if (stripes & (1ULL << i)) {
+			struct EventStripe* stripe = &event->stripes[i];
+			vclock_release(&stripe->release_time);
+			lockprof_mutex_unlock(&stripe->mutex, &stripe_stats, stripe->acquired_ns);
+		}
+	}
+}
+
+/// Sets the reservation id of a seat in the state (unlike set_seat_with_delay, it doesn't count the occupied seats,
+/// which would be shared by all the stripes).
+/// @note Will wait to simulate a real system accessing a costly memory resource.
+/// @param event Event to set the seat in.
+/// @param index Index of the seat to set.
+/// @param reservation_id Reservation id to store, 0 to free the seat.
+static void write_seat(struct Event* event, size_t index, unsigned int reservation_id) {
+	state_access_delay("seat write", event->id);
+
+	*seatmap_array_seat(&event->seats, index) = reservation_id;
+}
+
+static int reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+
+	uint64_t stripes = 0;
+	for (size_t i = 0; i < num_seats && seat_exists(event, xs[i], ys[i]); i++) { /// the seats after an invalid one are never accessed
+		stripes |= 1ULL << ((xs[i] - 1) % event->num_stripes);
+	}
+
+	lock_stripes(event, stripes); /// lock the stripes of the rows of the reservation
+
+	unsigned int reservation_id = ++event->reservations; /// reservations of other stripes may take ids at the same time
+	size_t i = 0;
+
+	for (; i < num_seats; i++) {
+		size_t row = xs[i];
+		size_t col = ys[i];
+
+		if (!seat_exists(event, row, col)) {
+			fprintf(stderr, "Invalid seat\n");
+			break;
+		}
+
+		if (get_seat_with_delay(event, seat_index(event, row, col)) != 0) {
+			fprintf(stderr, "Seat already reserved\n");
+			break;
+		}
+
+		write_seat(event, seat_index(event, row, col), reservation_id);
+	}
+
+	// If the reservation was not successful, free the seats that were reserved (still holding the stripes, so no one sees them).
+	if (i < num_seats) {
+		for (size_t j = 0; j < i; j++) {
+			write_seat(event, seat_index(event, xs[j], ys[j]), 0);
+		}
+		release_reservation_id(event, reservation_id);
+		unlock_stripes(event, stripes);
+		return 1;
+	}
+
+	unlock_stripes(event, stripes);
+
+	return 0;
+}
+
+static int show(unsigned int event_id, int output_fd, pthread_mutex_t* output_write_mutex, pthread_mutex_t* events_general_mutex) {
+	(void) events_general_mutex; /// the events list is searched without locking (see ems_strategy)
+	struct Event* event = get_event_with_delay(event_id);
+
+	if (event == NULL) {
+		fprintf(stderr, "Event not found\n");
+		return 1;
+	}
+
+	lock_stripes(event, all_stripes(event)); /// no reservation can be half done while the seats are copied
+
+	unsigned int* seats = copy_event_seats(event, NULL); /// the seats can't change while they are copied
+	unlock_stripes(event, all_stripes(event));
+
+	if (seats == NULL) {
+		return 1;
+	}
+
+	return write_event_seats(output_fd, event, seats, output_write_mutex);
+}
+
+const ems_strategy striped_locks_strategy = {"striped", 1, init_event, reserve, show, profiled_locks, 1};
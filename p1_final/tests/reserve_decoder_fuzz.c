@@ -0,0 +1,355 @@
+/// Differential test of the RESERVE decoder against the byte by byte parser. Each case is parsed by parse_reserve
+/// twice: from a regular file (read ahead and decoded with decode_reserve) and from a pipe (read one byte at a time).
+/// Both must read the same coordinates and leave the input at the same byte.
+/// Usage: reserve_decoder_fuzz [number of cases] [seed]
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "parser.h"
+
+#define MAX_CASE_SIZE 49152 /// bytes of a case, so it fits in a pipe without a thread writing it
+#define MAX_SHORT_COORDS 8 /// coordinates of a line that doesn't aim at a buffer boundary
+
+/// Bytes of a case being generated.
+typedef struct {
+	char data[MAX_CASE_SIZE];
+	size_t size;
+} text;
+
+/// What parse_reserve read from a case.
+typedef struct {
+	size_t num_coords; /// Number of coordinates read (0 on failure).
+	unsigned int event_id; /// Event ID (only compared if the line was valid).
+	size_t *xs; /// Rows of the seats.
+	size_t *ys; /// Columns of the seats.
+	char rest[MAX_CASE_SIZE]; /// Bytes left in the input after parsing.
+	size_t rest_size; /// Number of bytes left.
+} parse_result;
+
+static uint64_t rng_state;
+
+/// Returns the next number of a xorshift64* generator.
+static uint64_t next_random(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/// Returns a random number in [0, bound).
+static size_t random_below(size_t bound) {
+	return (size_t)(next_random() % bound);
+}
+
+static void append(text *t, const char *bytes, size_t size) {
+	if (size > MAX_CASE_SIZE - t->size) {
+		size = MAX_CASE_SIZE - t->size;
+	}
+	memcpy(t->data + t->size, bytes, size);
+	t->size += size;
+}
+
+static void append_str(text *t, const char *str) {
+	append(t, str, strlen(str));
+}
+
+/// Appends a number, often one the parsers could disagree on: around UINT_MAX, with leading zeros, too long or empty.
+static void append_number(text *t) {
+	static const char *edge_cases[] = {
+		"0", "4294967295", "4294967296", "9999999999", "10000000000", "18446744073709551616",
+		"0000000000004294967295", "00000000000000000000001", "", "00",
+	};
+	char number[64];
+
+	switch (random_below(8)) {
+		case 0:
+		case 1:
+		case 2:
+			snprintf(number, sizeof(number), "%zu", random_below(100));
+			break;
+		case 3:
+			snprintf(number, sizeof(number), "%u", (unsigned int)next_random());
+			break;
+		case 4:
+			snprintf(number, sizeof(number), "%s", edge_cases[random_below(sizeof(edge_cases) / sizeof(edge_cases[0]))]);
+			break;
+		case 5: { /// long runs of digits, longer than any number that fits
+			size_t length = 11 + random_below(40);
+			for (size_t i = 0; i < length; i++) {
+				number[i] = (char)('0' + random_below(10));
+			}
+			number[length] = '\0';
+			break;
+		}
+		case 6: { /// leading zeros
+			size_t zeros = 1 + random_below(20);
+			memset(number, '0', zeros);
+			snprintf(number + zeros, sizeof(number) - zeros, "%zu", random_below(1000));
+			break;
+		}
+		default:
+			snprintf(number, sizeof(number), "%zu", 1 + random_below(9));
+			break;
+	}
+
+	append_str(t, number);
+}
+
+/// Appends a separator of the grammar, sometimes replaced by a whitespace variant or left out.
+static void append_separator(text *t, const char *expected) {
+	static const char *variants[] = {"", "  ", "\t", " \t", "\r", " ]", "( ", "\n", ",,", ")"};
+
+	if (random_below(40) == 0) {
+		append_str(t, variants[random_below(sizeof(variants) / sizeof(variants[0]))]);
+	} else {
+		append_str(t, expected);
+	}
+}
+
+/// Appends the end of a line: '\n' most of the time, or '\0', "\r\n", trailing whitespace or nothing (end of input).
+static void append_line_end(text *t) {
+	static const char *ends[] = {"\0", "\r\n", " \n", "\t\n", ""};
+
+	if (random_below(8) != 0) {
+		append_str(t, "\n");
+	} else {
+		size_t end = random_below(sizeof(ends) / sizeof(ends[0]));
+		append(t, ends[end], end == 0 ? 1 : strlen(ends[end]));
+	}
+}
+
+/// Appends the arguments of a RESERVE command with a few coordinates, mostly valid.
+static void append_short_line(text *t) {
+	append_number(t);
+	append_separator(t, " ");
+	append_separator(t, "[");
+
+	size_t num_coords = random_below(MAX_SHORT_COORDS + 1);
+	for (size_t i = 0; i < num_coords; i++) {
+		append_separator(t, "(");
+		append_number(t);
+		append_separator(t, ",");
+		append_number(t);
+		append_separator(t, ")");
+		append_separator(t, i + 1 < num_coords ? " " : "]");
+	}
+	if (num_coords == 0) {
+		append_separator(t, "]");
+	}
+
+	append_line_end(t);
+}
+
+/// Appends a valid line whose length is a few bytes away from a multiple of the buffer the decoder reads the line
+/// in (8192 bytes, doubled as needed), so the line and its '\n' are split between reads.
+static void append_boundary_line(text *t) {
+	size_t boundary = (size_t)8192 << random_below(3);
+	size_t target = boundary - 70 + random_below(141); /// length of the line, '\n' included
+
+	size_t start = t->size;
+	append_str(t, "1 [");
+	while (t->size - start + 24 < target) {
+		char coords[32];
+		snprintf(coords, sizeof(coords), "(%zu,%zu) ", 1 + random_below(999), 1 + random_below(999));
+		append_str(t, coords);
+	}
+
+	/// the last coordinate takes the bytes left, with leading zeros
+	size_t used = t->size - start + strlen("(,1)]\n");
+	size_t digits = target > used ? target - used : 1;
+	append_str(t, "(");
+	for (size_t i = 1; i < digits; i++) {
+		append_str(t, "0");
+	}
+	append_str(t, "7,1)]\n");
+}
+
+/// Changes a random byte of the case: removes it, duplicates it or replaces it (with a byte of the grammar, mostly).
+static void mutate(text *t) {
+	static const char alphabet[] = "0123456789()[], \t\n\rx";
+
+	if (t->size == 0) {
+		return;
+	}
+
+	size_t pos = random_below(t->size);
+	switch (random_below(4)) {
+		case 0:
+			memmove(t->data + pos, t->data + pos + 1, t->size - pos - 1);
+			t->size--;
+			break;
+		case 1:
+			if (t->size < MAX_CASE_SIZE) {
+				memmove(t->data + pos + 1, t->data + pos, t->size - pos);
+				t->size++;
+			}
+			break;
+		case 2:
+			t->data[pos] = alphabet[random_below(sizeof(alphabet) - 1)];
+			break;
+		default:
+			t->data[pos] = (char)random_below(256);
+			break;
+	}
+}
+
+/// Generates a case: a RESERVE line (random, adversarial or split across buffer boundaries) and what follows it.
+static void generate_case(text *t) {
+	t->size = 0;
+
+	if (random_below(20) == 0) {
+		append_boundary_line(t);
+	} else {
+		append_short_line(t);
+	}
+
+	size_t mutations = random_below(4) == 0 ? 1 + random_below(3) : 0;
+	for (size_t i = 0; i < mutations; i++) {
+		mutate(t);
+	}
+
+	if (random_below(10) == 0) { /// cut at a random byte (the input ends in the middle of the line)
+		t->size = random_below(t->size + 1);
+	} else { /// the next line, which both must leave unread
+		append_str(t, "SHOW 1\n");
+	}
+}
+
+/// Reads what is left of the input after parse_reserve.
+static void read_rest(int fd, parse_result *result) {
+	result->rest_size = 0;
+
+	ssize_t bytes_read;
+	while ((bytes_read = read(fd, result->rest + result->rest_size, MAX_CASE_SIZE - result->rest_size)) > 0) {
+		result->rest_size += (size_t)bytes_read;
+	}
+}
+
+/// Keeps the coordinates of the last parse (the scratch is reused by the next one).
+static void keep_coords(parse_result *result, const struct ParserScratch *scratch) {
+	result->xs = realloc(result->xs, (result->num_coords + 1) * sizeof(size_t));
+	result->ys = realloc(result->ys, (result->num_coords + 1) * sizeof(size_t));
+	if (result->xs == NULL || result->ys == NULL) {
+		fprintf(stderr, "Error: Memory allocation failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (result->num_coords > 0) {
+		memcpy(result->xs, scratch->xs, result->num_coords * sizeof(size_t));
+		memcpy(result->ys, scratch->ys, result->num_coords * sizeof(size_t));
+	}
+}
+
+/// Parses a case from a regular file (the decoder).
+static void parse_from_file(int file_fd, const text *t, struct ParserScratch *scratch, parse_result *result) {
+	if (ftruncate(file_fd, 0) != 0 || pwrite(file_fd, t->data, t->size, 0) != (ssize_t)t->size || lseek(file_fd, 0, SEEK_SET) != 0) {
+		fprintf(stderr, "Error: Failed to write the case\n");
+		exit(EXIT_FAILURE);
+	}
+
+	result->num_coords = parse_reserve(file_fd, &result->event_id, scratch);
+	keep_coords(result, scratch);
+	read_rest(file_fd, result);
+}
+
+/// Parses a case from a pipe (the byte by byte parser).
+static void parse_from_pipe(const text *t, struct ParserScratch *scratch, parse_result *result) {
+	int fds[2];
+	if (pipe(fds) != 0 || write(fds[1], t->data, t->size) != (ssize_t)t->size) {
+		fprintf(stderr, "Error: Failed to write the case\n");
+		exit(EXIT_FAILURE);
+	}
+	close(fds[1]);
+
+	result->num_coords = parse_reserve(fds[0], &result->event_id, scratch);
+	keep_coords(result, scratch);
+	read_rest(fds[0], result);
+	close(fds[0]);
+}
+
+/// Prints a case with the bytes outside of the grammar escaped.
+static void print_case(const text *t) {
+	for (size_t i = 0; i < t->size; i++) {
+		unsigned char ch = (unsigned char)t->data[i];
+		if (ch >= 0x20 && ch < 0x7f && ch != '\\') {
+			fputc(ch, stderr);
+		} else {
+			fprintf(stderr, "\\x%02x", ch);
+		}
+	}
+	fputc('\n', stderr);
+}
+
+/// Compares the results of both parsers.
+/// @return 0 if they are the same, 1 otherwise.
+static int compare(const parse_result *decoded, const parse_result *bytes) {
+	if (decoded->num_coords != bytes->num_coords) {
+		fprintf(stderr, "Coordinates read: %zu decoded, %zu byte by byte\n", decoded->num_coords, bytes->num_coords);
+		return 1;
+	}
+
+	if (decoded->num_coords > 0 && decoded->event_id != bytes->event_id) {
+		fprintf(stderr, "Event ID: %u decoded, %u byte by byte\n", decoded->event_id, bytes->event_id);
+		return 1;
+	}
+
+	for (size_t i = 0; i < decoded->num_coords; i++) {
+		if (decoded->xs[i] != bytes->xs[i] || decoded->ys[i] != bytes->ys[i]) {
+			fprintf(stderr, "Coordinate %zu: (%zu,%zu) decoded, (%zu,%zu) byte by byte\n", i, decoded->xs[i], decoded->ys[i],
+				bytes->xs[i], bytes->ys[i]);
+			return 1;
+		}
+	}
+
+	if (decoded->rest_size != bytes->rest_size || memcmp(decoded->rest, bytes->rest, decoded->rest_size) != 0) {
+		fprintf(stderr, "Bytes left: %zu decoded, %zu byte by byte\n", decoded->rest_size, bytes->rest_size);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned long num_cases = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+	unsigned long seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+	rng_state = seed * 0x9E3779B97F4A7C15ULL + 1; /// never 0
+
+	char path[] = "/tmp/reserve_decoder_fuzz_XXXXXX";
+	int file_fd = mkstemp(path);
+	if (file_fd == -1) {
+		fprintf(stderr, "Error: Failed to create the input file\n");
+		return 1;
+	}
+	unlink(path);
+
+	static text t;
+	static parse_result decoded, bytes;
+	struct ParserScratch scratch = {0};
+
+	for (unsigned long i = 0; i < num_cases; i++) {
+		generate_case(&t);
+		parse_from_file(file_fd, &t, &scratch, &decoded);
+		parse_from_pipe(&t, &scratch, &bytes);
+
+		if (compare(&decoded, &bytes) != 0) {
+			fprintf(stderr, "Case %lu (seed %lu) gives different results:\n", i, seed);
+			print_case(&t);
+			return 1;
+		}
+	}
+
+	printf("%lu cases, seed %lu: same results\n", num_cases, seed);
+
+	parser_scratch_free(&scratch);
+	free(decoded.xs);
+	free(decoded.ys);
+	free(bytes.xs);
+	free(bytes.ys);
+	close(file_fd);
+	return 0;
+}
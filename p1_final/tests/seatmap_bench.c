@@ -0,0 +1,141 @@
+/// Benchmark of the seat maps on many small events, following what the EMS does with them: each event is allocated
+/// with its seat map inside and its inline seats after it (like struct Event), some of its seats are reserved (each seat is read before it is
+/// written, like a RESERVE), all its seats are read (like the copy of a SHOW), and it is destroyed.
+/// The SHOW copy is timed twice: reading each seat with seatmap_get (checking the layout on every seat) and with
+/// seatmap_copy (one loop per layout, as the EMS does).
+/// Prints the layout of the first event, the size of an event (with its inline seats), and the best time of each phase in ms:
+/// <layout> <size> <create> <reserve> <show> <show, one loop per layout> <destroy> <checksum>
+/// Usage: seatmap_bench [number of events] [rows] [cols] [seats reserved per event] [repetitions]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "seatmap.h"
+
+#define NUM_PHASES 5 /// create, reserve, show, show with one loop per layout, destroy
+
+/// Event of the benchmark (the seat map is inside it and the inline seats after it, like in struct Event).
+struct BenchEvent {
+	unsigned int id;
+	size_t rows;
+	size_t cols;
+	struct SeatMap seats;
+};
+
+static uint64_t now_ns(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+static const char* layout_name(enum SeatLayout layout) {
+	switch (layout) {
+		case SEATMAP_INLINE:
+			return "inline";
+		case SEATMAP_DENSE:
+			return "dense";
+		case SEATMAP_SPARSE:
+		default:
+			return "sparse";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	size_t num_events = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+	size_t rows = argc > 2 ? strtoul(argv[2], NULL, 10) : 8;
+	size_t cols = argc > 3 ? strtoul(argv[3], NULL, 10) : 8;
+	size_t reserved = argc > 4 ? strtoul(argv[4], NULL, 10) : 4;
+	int repetitions = argc > 5 ? atoi(argv[5]) : 5;
+	size_t num_seats = rows * cols;
+	size_t event_size = sizeof(struct BenchEvent) + seatmap_inline_size(num_seats);
+
+	if (num_events == 0 || num_seats == 0 || reserved > num_seats || repetitions <= 0) {
+		fprintf(stderr, "Usage: %s [number of events] [rows] [cols] [seats reserved per event] [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	struct BenchEvent** events = malloc(num_events * sizeof(struct BenchEvent*));
+	unsigned int* seats = malloc(num_seats * sizeof(unsigned int));
+	if (events == NULL || seats == NULL) {
+		fprintf(stderr, "Error: Memory allocation failed\n");
+		return 1;
+	}
+
+	uint64_t best[NUM_PHASES];
+	for (int phase = 0; phase < NUM_PHASES; phase++) {
+		best[phase] = UINT64_MAX;
+	}
+	enum SeatLayout layout = SEATMAP_INLINE;
+	uint64_t checksum = 0; /// keeps the reads from being optimized away
+
+	for (int repetition = 0; repetition < repetitions; repetition++) {
+		uint64_t elapsed[NUM_PHASES];
+		uint64_t start = now_ns();
+
+		for (size_t i = 0; i < num_events; i++) {
+			events[i] = malloc(event_size);
+			if (events[i] == NULL || seatmap_init(&events[i]->seats, num_seats, (unsigned int*) (events[i] + 1)) != 0) {
+				fprintf(stderr, "Error: Memory allocation failed\n");
+				return 1;
+			}
+			events[i]->id = (unsigned int)i + 1;
+			events[i]->rows = rows;
+			events[i]->cols = cols;
+		}
+		elapsed[0] = now_ns() - start;
+
+		start = now_ns();
+		for (size_t i = 0; i < num_events; i++) {
+			for (size_t j = 0; j < reserved; j++) {
+				size_t index = (j * 7 + i) % num_seats; /// spread over the event, a different place for each event
+				if (seatmap_get(&events[i]->seats, index) == 0 && seatmap_set(&events[i]->seats, index, (unsigned int)j + 1) != 0) {
+					fprintf(stderr, "Error: Memory allocation failed\n");
+					return 1;
+				}
+			}
+		}
+		elapsed[1] = now_ns() - start;
+		layout = events[0]->seats.layout;
+
+		start = now_ns();
+		for (size_t i = 0; i < num_events; i++) {
+			for (size_t j = 0; j < num_seats; j++) {
+				seats[j] = seatmap_get(&events[i]->seats, j);
+			}
+			checksum += seats[i % num_seats];
+		}
+		elapsed[2] = now_ns() - start;
+
+		start = now_ns();
+		for (size_t i = 0; i < num_events; i++) {
+			seatmap_copy(&events[i]->seats, seats);
+			checksum += seats[i % num_seats];
+		}
+		elapsed[3] = now_ns() - start;
+
+		start = now_ns();
+		for (size_t i = 0; i < num_events; i++) {
+			seatmap_destroy(&events[i]->seats);
+			free(events[i]);
+		}
+		elapsed[4] = now_ns() - start;
+
+		for (int phase = 0; phase < NUM_PHASES; phase++) {
+			if (elapsed[phase] < best[phase]) {
+				best[phase] = elapsed[phase];
+			}
+		}
+	}
+
+	printf("%s %zu", layout_name(layout), event_size);
+	for (int phase = 0; phase < NUM_PHASES; phase++) {
+		printf(" %.1f", (double)best[phase] / 1e6);
+	}
+	printf(" %llu\n", (unsigned long long)checksum);
+
+	free(events);
+	free(seats);
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "hash.h"
+
+#define HASH_CHUNK_SIZE 65536 /// bytes read at a time (must be a multiple of HASH_STRIPE_SIZE)
+#define HASH_STRIPE_SIZE 32 /// bytes consumed at a time by the 4 lanes of the hash
+#define HASH_SEED 0x27D4EB2F165667C5ULL
+
+static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+
+/// Rotates a 64-bit value to the left.
+static uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/// Reads a little endian 64-bit word (memcpy avoids unaligned accesses).
+static uint64_t read_word(const unsigned char *bytes) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return word;
+}
+
+/// Mixes one word into a lane.
+static uint64_t mix_lane(uint64_t lane, uint64_t word) {
+    return rotl(lane + word * PRIME_2, 31) * PRIME_1;
+}
+
+/// Reads up to size bytes, retrying short reads so that only the last chunk of the file is partial.
+static ssize_t read_chunk(int fd, unsigned char *buffer, size_t size) {
+    size_t total = 0;
+
+    while (total < size) {
+        ssize_t bytes_read = read(fd, buffer + total, size - total);
+        if (bytes_read == -1) {
+            return -1;
+        } else if (bytes_read == 0) {
+            break;
+        }
+        total += (size_t) bytes_read;
+    }
+
+    return (ssize_t) total;
+}
+
+int hash_file(const char *filename, uint64_t *hash) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return 1;
+    }
+
+    unsigned char buffer[HASH_CHUNK_SIZE];
+    uint64_t lanes[4] = {HASH_SEED + PRIME_1 + PRIME_2, HASH_SEED + PRIME_2, HASH_SEED, HASH_SEED - PRIME_1}; /// 4 independent lanes keep the multipliers busy
+    uint64_t length = 0;
+    uint64_t result = 0;
+    ssize_t bytes_read;
+
+    while ((bytes_read = read_chunk(fd, buffer, HASH_CHUNK_SIZE)) > 0) {
+        size_t size = (size_t) bytes_read;
+        size_t stripes_end = size - size % HASH_STRIPE_SIZE;
+        length += size;
+
+        for (size_t i = 0; i < stripes_end; i += HASH_STRIPE_SIZE) {
+            lanes[0] = mix_lane(lanes[0], read_word(buffer + i));
+            lanes[1] = mix_lane(lanes[1], read_word(buffer + i + 8));
+            lanes[2] = mix_lane(lanes[2], read_word(buffer + i + 16));
+            lanes[3] = mix_lane(lanes[3], read_word(buffer + i + 24));
+        }
+
+        if (stripes_end < size) { /// only the last chunk can have a tail (read_chunk only returns less than a full chunk at the end)
+            result = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (size_t i = stripes_end; i < size; i++) {
+                result = rotl(result ^ ((uint64_t) buffer[i] * PRIME_3), 11) * PRIME_1;
+            }
+            break;
+        }
+    }
+
+    close(fd);
+
+    if (bytes_read == -1) {
+        return 1;
+    }
+
+    if (length % HASH_STRIPE_SIZE == 0) { /// no tail
+        result = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    }
+
+    /// final avalanche, so that similar files have unrelated hashes
+    result ^= length * PRIME_3;
+    result ^= result >> 33;
+    result *= PRIME_2;
+    result ^= result >> 29;
+    result *= PRIME_3;
+    result ^= result >> 32;
+
+    *hash = result;
+    return 0;
+}
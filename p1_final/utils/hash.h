@@ -0,0 +1,12 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+
+/// Computes a fast (non cryptographic) 64-bit hash of the contents of a file, reading it in fixed size chunks.
+/// @param filename Name of the file to hash.
+/// @param hash Pointer to the variable to store the hash in.
+/// @return 0 if the file was hashed successfully, 1 otherwise.
+int hash_file(const char *filename, uint64_t *hash);
+
+#endif // HASH_H
@@ -0,0 +1,50 @@
+#include "vclock.h"
+
+#include <time.h>
+
+static int virtual_time = 0; /// set once before the threads are created, so it's only read concurrently
+static _Thread_local unsigned long long thread_clock_ms = 0; /// logical clock of each thread (threads start at time 0)
+
+void vclock_enable() {
+	virtual_time = 1;
+}
+
+int vclock_enabled() {
+	return virtual_time;
+}
+
+void vclock_delay(unsigned int delay_ms) {
+	if (virtual_time) {
+		thread_clock_ms += delay_ms;
+		return;
+	}
+
+	struct timespec delay = {delay_ms / 1000, (delay_ms % 1000) * 1000000};
+	nanosleep(&delay, NULL);
+}
+
+unsigned long long vclock_now() {
+	return thread_clock_ms;
+}
+
+void vclock_advance_to(unsigned long long time_ms) {
+	if (time_ms > thread_clock_ms) {
+		thread_clock_ms = time_ms;
+	}
+}
+
+void vclock_acquire(atomic_ullong* release_time) {
+	if (virtual_time) {
+		vclock_advance_to(atomic_load(release_time));
+	}
+}
+
+void vclock_release(atomic_ullong* release_time) {
+	if (!virtual_time) {
+		return;
+	}
+
+	/// readers of a rwlock release it concurrently, so keep the latest release time
+	unsigned long long current = atomic_load(release_time);
+	while (current < thread_clock_ms && !atomic_compare_exchange_weak(release_time, &current, thread_clock_ms));
+}
@@ -0,0 +1,34 @@
+#ifndef VCLOCK_H
+#define VCLOCK_H
+
+#include <stdatomic.h>
+
+/// Enables the virtual time mode: the simulated delays advance a logical clock of the calling thread instead of sleeping.
+/// @note Must be called before the threads that process the files are created.
+void vclock_enable();
+
+/// Checks if the virtual time mode is enabled.
+/// @return 1 if it is enabled, 0 otherwise.
+int vclock_enabled();
+
+/// Waits for the given delay, or only advances the logical clock of the calling thread in virtual time mode.
+/// @param delay_ms Delay in milliseconds.
+void vclock_delay(unsigned int delay_ms);
+
+/// Gets the logical clock of the calling thread.
+/// @return Logical time in milliseconds.
+unsigned long long vclock_now();
+
+/// Moves the logical clock of the calling thread forward to the given time (it never moves backwards).
+/// @param time_ms Logical time in milliseconds.
+void vclock_advance_to(unsigned long long time_ms);
+
+/// Synchronizes the logical clock after acquiring a lock: the lock can't be acquired before it was released.
+/// @param release_time Logical time at which the lock was last released.
+void vclock_acquire(atomic_ullong* release_time);
+
+/// Records the logical time at which a lock is released (must be called before releasing it).
+/// @param release_time Logical time at which the lock was last released.
+void vclock_release(atomic_ullong* release_time);
+
+#endif  // VCLOCK_H
@@ -1,78 +1,922 @@
+#define _GNU_SOURCE // memfd_create and the seals of its file (Linux)
+
 #include <unistd.h>
+#include <errno.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <limits.h>
+#include <stdint.h>
 
 #include "api.h"
 #include "common/constants.h"
+#include "common/protocol.h"
+#include "common/shm_ring.h"
+
+static ems_transport session_transport = EMS_TRANSPORT_FIFO; // transport of the current session
+static frame_buffer responses; // bytes read from the response file descriptor of the current session
+static char session_encoding = FRAME_ENCODING_FIXED; // encoding of the requests of the current session (agreed in ems_setup)
+static int compact_encoding = 1; // whether ems_setup asks for the compact encoding (see ems_set_compact_encoding)
+static shm_region* shm = NULL; // shared memory of the current session (with EMS_TRANSPORT_SHM)
+static shm_ring_end request_ring; // ring to write requests to (with EMS_TRANSPORT_SHM)
+static shm_ring_end response_ring; // ring to read responses from (with EMS_TRANSPORT_SHM)
+
+typedef struct {
+	unsigned int event_id; // id of the event
+	int used; // 1 if the entry has an event
+	unsigned int version; // version of the seats (the number of reservations of the event)
+	size_t num_rows; // number of rows of the event
+	size_t num_cols; // number of columns of the event
+	unsigned int* seats; // seats of the event at the version (NULL before the first response: all 0 at version 0)
+	size_t in_flight; // requests for the changes since a version of the seats whose response wasn't read (it is kept until then)
+	unsigned long last_use; // when the event was last shown (the least recently shown one is replaced)
+} cached_event; // seats of an event already shown
+
+typedef struct {
+	ems_ticket ticket; // ticket of the request (also its request id)
+	char op_code; // operation code of the request
+	int out_fd; // file descriptor to print the response to (SHOW and LIST)
+	int* results; // array to store the results of a batch in
+	size_t num_results; // number of operations of a batch
+	size_t size; // size of the request in bytes
+	cached_event* cache; // seats the response to a SHOW of changes is applied to (NULL for other requests)
+} pending_request; // a request sent whose response wasn't read yet
+
+typedef struct {
+	ems_ticket ticket; // ticket of the request (0 if the slot is empty)
+	int return_code; // return code of the request
+} ticket_result; // result of a completed request
+
+static pending_request pending[EMS_MAX_WINDOW]; // requests in flight, in the order they were sent (a circular buffer)
+static size_t pending_head = 0; // position of the oldest request in flight
+static size_t pending_count = 0; // number of requests in flight
+static size_t pending_bytes = 0; // total size of the requests in flight
+static size_t window = 1; // maximum number of requests in flight (see ems_set_window)
+static ems_ticket next_ticket = 1; // ticket of the next request
+static ticket_result ticket_results[EMS_RESULT_HISTORY]; // results of the last completed requests (by ticket modulo EMS_RESULT_HISTORY)
+static cached_event show_cache[EMS_SHOW_CACHE_SIZE]; // seats of the events shown last
+static int show_cache_enabled = 1; // whether the seats of the events shown are kept (see ems_set_show_cache)
+static unsigned long show_cache_clock = 0; // number of events shown (to find the least recently shown)
+
+/// Writes a frame to the server (to the request ring with EMS_TRANSPORT_SHM).
+/// @param req_fd File descriptor to write requests to.
+/// @return 0 if the frame was written, 1 otherwise.
+static int send_frame(int req_fd, char op_code, char encoding, uint32_t request_id, const struct iovec* parts, int num_parts) {
+	if (session_transport == EMS_TRANSPORT_SHM) {
+		return shm_ring_write_frame(&request_ring, op_code, encoding, request_id, parts, num_parts);
+	}
+
+	return write_frame(req_fd, op_code, encoding, request_id, parts, num_parts);
+}
+
+/// Reads the next frame from the server (from the response ring with EMS_TRANSPORT_SHM).
+/// @param resp_fd File descriptor to read responses from.
+/// @return 0 if a frame was read, 1 otherwise.
+static int receive_frame(int resp_fd, frame_header* header, const char** payload) {
+	if (session_transport == EMS_TRANSPORT_SHM) {
+		return shm_ring_read_frame(&response_ring, &responses, header, payload);
+	}
+
+	return read_frame(resp_fd, &responses, header, payload);
+}
+
+/// Copies the next field of the payload of a response (exits if the response is too short).
+/// @param payload Pointer to the next byte of the payload (advanced past the field).
+/// @param remaining Pointer to the number of bytes left in the payload.
+/// @param value Pointer to the variable to store the field in.
+/// @param size Size of the field.
+static void take_field(const char** payload, size_t* remaining, void* value, size_t size) {
+	if (*remaining < size) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(value, *payload, size);
+	*payload += size;
+	*remaining -= size;
+}
+
+/// Reads the next number (a size_t) of the payload of a response, as a varint with the compact encoding.
+/// @param payload Pointer to the next byte of the payload (advanced past the number).
+/// @param remaining Pointer to the number of bytes left in the payload.
+/// @param encoding Encoding of the response.
+/// @param value Pointer to the variable to store the number in.
+static void take_number(const char** payload, size_t* remaining, char encoding, size_t* value) {
+	if (encoding == FRAME_ENCODING_FIXED) {
+		take_field(payload, remaining, value, sizeof(size_t));
+		return;
+	}
+
+	uint64_t number;
+	if (get_varint(payload, remaining, &number) != 0 || number > SIZE_MAX) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	*value = (size_t)number;
+}
+
+/// Appends a number to a request, as a varint with the compact encoding.
+/// @param out Buffer to append to (room for VARINT_MAX_SIZE bytes).
+/// @param encoding Encoding of the request.
+/// @param value The number.
+/// @param size Size of the number with the fixed encoding (sizeof(size_t) or sizeof(unsigned int)).
+/// @return The number of bytes appended.
+static size_t put_number(char* out, char encoding, uint64_t value, size_t size) {
+	if (encoding == FRAME_ENCODING_COMPACT) {
+		return put_varint(out, value);
+	}
+
+	if (size == sizeof(unsigned int)) {
+		unsigned int fixed = (unsigned int)value;
+		memcpy(out, &fixed, size);
+	} else {
+		size_t fixed = (size_t)value;
+		memcpy(out, &fixed, size);
+	}
+
+	return size;
+}
+
+/// Writes all the bytes to a file descriptor (continuing writes that only write part of them).
+/// @param fd File descriptor to write to.
+/// @param data Bytes to write.
+/// @param size Number of bytes.
+static void write_all(int fd, const char* data, size_t size) {
+	while (size > 0) {
+		ssize_t written = write(fd, data, size);
+
+		if (written == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			fprintf(stderr, "Failed to write to output file\n");
+			return;
+		}
+
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+/// Copies every seat of an event from the payload of a response (exits if the response is invalid).
+/// @param payload Pointer to the next byte of the payload (advanced past the seats).
+/// @param remaining Pointer to the number of bytes left in the payload (the seats are the rest of it).
+/// @param encoding Encoding of the response.
+/// @param seats Array to store the seats in (NULL if there are none).
+/// @param num_seats Number of seats.
+static void take_seats(const char** payload, size_t* remaining, char encoding, unsigned int* seats, size_t num_seats) {
+	if (encoding == FRAME_ENCODING_FIXED && *remaining != sizeof(unsigned int) * num_seats) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (encoding == FRAME_ENCODING_FIXED) {
+		if (num_seats > 0) { // an event without seats has no array to copy to
+			memcpy(seats, *payload, *remaining);
+		}
+	} else if (decode_seat_runs(*payload, *remaining, seats, num_seats) != 0) { // the seats are sent as runs
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	*payload += *remaining;
+	*remaining = 0;
+}
+
+/// Reads the dimensions of an event from the payload of a response, and allocates its seats.
+/// @param payload Pointer to the next byte of the payload (advanced past the dimensions).
+/// @param remaining Pointer to the number of bytes left in the payload.
+/// @param encoding Encoding of the response.
+/// @param num_rows Pointer to store the number of rows in.
+/// @param num_cols Pointer to store the number of columns in.
+/// @return The array for the seats, NULL if the event has none (exits if it is too large).
+static unsigned int* take_dimensions(const char** payload, size_t* remaining, char encoding, size_t* num_rows, size_t* num_cols) {
+	take_number(payload, remaining, encoding, num_rows);
+	take_number(payload, remaining, encoding, num_cols);
+
+	if (*num_cols != 0 && *num_rows > SIZE_MAX / sizeof(unsigned int) / *num_cols) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (*num_rows * *num_cols == 0) { // an event without seats
+		return NULL;
+	}
+
+	unsigned int* seats = calloc(*num_rows * *num_cols, sizeof(unsigned int)); // the payload is not aligned
+
+	if (seats == NULL) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return seats;
+}
+
+/// Prints the seats of an event.
+/// @param out_fd File descriptor to print the event to.
+/// @param seats The seats.
+/// @param num_rows Number of rows.
+/// @param num_cols Number of columns.
+static void print_seats(int out_fd, const unsigned int* seats, size_t num_rows, size_t num_cols) {
+	if (num_rows == 0) { // nothing to print
+		return;
+	}
+
+	// The event is formatted and written at once (a big event has millions of seats)
+	char* text = malloc(num_rows * num_cols * 11 + num_rows); // at most 10 digits and a separator (or sprintf's '\0') per seat, and a newline per row
+
+	if (text == NULL) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	size_t size = 0;
+	size_t i, j; // iterators
+
+	for (i = 0; i < num_rows; i++) {
+		for (j = 0; j < num_cols; j++) {
+			size += (size_t)sprintf(text + size, "%u", seats[i * num_cols + j]); // converts the seat id to a string
+
+			if (j < num_cols - 1) { // writes a space if the seat is not the last seat in the row
+				text[size++] = ' ';
+			}
+		}
+
+		text[size++] = '\n';
+	}
+
+	write_all(out_fd, text, size);
+	free(text);
+}
+
+/// Prints the seats of an event from the payload of a SHOW response.
+/// @param out_fd File descriptor to print the event to.
+/// @param encoding Encoding of the response.
+/// @param payload Payload of the response.
+/// @param length Length of the payload.
+/// @return The return code of the response.
+static int print_show_response(int out_fd, char encoding, const char* payload, size_t length) {
+	int return_code; // return code from the server
+	size_t num_rows; // number of rows
+	size_t num_cols; // number of columns
+
+	take_field(&payload, &length, &return_code, sizeof(int));
+
+	if (return_code != 0) {
+		return return_code;
+	}
+
+	unsigned int* seats = take_dimensions(&payload, &length, encoding, &num_rows, &num_cols);
+	take_seats(&payload, &length, encoding, seats, num_rows * num_cols);
+	print_seats(out_fd, seats, num_rows, num_cols);
+	free(seats);
+
+	return 0;
+}
+
+/// Applies a response to a SHOW of the changes since a version to the seats kept of the event, and prints them.
+/// The responses arrive in order and the seats only change forward, so the changes since an older version also
+/// bring a newer one up to date.
+/// @param out_fd File descriptor to print the event to.
+/// @param cache Seats kept of the event (the version the request was sent with, or a newer one).
+/// @param encoding Encoding of the response.
+/// @param payload Payload of the response.
+/// @param length Length of the payload.
+/// @return The return code of the response.
+static int print_show_since_response(int out_fd, cached_event* cache, char encoding, const char* payload, size_t length) {
+	int return_code; // return code from the server
+	size_t version; // version of the seats
+	char full; // 1 if every seat follows, 0 if only the ones that changed
+	size_t num_rows; // number of rows
+	size_t num_cols; // number of columns
+
+	cache->in_flight--;
+	take_field(&payload, &length, &return_code, sizeof(int));
+
+	if (return_code != 0) {
+		return return_code;
+	}
+
+	take_number(&payload, &length, encoding, &version);
+	take_field(&payload, &length, &full, sizeof(char));
+	unsigned int* seats = take_dimensions(&payload, &length, encoding, &num_rows, &num_cols);
+	size_t num_seats = num_rows * num_cols;
+
+	if (cache->seats != NULL && cache->num_rows == num_rows && cache->num_cols == num_cols) {
+		free(seats); // the changes are applied to the seats kept
+		seats = cache->seats;
+	} else if (cache->seats != NULL && !full) { // the changes are not of the seats kept
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	} else { // the first response: all the seats were 0 at version 0
+		free(cache->seats);
+	}
+
+	if (full) {
+		take_seats(&payload, &length, encoding, seats, num_seats);
+	} else {
+		size_t num_changes;
+		take_number(&payload, &length, encoding, &num_changes);
+
+		for (size_t i = 0; i < num_changes; i++) {
+			size_t index;
+			size_t seat;
+			take_number(&payload, &length, encoding, &index);
+
+			if (encoding == FRAME_ENCODING_FIXED) { // a seat is an unsigned int, like in a SHOW
+				unsigned int fixed;
+				take_field(&payload, &length, &fixed, sizeof(unsigned int));
+				seat = fixed;
+			} else {
+				take_number(&payload, &length, encoding, &seat);
+			}
+
+			if (index >= num_seats || seat > UINT_MAX) {
+				fprintf(stderr, "Invalid response from server\n");
+				exit(EXIT_FAILURE);
+			}
 
-ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path, char const* server_pipe_path) {
+			seats[index] = (unsigned int)seat;
+		}
+	}
+
+	if (length != 0 || version > UINT_MAX) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	cache->seats = seats;
+	cache->num_rows = num_rows;
+	cache->num_cols = num_cols;
+	cache->version = (unsigned int)version;
+
+	print_seats(out_fd, seats, num_rows, num_cols);
+	return 0;
+}
+
+/// Finds the seats kept of an event, or an entry to keep them in (replacing the least recently shown event
+/// without requests in flight).
+/// @param event_id Id of the event.
+/// @return The entry of the event, NULL if every entry has requests in flight.
+static cached_event* find_cached_event(unsigned int event_id) {
+	cached_event* found = NULL;
+
+	for (size_t i = 0; i < EMS_SHOW_CACHE_SIZE; i++) {
+		cached_event* entry = &show_cache[i];
+
+		if (entry->used && entry->event_id == event_id) {
+			found = entry;
+			break;
+		}
+
+		if (entry->in_flight == 0 && (found == NULL || !entry->used || (found->used && entry->last_use < found->last_use))) {
+			found = entry;
+		}
+	}
+
+	if (found != NULL && (!found->used || found->event_id != event_id)) { // replaces the event kept
+		free(found->seats);
+		memset(found, 0, sizeof(cached_event));
+		found->used = 1;
+		found->event_id = event_id;
+	}
+
+	if (found != NULL) {
+		found->last_use = ++show_cache_clock;
+	}
+
+	return found;
+}
+
+/// Forgets the seats of every event (the versions are only meaningful in a session).
+static void clear_show_cache() {
+	for (size_t i = 0; i < EMS_SHOW_CACHE_SIZE; i++) {
+		free(show_cache[i].seats);
+	}
+
+	memset(show_cache, 0, sizeof(show_cache));
+}
+
+/// Prints the ids of the events from the payload of a LIST response.
+/// @param out_fd File descriptor to print the events to.
+/// @param encoding Encoding of the response.
+/// @param payload Payload of the response.
+/// @param length Length of the payload.
+/// @return The return code of the response.
+static int print_list_response(int out_fd, char encoding, const char* payload, size_t length) {
+	int return_code; // return code from the server
+	size_t num_events; // number of events
+	unsigned int *events; // array of events
+
+	take_field(&payload, &length, &return_code, sizeof(int));
+
+	if (return_code != 0) {
+		return return_code;
+	}
+
+	take_number(&payload, &length, encoding, &num_events);
+
+	size_t min_size = encoding == FRAME_ENCODING_FIXED ? sizeof(unsigned int) : 1; // size of an event id (at least)
+	if (num_events > length / min_size) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	events = NULL; // there are none to allocate for an empty list
+
+	if (num_events > 0) {
+		events = malloc(sizeof(unsigned int) * num_events); // allocates memory for the events (the payload is not aligned)
+
+		if (events == NULL) {
+			fprintf(stderr, "Failed to allocate memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (size_t i = 0; i < num_events; i++) {
+		if (encoding == FRAME_ENCODING_FIXED) {
+			take_field(&payload, &length, &events[i], sizeof(unsigned int));
+			continue;
+		}
+
+		size_t event_id;
+		take_number(&payload, &length, encoding, &event_id);
+		events[i] = (unsigned int)event_id;
+	}
+
+	if (length != 0) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (num_events == 0) {
+		const char* no_events = "No events\n";
+		write(out_fd, no_events, strlen(no_events));
+	} else {
+		size_t i;
+		for (i = 0; i < num_events; i++) {
+			write(out_fd, "Event: ", 7);
+			char id[16];
+			sprintf(id, "%u", events[i]);
+			write(out_fd, id, strlen(id));
+			write(out_fd, "\n", 1);
+		}
+	}
+
+	free(events);
+
+	return 0;
+}
+
+/// Copies the results of the operations of a batch from the payload of a BATCH response.
+/// @param results Array to store the results in.
+/// @param num_results Number of operations of the batch.
+/// @param encoding Encoding of the response.
+/// @param payload Payload of the response.
+/// @param length Length of the payload.
+/// @return The return code of the response.
+static int take_batch_results(int* results, size_t num_results, char encoding, const char* payload, size_t length) {
+	int return_code; // return code from the server
+	size_t num_operations; // number of operations that ran
+
+	take_field(&payload, &length, &return_code, sizeof(int));
+
+	if (return_code != 0) {
+		return return_code;
+	}
+
+	take_number(&payload, &length, encoding, &num_operations);
+
+	if (num_operations != num_results) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (size_t i = 0; i < num_results; i++) {
+		if (encoding == FRAME_ENCODING_FIXED) {
+			take_field(&payload, &length, &results[i], sizeof(int));
+			continue;
+		}
+
+		size_t result;
+		take_number(&payload, &length, encoding, &result);
+		results[i] = (int)result;
+	}
+
+	if (length != 0) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
+
+/// Reads the response to the oldest request in flight and completes it (exits if it can't be read).
+/// The server processes the requests of a session in order, so the responses arrive in the order of the requests.
+/// @param resp_fd File descriptor to read responses from.
+static void complete_oldest(int resp_fd) {
+	pending_request* request = &pending[pending_head];
+	frame_header header;
+	const char* payload;
+
+	if (receive_frame(resp_fd, &header, &payload) != 0) {
+		fprintf(stderr, "Failed to read from pipe\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (header.op_code != request->op_code || header.request_id != request->ticket) {
+		fprintf(stderr, "Invalid response from server\n");
+		exit(EXIT_FAILURE);
+	}
+
+	int return_code;
+	size_t length = header.length;
+
+	switch (request->op_code) {
+		case '5':
+			return_code = print_show_response(request->out_fd, header.encoding, payload, length);
+			break;
+
+		case 'A':
+			return_code = print_show_since_response(request->out_fd, request->cache, header.encoding, payload, length);
+			break;
+
+		case '6':
+			return_code = print_list_response(request->out_fd, header.encoding, payload, length);
+			break;
+
+		case '7':
+			return_code = take_batch_results(request->results, request->num_results, header.encoding, payload, length);
+			break;
+
+		default:
+			take_field(&payload, &length, &return_code, sizeof(int));
+			break;
+	}
+
+	ticket_results[request->ticket % EMS_RESULT_HISTORY].ticket = request->ticket;
+	ticket_results[request->ticket % EMS_RESULT_HISTORY].return_code = return_code;
+
+	pending_head = (pending_head + 1) % EMS_MAX_WINDOW;
+	pending_count--;
+	pending_bytes -= request->size;
+}
+
+/// Checks if a request is still in flight.
+/// @param ticket Ticket of the request.
+/// @return 1 if the response to the request wasn't read yet, 0 otherwise.
+static int is_pending(ems_ticket ticket) {
+	for (size_t i = 0; i < pending_count; i++) {
+		if (pending[(pending_head + i) % EMS_MAX_WINDOW].ticket == ticket) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// Encodes the payload of a CREATE request.
+/// @param out Buffer to write to (room for 3 * VARINT_MAX_SIZE bytes).
+/// @param encoding Encoding of the request.
+/// @return The size of the payload.
+static size_t encode_create(char* out, char encoding, unsigned int event_id, size_t num_rows, size_t num_cols) {
+	size_t size = put_number(out, encoding, event_id, sizeof(unsigned int));
+	size += put_number(out + size, encoding, num_rows, sizeof(size_t));
+	size += put_number(out + size, encoding, num_cols, sizeof(size_t));
+	return size;
+}
+
+/// Encodes the payload of a RESERVE request (the rows, then the columns).
+/// @param out Buffer to write to (room for (2 + 2 * num_seats) * VARINT_MAX_SIZE bytes).
+/// @param encoding Encoding of the request.
+/// @return The size of the payload.
+static size_t encode_reserve(char* out, char encoding, unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys) {
+	size_t size = put_number(out, encoding, event_id, sizeof(unsigned int));
+	size += put_number(out + size, encoding, num_seats, sizeof(size_t));
+
+	for (size_t i = 0; i < num_seats; i++) {
+		size += put_number(out + size, encoding, xs[i], sizeof(size_t));
+	}
+
+	for (size_t i = 0; i < num_seats; i++) {
+		size += put_number(out + size, encoding, ys[i], sizeof(size_t));
+	}
+
+	return size;
+}
+
+/// Sends a request with a single write, first waiting for responses if the window is full (exits if it can't be written).
+/// The bytes in flight are also limited, so the requests always fit in the pipe and the client never blocks writing
+/// while the server blocks writing a response the client isn't reading.
+/// @param req_fd File descriptor to write requests to.
+/// @param resp_fd File descriptor to read responses from.
+/// @param op_code Operation code of the request.
+/// @param parts Parts of the payload of the request.
+/// @param num_parts Number of parts.
+/// @param out_fd File descriptor to print the response to (SHOW and LIST).
+/// @param batch Batch sent (NULL for other requests).
+/// @param results Array to store the results of the batch in.
+/// @return The ticket of the request.
+static ems_ticket send_request(int req_fd, int resp_fd, char op_code, const struct iovec* parts, int num_parts, int out_fd,
+		const ems_batch* batch, int* results) {
+	size_t size = sizeof(frame_header);
+	for (int i = 0; i < num_parts; i++) {
+		size += parts[i].iov_len;
+	}
+
+	while (pending_count >= window || (pending_count > 0 && pending_bytes + size > EMS_MAX_BYTES_IN_FLIGHT)) {
+		complete_oldest(resp_fd);
+	}
+
+	ems_ticket ticket = next_ticket++;
+	if (next_ticket == 0) { // 0 is never a ticket
+		next_ticket = 1;
+	}
+
+	char encoding = batch != NULL ? batch->encoding : session_encoding; // a batch keeps the encoding it was built with
+
+	if (send_frame(req_fd, op_code, encoding, ticket, parts, num_parts) != 0) {
+		fprintf(stderr, "Failed to write to pipe\n");
+		exit(EXIT_FAILURE);
+	}
+
+	pending_request* request = &pending[(pending_head + pending_count) % EMS_MAX_WINDOW];
+	request->ticket = ticket;
+	request->op_code = op_code;
+	request->out_fd = out_fd;
+	request->results = results;
+	request->num_results = batch != NULL ? batch->num_operations : 0;
+	request->size = size;
+	request->cache = NULL;
+	pending_count++;
+	pending_bytes += size;
+
+	return ticket;
+}
+
+/// Reads the session id sent by the server when a session starts.
+/// @param resp_fd File descriptor to read responses from.
+/// @return The session id, -1 if it couldn't be read.
+static int read_session_id(int resp_fd) {
+	frame_header header;
+	const char* payload;
+	int session_id;
+
+	frame_buffer_destroy(&responses); // nothing is left from a previous session
+	clear_show_cache();
+	if (read_frame(resp_fd, &responses, &header, &payload) != 0 || header.op_code != '1' || header.length != sizeof(int)) {
+		return -1;
+	}
+
+	memcpy(&session_id, payload, sizeof(int));
+	return session_id;
+}
+
+/// Agrees on the encoding of the requests with the server: the compact encoding, unless one of them doesn't know it.
+/// @param req_fd File descriptor to write requests to.
+/// @param resp_fd File descriptor to read responses from.
+/// @return 0 if the encoding was agreed, 1 otherwise.
+static int negotiate_encoding(int req_fd, int resp_fd) {
+	char encoding = compact_encoding ? FRAME_ENCODING_COMPACT : FRAME_ENCODING_FIXED; // the most compact encoding the client wants
+	struct iovec parts[] = {{&encoding, sizeof(char)}};
+	frame_header header;
+	const char* payload;
+	int return_code;
+
+	session_encoding = FRAME_ENCODING_FIXED; // the negotiation itself uses the fixed encoding
+
+	if (write_frame(req_fd, '8', FRAME_ENCODING_FIXED, 0, parts, 1) != 0 || // 8 for negotiate
+			read_frame(resp_fd, &responses, &header, &payload) != 0 || header.op_code != '8' ||
+			header.length != sizeof(int) + sizeof(char)) {
+		return 1;
+	}
+
+	memcpy(&return_code, payload, sizeof(int));
+	memcpy(&encoding, payload + sizeof(int), sizeof(char));
+
+	if (return_code != 0 || (encoding != FRAME_ENCODING_FIXED && encoding != FRAME_ENCODING_COMPACT)) {
+		return 1;
+	}
+
+	session_encoding = encoding;
+	return 0;
+}
+
+/// Closes the doorbells of the rings.
+/// @param fds The shared memory and the doorbells (SHM_RING_NUM_FDS file descriptors, -1 if not opened).
+static void close_shm_fds(int* fds) {
+	for (int i = 0; i < SHM_RING_NUM_FDS; i++) {
+		if (fds[i] != -1) {
+			close(fds[i]);
+		}
+	}
+}
+
+/// Moves a session to shared memory: creates a request and a response ring, and sends them with their doorbells
+/// to the server through the socket. The size of the shared memory is sealed, as the server only maps it if it
+/// can't shrink under it. From then on, the requests and responses are copied straight into the rings,
+/// and a doorbell is only rung when the other side is waiting (a busy session costs no system calls).
+/// @param socket_fd The socket of the session.
+/// @return 0 if the server attached the rings, 1 otherwise (the session goes on with the socket).
+static int attach_shm(int socket_fd) {
+	int fds[SHM_RING_NUM_FDS]; // the shared memory, then the data and space doorbells of the request and response rings
+
+	fds[0] = memfd_create("ems-client", MFD_CLOEXEC | MFD_ALLOW_SEALING); // only the file descriptors share it
+	if (fds[0] == -1) {
+		return 1;
+	}
+
+	for (int i = 1; i < SHM_RING_NUM_FDS; i++) {
+		fds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	}
+
+	shm_region* region = MAP_FAILED;
+	if (ftruncate(fds[0], sizeof(shm_region)) == 0 && fcntl(fds[0], F_ADD_SEALS, SHM_RING_SEALS) == 0) {
+		region = mmap(NULL, sizeof(shm_region), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+	}
+
+	for (int i = 1; i < SHM_RING_NUM_FDS && region != MAP_FAILED; i++) {
+		if (fds[i] == -1) {
+			munmap(region, sizeof(shm_region));
+			region = MAP_FAILED;
+		}
+	}
+
+	if (region == MAP_FAILED) {
+		close_shm_fds(fds);
+		return 1;
+	}
+
+	// The attach request ('9') carries the file descriptors
+	frame_header request;
+	memset(&request, 0, sizeof(request));
+	request.op_code = '9';
+	request.encoding = FRAME_ENCODING_FIXED;
+
+	char control[CMSG_SPACE(sizeof(fds))];
+	memset(control, 0, sizeof(control));
+	struct iovec iov = {&request, sizeof(request)};
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	struct cmsghdr* fds_header = CMSG_FIRSTHDR(&message);
+	fds_header->cmsg_level = SOL_SOCKET;
+	fds_header->cmsg_type = SCM_RIGHTS;
+	fds_header->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(fds_header), fds, sizeof(fds));
+
+	frame_header header;
+	const char* payload;
+	int return_code = 1;
+
+	if (sendmsg(socket_fd, &message, 0) == (ssize_t)sizeof(request) &&
+			read_frame(socket_fd, &responses, &header, &payload) == 0 && header.op_code == '9' && header.length == sizeof(int)) {
+		memcpy(&return_code, payload, sizeof(int));
+	}
+
+	close(fds[0]); // the mapping stays
+
+	if (return_code != 0) {
+		fds[0] = -1;
+		close_shm_fds(fds);
+		munmap(region, sizeof(shm_region));
+		return 1;
+	}
+
+	shm = region;
+	request_ring = (shm_ring_end){&region->requests, fds[1], fds[2], socket_fd, -1}; // the server may take long to answer
+	response_ring = (shm_ring_end){&region->responses, fds[3], fds[4], socket_fd, -1};
+	return 0;
+}
+
+/// Unmaps the shared memory of the session and closes the doorbells of its rings.
+static void detach_shm() {
+	int fds[SHM_RING_NUM_FDS] = {-1, request_ring.data_fd, request_ring.space_fd, response_ring.data_fd, response_ring.space_fd};
+
+	close_shm_fds(fds);
+	munmap(shm, sizeof(shm_region));
+	shm = NULL;
+}
+
+/// Connects to the Unix domain socket of an EMS server.
+/// @param server_socket_path Path to the socket where the server is listening.
+/// @return A ems_setup_data struct with the return code and the socket (as both file descriptors).
+static ems_setup_data ems_setup_socket(char const* server_socket_path) {
 	ems_setup_data setup_info = {0, 0, 0, 0}; // setup info to be returned
 
-	int server_fd = open(server_pipe_path, O_WRONLY);
-	
-	if (server_fd == -1) {
-		fprintf(stderr, "Failed to open pipe\n");
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (strlen(server_socket_path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Socket path too long\n");
 		setup_info.return_code = 1;
 		return setup_info;
 	}
+	strcpy(address.sun_path, server_socket_path);
 
-	unlink(resp_pipe_path);
-	unlink(req_pipe_path);
+	int socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
 
-	if (mkfifo(req_pipe_path, 0660) != 0) { // creates the request pipe
-		fprintf(stderr, "Failed to create request pipe\n");
+	if (socket_fd == -1) {
+		fprintf(stderr, "Failed to create socket\n");
 		setup_info.return_code = 1;
 		return setup_info;
 	}
 
-	if (mkfifo(resp_pipe_path, 0660) != 0) { // creates the response pipe
-		fprintf(stderr, "Failed to create response pipe\n");
+	if (connect(socket_fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+		fprintf(stderr, "Failed to connect to socket\n");
+		close(socket_fd);
 		setup_info.return_code = 1;
 		return setup_info;
 	}
 
-	char op_code = '1'; // the operation code for connect
+	int session_id = read_session_id(socket_fd); // session id from the server (sent as soon as the connection is accepted)
 
-	ssize_t num_bytes; // used to check if the write/read was successful
-	
-	num_bytes = write(server_fd, &op_code, sizeof(char)); // writes the operation code
-
-	if (num_bytes != sizeof(char)) {
-		fprintf(stderr, "Failed to write to pipe\n");
+	if (session_id == -1 || negotiate_encoding(socket_fd, socket_fd) != 0) {
+		fprintf(stderr, "Failed to read from socket\n");
+		close(socket_fd);
 		setup_info.return_code = 1;
 		return setup_info;
 	}
 
-	char pipe_path[PIPE_PATH_MAX];
+	session_transport = EMS_TRANSPORT_SOCKET;
 
-	memset(pipe_path, 0, PIPE_PATH_MAX); // clears the pipe path
-	strcpy(pipe_path, req_pipe_path); // copies the request pipe path to the pipe path
+	// Fills the setup info (requests and responses share the socket):
+	setup_info.session_id = session_id;
+	setup_info.req_fd = socket_fd;
+	setup_info.resp_fd = socket_fd;
+	setup_info.return_code = 0;
 
-	num_bytes = write(server_fd, pipe_path, sizeof(char) * PIPE_PATH_MAX); // writes the request pipe path
+	return setup_info;
+}
 
-	if (num_bytes != sizeof(char) * PIPE_PATH_MAX) {
-		fprintf(stderr, "Failed to write to pipe\n");
+ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path, char const* server_pipe_path, ems_transport transport) {
+	if (transport == EMS_TRANSPORT_SOCKET) {
+		return ems_setup_socket(server_pipe_path);
+	}
+
+	if (transport == EMS_TRANSPORT_SHM) {
+		ems_setup_data setup_info = ems_setup_socket(server_pipe_path);
+
+		if (setup_info.return_code == 0 && attach_shm(setup_info.req_fd) == 0) {
+			session_transport = EMS_TRANSPORT_SHM;
+		} else if (setup_info.return_code == 0) {
+			fprintf(stderr, "Failed to attach shared memory, using the socket\n");
+		}
+
+		return setup_info;
+	}
+
+	ems_setup_data setup_info = {0, 0, 0, 0}; // setup info to be returned
+
+	int server_fd = open(server_pipe_path, O_WRONLY);
+	
+	if (server_fd == -1) {
+		fprintf(stderr, "Failed to open pipe\n");
 		setup_info.return_code = 1;
 		return setup_info;
 	}
 
-	memset(pipe_path, 0, PIPE_PATH_MAX); // clears the buffer
-	strcpy(pipe_path, resp_pipe_path); // copies the response pipe path to the buffer
+	unlink(resp_pipe_path);
+	unlink(req_pipe_path);
 
-	num_bytes = write(server_fd, pipe_path, sizeof(char) * PIPE_PATH_MAX); // writes the response pipe path
+	if (mkfifo(req_pipe_path, 0660) != 0) { // creates the request pipe
+		fprintf(stderr, "Failed to create request pipe\n");
+		setup_info.return_code = 1;
+		return setup_info;
+	}
 
-	if (num_bytes != sizeof(char) * PIPE_PATH_MAX) {
-		fprintf(stderr, "Failed to write to pipe\n");
+	if (mkfifo(resp_pipe_path, 0660) != 0) { // creates the response pipe
+		fprintf(stderr, "Failed to create response pipe\n");
 		setup_info.return_code = 1;
 		return setup_info;
 	}
 
-	num_bytes = write(server_fd, "\0", 1);
+	// The request is written with a single write (smaller than PIPE_BUF, so it is atomic):
+	// requests of clients connecting at the same time can't be interleaved in the server pipe
+	char request[1 + 2 * PIPE_PATH_MAX + 1];
+	memset(request, 0, sizeof(request)); // the paths are padded with '\0', and the request ends with '\0'
+	request[0] = '1'; // the operation code for connect
+	strncpy(request + 1, req_pipe_path, PIPE_PATH_MAX - 1); // the request pipe path
+	strncpy(request + 1 + PIPE_PATH_MAX, resp_pipe_path, PIPE_PATH_MAX - 1); // the response pipe path
 
-	if (num_bytes != sizeof(char)) {
+	ssize_t num_bytes = write(server_fd, request, sizeof(request)); // writes the request
+
+	if (num_bytes != sizeof(request)) {
 		fprintf(stderr, "Failed to write to pipe\n");
 		setup_info.return_code = 1;
 		return setup_info;
@@ -94,16 +938,9 @@ ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path,
 		return setup_info;
 	}
 
-	int session_id; // session id from the server
-	num_bytes = read(resp_fd, &session_id, sizeof(int)); // reads the session id from the server
+	int session_id = read_session_id(resp_fd); // reads the session id from the server
 
-	if (num_bytes != sizeof(int)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		setup_info.return_code = 1;
-		return setup_info;
-	}
-
-	if (session_id == -1) {
+	if (session_id == -1 || negotiate_encoding(req_fd, resp_fd) != 0) {
 		fprintf(stderr, "Failed to connect to server\n");
 		setup_info.return_code = 1;
 		return setup_info;
@@ -111,6 +948,8 @@ ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path,
 
 	close(server_fd); // closes the server pipe
 
+	session_transport = EMS_TRANSPORT_FIFO;
+
 	// Fills the setup info:
 	setup_info.session_id = session_id;
 	setup_info.req_fd = req_fd;
@@ -121,15 +960,27 @@ ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path,
 }
 
 int ems_quit(int req_fd, int resp_fd, char const* req_pipe_path, char const* resp_pipe_path) { 
-	char op_code = '2'; // 2 for quit
-
-	ssize_t num_bytes = write(req_fd, &op_code, sizeof(char)); // writes the operation code
+	while (pending_count > 0) { // the responses to the requests in flight are still printed
+		complete_oldest(resp_fd);
+	}
 
-	if (num_bytes != sizeof(char)) {
+	if (send_frame(req_fd, '2', FRAME_ENCODING_FIXED, 0, NULL, 0) != 0) { // 2 for quit
 		fprintf(stderr, "Failed to write to pipe\n");
 		return 1;
 	}
-	
+
+	frame_buffer_destroy(&responses);
+	clear_show_cache();
+
+	if (session_transport == EMS_TRANSPORT_SHM) { // the server reads the quit request from the ring before seeing the socket closed
+		detach_shm();
+	}
+
+	if (session_transport != EMS_TRANSPORT_FIFO) { // there are no pipes, both file descriptors are the socket
+		close(req_fd); // closes the socket
+		return 0;
+	}
+
 	close(req_fd); // closes the request pipe
 	close(resp_fd); // closes the response pipe
 
@@ -139,240 +990,225 @@ int ems_quit(int req_fd, int resp_fd, char const* req_pipe_path, char const* res
 	return 0;
 }
 
-int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols, int req_fd, int resp_fd) {
-	char op_code = '3'; // 3 for create
+void ems_set_compact_encoding(int enabled) {
+	compact_encoding = enabled;
+}
 
-	ssize_t num_bytes = write(req_fd, &op_code, sizeof(char)); // writes the operation code
+void ems_set_show_cache(int enabled) {
+	show_cache_enabled = enabled;
+}
 
-	if (num_bytes != sizeof(char)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
+void ems_set_window(size_t num_requests) {
+	window = num_requests < 1 ? 1 : num_requests > EMS_MAX_WINDOW ? EMS_MAX_WINDOW : num_requests;
+}
 
-	num_bytes = write(req_fd, &event_id, sizeof(unsigned int)); // writes the event id
+ems_ticket ems_create_async(unsigned int event_id, size_t num_rows, size_t num_cols, int req_fd, int resp_fd) {
+	char payload[3 * VARINT_MAX_SIZE];
+	struct iovec parts[] = {{payload, encode_create(payload, session_encoding, event_id, num_rows, num_cols)}};
 
-	if (num_bytes != sizeof(unsigned int)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
+	return send_request(req_fd, resp_fd, '3', parts, 1, -1, NULL, NULL); // 3 for create
+}
 
-	num_bytes = write(req_fd, &num_rows, sizeof(size_t)); // writes the number of rows
+ems_ticket ems_reserve_async(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, int req_fd, int resp_fd) {
+	char* payload = malloc((2 + 2 * num_seats) * VARINT_MAX_SIZE);
 
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to write to pipe\n");
+	if (payload == NULL) {
+		fprintf(stderr, "Failed to allocate memory\n");
 		exit(EXIT_FAILURE);
 	}
 
-	num_bytes = write(req_fd, &num_cols, sizeof(size_t)); // writes the number of columns
+	struct iovec parts[] = {{payload, encode_reserve(payload, session_encoding, event_id, num_seats, xs, ys)}};
+	ems_ticket ticket = send_request(req_fd, resp_fd, '4', parts, 1, -1, NULL, NULL); // 4 for reserve
 
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
-
-	int return_code; // return code from the server
+	free(payload);
+	return ticket;
+}
 
-	num_bytes = read(resp_fd, &return_code, sizeof(int)); // reads the return code from the server
+ems_ticket ems_show_async(int out_fd, unsigned int event_id, int req_fd, int resp_fd) {
+	char payload[2 * VARINT_MAX_SIZE];
+	size_t size = put_number(payload, session_encoding, event_id, sizeof(unsigned int));
+	cached_event* cache = show_cache_enabled ? find_cached_event(event_id) : NULL;
 
-	if (num_bytes != sizeof(int)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
+	if (cache == NULL) { // every seat is sent
+		struct iovec parts[] = {{payload, size}};
+		return send_request(req_fd, resp_fd, '5', parts, 1, out_fd, NULL, NULL); // 5 for show
 	}
-	
-	return return_code;
-}
 
-int ems_reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, int req_fd, int resp_fd) {
-	char op_code = '4'; // 4 for reserve
+	// Only the seats that changed since the version kept are sent (the entry is kept until the response is read)
+	size += put_number(payload + size, session_encoding, cache->version, sizeof(unsigned int));
+	struct iovec parts[] = {{payload, size}};
 
-	ssize_t num_bytes = write(req_fd, &op_code, sizeof(char));
+	cache->in_flight++;
+	ems_ticket ticket = send_request(req_fd, resp_fd, 'A', parts, 1, out_fd, NULL, NULL); // A for show since
+	pending[(pending_head + pending_count - 1) % EMS_MAX_WINDOW].cache = cache;
 
-	if (num_bytes != sizeof(char)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
+	return ticket;
+}
 
-	num_bytes = write(req_fd, &event_id, sizeof(unsigned int));
+ems_ticket ems_list_events_async(int out_fd, int req_fd, int resp_fd) {
+	return send_request(req_fd, resp_fd, '6', NULL, 0, out_fd, NULL, NULL); // 6 for list events
+}
 
-	if (num_bytes != sizeof(unsigned int)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
+int ems_wait(ems_ticket ticket, int resp_fd) {
+	while (is_pending(ticket)) { // the responses arrive in order, so the older ones are completed first
+		complete_oldest(resp_fd);
 	}
 
-	num_bytes = write(req_fd, &num_seats, sizeof(size_t));
-
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
+	if (ticket_results[ticket % EMS_RESULT_HISTORY].ticket != ticket) { // never sent, or its result was already overwritten
+		fprintf(stderr, "Unknown ticket %u\n", ticket);
+		return 1;
 	}
 
-	num_bytes = write(req_fd, xs, sizeof(size_t) * num_seats);
+	return ticket_results[ticket % EMS_RESULT_HISTORY].return_code;
+}
 
-	if (num_bytes != (ssize_t)(sizeof(size_t) * num_seats)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
+int ems_poll(ems_ticket ticket, int resp_fd, int* return_code) {
+	while (is_pending(ticket)) {
+		struct pollfd ready = {resp_fd, POLLIN, 0};
+		int arrived = session_transport == EMS_TRANSPORT_SHM ? shm_ring_readable(&response_ring) : poll(&ready, 1, 0) > 0;
 
-	num_bytes = write(req_fd, ys, sizeof(size_t) * num_seats);
+		if (!frame_buffer_has_frame(&responses) && !arrived) { // no response arrived yet
+			return 0;
+		}
 
-	if (num_bytes != (ssize_t)(sizeof(size_t) * num_seats)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
+		complete_oldest(resp_fd);
 	}
 
-	int return_code; // return code from the server
-	num_bytes = read(resp_fd, &return_code, sizeof(int)); // reads the return code from the server
+	*return_code = ems_wait(ticket, resp_fd);
+	return 1;
+}
 
-	if (num_bytes != sizeof(int)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
-	}
+int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols, int req_fd, int resp_fd) {
+	return ems_wait(ems_create_async(event_id, num_rows, num_cols, req_fd, resp_fd), resp_fd);
+}
 
-	return return_code;
+int ems_reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, int req_fd, int resp_fd) {
+	return ems_wait(ems_reserve_async(event_id, num_seats, xs, ys, req_fd, resp_fd), resp_fd);
 }
 
 int ems_show(int out_fd, unsigned int event_id, int req_fd, int resp_fd) {
-	char op_code = '5'; // 5 for show
-
-	ssize_t num_bytes = write(req_fd, &op_code, sizeof(char));
-
-	if (num_bytes != sizeof(char)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
-
-	num_bytes = write(req_fd, &event_id, sizeof(unsigned int));
+	return ems_wait(ems_show_async(out_fd, event_id, req_fd, resp_fd), resp_fd);
+}
 
-	if (num_bytes != sizeof(unsigned int)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
+int ems_list_events(int out_fd, int req_fd, int resp_fd) {
+	return ems_wait(ems_list_events_async(out_fd, req_fd, resp_fd), resp_fd);
+}
 
-	int return_code; // return code from the server
-	size_t num_rows; // number of rows
-	size_t num_cols; // number of columns
-	unsigned int *seats; // array of seats
+/// Makes room for more bytes at the end of the operations of a batch.
+/// @param batch Batch to grow.
+/// @param size Number of bytes needed.
+/// @return Pointer to the end of the operations, NULL if the memory could not be allocated.
+static char* grow_batch(ems_batch* batch, size_t size) {
+	if (batch->size + size > batch->capacity) {
+		size_t capacity = batch->capacity > 0 ? batch->capacity : 256;
+		while (capacity < batch->size + size) {
+			capacity *= 2;
+		}
 
-	num_bytes = read(resp_fd, &return_code, sizeof(int)); // reads the return code from the server
+		char* grown = realloc(batch->data, capacity);
 
-	if (num_bytes != sizeof(int)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
-	}
+		if (grown == NULL) {
+			fprintf(stderr, "Failed to allocate memory\n");
+			return NULL;
+		}
 
-	if (return_code != 0) {
-		return return_code;
+		batch->data = grown;
+		batch->capacity = capacity;
 	}
 
-	num_bytes = read(resp_fd, &num_rows, sizeof(size_t)); // reads the number of rows from the server
+	return batch->data + batch->size;
+}
 
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
+/// Starts a new operation of a batch: makes room for it and appends its operation code and its group.
+/// The operations are encoded with the encoding of the session when the first one is added.
+/// @param batch Batch to append to.
+/// @param op_code Operation code of the operation.
+/// @param group Group of the operation.
+/// @param size Size of the payload of the operation (at most).
+/// @return Pointer to write the payload of the operation to, NULL if the batch is full.
+static char* start_batch_operation(ems_batch* batch, char op_code, unsigned char group, size_t size) {
+	if (batch->num_operations == MAX_BATCH_SIZE) {
+		return NULL;
 	}
 
-	num_bytes = read(resp_fd, &num_cols, sizeof(size_t)); // reads the number of columns from the server
+	char* operation = grow_batch(batch, 2 + size);
 
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
+	if (operation == NULL) {
+		return NULL;
 	}
 
-	seats = malloc(sizeof(unsigned int) * num_rows * num_cols); // allocates memory for the seats
-
-	if (seats == NULL) {
-		fprintf(stderr, "Failed to allocate memory\n");
-		exit(EXIT_FAILURE);
+	if (batch->num_operations == 0) {
+		batch->encoding = session_encoding;
 	}
 
-	num_bytes = read(resp_fd, seats, sizeof(unsigned int) * num_rows * num_cols); // reads the seats from the server
-
-	if (num_bytes != (ssize_t)(sizeof(unsigned int) * num_rows * num_cols)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
-	}
-
-	size_t i, j; // iterators
+	operation[0] = op_code;
+	operation[1] = (char)group;
+	batch->size += 2;
+	batch->num_operations++;
+	return operation + 2;
+}
 
-	for (i = 0; i < num_rows; i++) {
-		for (j = 0; j < num_cols; j++) {
-			char id[16];
-			sprintf(id, "%u", seats[i * num_cols + j]); // converts the seat id to a string
-			write(out_fd, id, strlen(id)); // writes the seat id to the output file
+void ems_batch_init(ems_batch* batch) {
+	memset(batch, 0, sizeof(ems_batch));
+}
 
-			if (j < num_cols - 1) { // writes a space if the seat is not the last seat in the row
-				write(out_fd, " ", 1); 
-			}
-		}
+int ems_batch_add_create(ems_batch* batch, unsigned int event_id, size_t num_rows, size_t num_cols) {
+	char* payload = start_batch_operation(batch, '3', 0, 3 * VARINT_MAX_SIZE); // 3 for create
 
-		write(out_fd, "\n", 1);
+	if (payload == NULL) {
+		return 1;
 	}
 
-	free(seats);
-
+	batch->size += encode_create(payload, batch->encoding, event_id, num_rows, num_cols);
 	return 0;
 }
 
-int ems_list_events(int out_fd, int req_fd, int resp_fd) {
-	char op_code = '6'; // 6 for list events
-	ssize_t num_bytes = write(req_fd, &op_code, sizeof(char));
+int ems_batch_add_reserve(ems_batch* batch, unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys) {
+	char* payload = start_batch_operation(batch, '4', batch->group, (2 + 2 * num_seats) * VARINT_MAX_SIZE); // 4 for reserve
 
-	if (num_bytes != sizeof(char)) {
-		fprintf(stderr, "Failed to write to pipe\n");
-		exit(EXIT_FAILURE);
-	}
-
-	int return_code; // return code from the server
-	size_t num_events; // number of events
-	unsigned int *events; // array of events
-
-	num_bytes = read(resp_fd, &return_code, sizeof(int)); // reads the return code from the server
-
-	if (num_bytes != sizeof(int)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
+	if (payload == NULL) {
+		return 1;
 	}
 
-	if (return_code != 0) {
-		return return_code;
-	}
+	batch->size += encode_reserve(payload, batch->encoding, event_id, num_seats, xs, ys);
+	return 0;
+}
 
-	num_bytes = read(resp_fd, &num_events, sizeof(size_t)); // reads the number of events from the server
+void ems_batch_begin_group(ems_batch* batch) {
+	batch->last_group = batch->last_group % UCHAR_MAX + 1; // differs from the previous group (and is never 0)
+	batch->group = batch->last_group;
+}
 
-	if (num_bytes != sizeof(size_t)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
-	}
+void ems_batch_end_group(ems_batch* batch) {
+	batch->group = 0;
+}
 
-	events = malloc(sizeof(unsigned int) * num_events); // allocates memory for the events
+ems_ticket ems_batch_send_async(ems_batch* batch, int* results, int req_fd, int resp_fd) {
+	char num_operations[VARINT_MAX_SIZE];
 
-	if (events == NULL) {
-		fprintf(stderr, "Failed to allocate memory\n");
-		exit(EXIT_FAILURE);
+	if (batch->num_operations == 0) {
+		batch->encoding = session_encoding;
 	}
 
-	num_bytes = read(resp_fd, events, sizeof(unsigned int) * num_events); // reads the events from the server
+	struct iovec parts[] = {
+		{num_operations, put_number(num_operations, batch->encoding, batch->num_operations, sizeof(size_t))},
+		{batch->data, batch->size},
+	};
 
-	if (num_bytes != (ssize_t)(sizeof(unsigned int) * num_events)) {
-		fprintf(stderr, "Failed to read from pipe\n");
-		exit(EXIT_FAILURE);
-	}
+	return send_request(req_fd, resp_fd, '7', parts, 2, -1, batch, results); // 7 for batch
+}
 
-	if (num_events == 0) {
-		const char* no_events = "No events\n";
-		write(out_fd, no_events, strlen(no_events));
-	} else {
-		size_t i;
-		for (i = 0; i < num_events; i++) {
-			write(out_fd, "Event: ", 7);
-			char id[16];
-			sprintf(id, "%u", events[i]);
-			write(out_fd, id, strlen(id));
-			write(out_fd, "\n", 1);
-		}
-	}
+int ems_batch_send(ems_batch* batch, int* results, int req_fd, int resp_fd) {
+	return ems_wait(ems_batch_send_async(batch, results, req_fd, resp_fd), resp_fd);
+}
 
-	free(events);
+void ems_batch_clear(ems_batch* batch) {
+	batch->size = 0;
+	batch->num_operations = 0;
+	batch->group = 0;
+}
 
-	return 0;
+void ems_batch_destroy(ems_batch* batch) {
+	free(batch->data);
+	ems_batch_init(batch);
 }
@@ -3,6 +3,29 @@
 
 #include <stddef.h>
 
+#define EMS_MAX_WINDOW 256 // maximum number of requests in flight (see ems_set_window)
+#define EMS_MAX_BYTES_IN_FLIGHT 32768 // maximum size of the requests in flight (less than the capacity of a pipe)
+#define EMS_RESULT_HISTORY 1024 // number of results of completed requests kept for ems_wait and ems_poll
+#define EMS_SHOW_CACHE_SIZE 16 // number of events whose seats are kept, so showing them again only gets what changed
+
+typedef unsigned int ems_ticket; // identifies a request sent with an asynchronous call (never 0)
+
+typedef struct {
+	char* data; // the operations added, as they are sent
+	size_t size; // size of the operations in bytes
+	size_t capacity; // size of data
+	size_t num_operations; // number of operations added (at most MAX_BATCH_SIZE)
+	unsigned char group; // group of the reserves being added (0 outside a group)
+	unsigned char last_group; // last group started
+	char encoding; // encoding of the operations (the encoding of the session when the first one was added)
+} ems_batch; // operations sent to the server in a single request (see ems_batch_send)
+
+typedef enum {
+	EMS_TRANSPORT_FIFO, // named pipes: a registration pipe on the server, a request and a response pipe per client
+	EMS_TRANSPORT_SOCKET, // a single connection to the Unix domain socket of the server (started with --socket)
+	EMS_TRANSPORT_SHM, // the socket, then a request and a response ring in shared memory (falls back to the socket)
+} ems_transport; // how the client talks to the server
+
 typedef struct {
 	int return_code; // 0 if the operation was successful, 1 otherwise
 	int req_fd; // file descriptor to write requests to
@@ -11,17 +34,29 @@ typedef struct {
 } ems_setup_data;
 
 /// Connects to an EMS server.
-/// @param req_pipe_path Path to the name pipe to be created for requests.
-/// @param resp_pipe_path Path to the name pipe to be created for responses.
-/// @param server_pipe_path Path to the name pipe where the server is listening.
-/// @return A ems_setup_data struct with the return code and the file descriptors for requests and responses.
-ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path, char const* server_pipe_path);
+/// @param req_pipe_path Path to the name pipe to be created for requests (unused with the socket).
+/// @param resp_pipe_path Path to the name pipe to be created for responses (unused with the socket).
+/// @param server_pipe_path Path to the name pipe (or socket) where the server is listening.
+/// @param transport Transport used to talk to the server.
+/// @return A ems_setup_data struct with the return code and the file descriptors for requests and responses
+///         (with EMS_TRANSPORT_SOCKET and EMS_TRANSPORT_SHM both are the same socket).
+ems_setup_data ems_setup(char const* req_pipe_path, char const* resp_pipe_path, char const* server_pipe_path, ems_transport transport);
+
+/// Sets whether ems_setup asks the server for the compact encoding of requests and responses (varints instead of
+/// size_t and unsigned int, and the seats of a SHOW as runs). It is used if the server knows it. Enabled by default.
+/// @param enabled 1 to ask for the compact encoding, 0 to keep the fixed encoding.
+void ems_set_compact_encoding(int enabled);
+
+/// Sets whether the seats of the events shown are kept (for the last EMS_SHOW_CACHE_SIZE events), so showing
+/// an event again only gets the seats that changed since. Enabled by default.
+/// @param enabled 1 to keep the seats, 0 to get every seat of an event each time it is shown.
+void ems_set_show_cache(int enabled);
 
 /// Disconnects from an EMS server.
 /// @param req_fd File descriptor to write requests to.
 /// @param resp_fd File descriptor to read responses from.
-/// @param req_pipe_path Path to the name pipe to be created for requests.
-/// @param resp_pipe_path Path to the name pipe to be created for responses.
+/// @param req_pipe_path Path to the name pipe to be created for requests (unused with the socket).
+/// @param resp_pipe_path Path to the name pipe to be created for responses (unused with the socket).
 /// @return 0 in case of success, 1 otherwise.
 int ems_quit(int req_fd, int resp_fd, char const* req_pipe_path, char const* resp_pipe_path);
 
@@ -36,7 +71,7 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols, int req_
 
 /// Creates a new reservation for the given event.
 /// @param event_id Id of the event to create a reservation for.
-/// @param num_seats Number of seats to reserve.
+/// @param num_seats Number of seats to reserve (at most MAX_RESERVATION_SIZE).
 /// @param xs Array of rows of the seats to reserve.
 /// @param ys Array of columns of the seats to reserve.
 /// @param req_fd File descriptor to write requests to.
@@ -59,4 +94,87 @@ int ems_show(int out_fd, unsigned int event_id, int req_fd, int resp_fd);
 /// @return 0 if the events were printed successfully, 1 otherwise.
 int ems_list_events(int out_fd, int req_fd, int resp_fd);
 
+/// Sets the maximum number of requests in flight. An asynchronous call made with a full window first waits for the
+/// oldest responses. The default is 1, so requests are not pipelined unless asked for.
+/// @param num_requests Maximum number of requests in flight (clamped to 1..EMS_MAX_WINDOW).
+void ems_set_window(size_t num_requests);
+
+/// Sends a request to create a new event without waiting for the response (see ems_create).
+/// @return The ticket of the request, to collect its result with ems_wait or ems_poll.
+ems_ticket ems_create_async(unsigned int event_id, size_t num_rows, size_t num_cols, int req_fd, int resp_fd);
+
+/// Sends a request to create a new reservation without waiting for the response (see ems_reserve).
+/// The arrays of seats can be reused as soon as the call returns.
+/// @return The ticket of the request, to collect its result with ems_wait or ems_poll.
+ems_ticket ems_reserve_async(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys, int req_fd, int resp_fd);
+
+/// Sends a request to print an event without waiting for the response (see ems_show).
+/// The event is printed to out_fd when the response is read, in the order the requests were sent.
+/// @return The ticket of the request, to collect its result with ems_wait or ems_poll.
+ems_ticket ems_show_async(int out_fd, unsigned int event_id, int req_fd, int resp_fd);
+
+/// Sends a request to print all the events without waiting for the response (see ems_list_events).
+/// The events are printed to out_fd when the response is read, in the order the requests were sent.
+/// @return The ticket of the request, to collect its result with ems_wait or ems_poll.
+ems_ticket ems_list_events_async(int out_fd, int req_fd, int resp_fd);
+
+/// Waits for the response to a request (and to the requests sent before it).
+/// @param ticket Ticket of the request.
+/// @param resp_fd File descriptor to read responses from.
+/// @return The return code of the request (1 if the ticket is unknown or too old).
+int ems_wait(ems_ticket ticket, int resp_fd);
+
+/// Collects the responses that already arrived, without blocking, until the one to a request.
+/// @param ticket Ticket of the request.
+/// @param resp_fd File descriptor to read responses from.
+/// @param return_code Pointer to store the return code of the request in (if it completed).
+/// @return 1 if the request completed, 0 if its response didn't arrive yet.
+int ems_poll(ems_ticket ticket, int resp_fd, int* return_code);
+
+/// Initializes an empty batch.
+/// @param batch Batch to initialize.
+void ems_batch_init(ems_batch* batch);
+
+/// Adds the creation of an event to a batch (see ems_create).
+/// @param batch Batch to add the operation to.
+/// @return 0 if the operation was added, 1 if the batch is full.
+int ems_batch_add_create(ems_batch* batch, unsigned int event_id, size_t num_rows, size_t num_cols);
+
+/// Adds a reservation to a batch (see ems_reserve). It is part of the current group, if one was started.
+/// @param batch Batch to add the operation to.
+/// @return 0 if the operation was added, 1 if the batch is full.
+int ems_batch_add_reserve(ems_batch* batch, unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys);
+
+/// Starts a group of reservations: the reservations added until ems_batch_end_group are created as a whole,
+/// either all of them or none (they all get the same result).
+/// @param batch Batch to start the group in.
+void ems_batch_begin_group(ems_batch* batch);
+
+/// Ends the current group of reservations of a batch.
+/// @param batch Batch to end the group in.
+void ems_batch_end_group(ems_batch* batch);
+
+/// Sends a batch without waiting for the response: the server runs its operations in order.
+/// The batch can be cleared or changed as soon as the call returns.
+/// @param batch Batch to send.
+/// @param results Array to store the return code of each operation in (filled when the response is read).
+/// @return The ticket of the request, to collect its result with ems_wait or ems_poll.
+ems_ticket ems_batch_send_async(ems_batch* batch, int* results, int req_fd, int resp_fd);
+
+/// Sends a batch and waits for the results of its operations.
+/// @param batch Batch to send.
+/// @param results Array to store the return code of each operation in.
+/// @param req_fd File descriptor to write requests to.
+/// @param resp_fd File descriptor to read responses from.
+/// @return 0 if the batch ran (the results are in the array), 1 otherwise.
+int ems_batch_send(ems_batch* batch, int* results, int req_fd, int resp_fd);
+
+/// Removes the operations of a batch (keeping its memory for the next ones).
+/// @param batch Batch to clear.
+void ems_batch_clear(ems_batch* batch);
+
+/// Frees the memory of a batch.
+/// @param batch Batch to destroy.
+void ems_batch_destroy(ems_batch* batch);
+
 #endif  // CLIENT_API_H
@@ -16,31 +16,185 @@ void sigpipe_handler(int signum) {
 	exit(1);
 }
 
+typedef struct {
+	ems_ticket ticket; // ticket of the request
+	const char* failure_message; // printed if the request fails
+} outstanding_request; // a request whose result wasn't checked yet
+
+static outstanding_request outstanding[EMS_MAX_WINDOW]; // requests sent, in order (a circular buffer)
+static size_t outstanding_head = 0; // position of the oldest request
+static size_t outstanding_count = 0; // number of requests
+static size_t window = 1; // number of requests that can be outstanding (--window)
+
+static ems_batch batch; // consecutive creates and reserves not sent yet (--batch)
+static const char* batch_failure_messages[MAX_BATCH_SIZE]; // printed for the operations of the batch that fail
+static int batch_results[MAX_BATCH_SIZE]; // results of the operations of the batch
+static size_t batch_size = 0; // maximum number of operations of a batch (0 if the commands are not batched)
+
+/// Checks the results of the outstanding requests in order, printing the failures.
+/// @param resp_fd File descriptor to read responses from.
+/// @param max_outstanding Waits until at most this many requests are outstanding (the rest are only checked if they
+///        already completed).
+void check_requests(int resp_fd, size_t max_outstanding) {
+	while (outstanding_count > 0) {
+		outstanding_request* request = &outstanding[outstanding_head];
+		int return_code;
+
+		if (outstanding_count > max_outstanding) {
+			return_code = ems_wait(request->ticket, resp_fd);
+		} else if (!ems_poll(request->ticket, resp_fd, &return_code)) {
+			return;
+		}
+
+		if (return_code != 0) {
+			fprintf(stderr, "%s\n", request->failure_message);
+		}
+
+		outstanding_head = (outstanding_head + 1) % EMS_MAX_WINDOW;
+		outstanding_count--;
+	}
+}
+
+/// Keeps a request sent with an asynchronous call outstanding, checking the results of the oldest ones if the window is full.
+/// @param ticket Ticket of the request.
+/// @param failure_message Printed if the request fails.
+/// @param resp_fd File descriptor to read responses from.
+void add_request(ems_ticket ticket, const char* failure_message, int resp_fd) {
+	outstanding[(outstanding_head + outstanding_count) % EMS_MAX_WINDOW] = (outstanding_request){ticket, failure_message};
+	outstanding_count++;
+
+	check_requests(resp_fd, window - 1);
+}
+
+/// Sends the operations batched so far in a single request, printing the ones that fail.
+/// @param req_fd File descriptor to write requests to.
+/// @param resp_fd File descriptor to read responses from.
+void send_batch(int req_fd, int resp_fd) {
+	if (batch.num_operations == 0) {
+		return;
+	}
+
+	check_requests(resp_fd, 0); // the requests sent before the batch are checked first
+
+	int return_code = ems_batch_send(&batch, batch_results, req_fd, resp_fd);
+
+	for (size_t i = 0; i < batch.num_operations; i++) {
+		if (return_code != 0 || batch_results[i] != 0) { // if the batch failed, none of its operations ran
+			fprintf(stderr, "%s\n", batch_failure_messages[i]);
+		}
+	}
+
+	ems_batch_clear(&batch);
+}
+
+/// Keeps the operation just added to the batch, sending the batch if it is full.
+/// @param failure_message Printed if the operation fails.
+/// @param req_fd File descriptor to write requests to.
+/// @param resp_fd File descriptor to read responses from.
+void add_to_batch(const char* failure_message, int req_fd, int resp_fd) {
+	batch_failure_messages[batch.num_operations - 1] = failure_message;
+
+	if (batch.num_operations == batch_size) {
+		send_batch(req_fd, resp_fd);
+	}
+}
+
+/// Parses an option with a number (--name=N).
+/// @param arg The argument.
+/// @param name The name of the option (with the leading dashes and the '=').
+/// @param max The maximum value.
+/// @param value Pointer to store the value in.
+/// @return 1 if the argument is the option, 0 if it is not, -1 if the value is invalid.
+int parse_number_option(const char* arg, const char* name, size_t max, size_t* value) {
+	if (strncmp(arg, name, strlen(name)) != 0) {
+		return 0;
+	}
+
+	char* endptr;
+	unsigned long number = strtoul(arg + strlen(name), &endptr, 10);
+
+	if (*endptr != '\0' || number < 1 || number > max) {
+		fprintf(stderr, "Invalid value of %.*s (it must be between 1 and %zu)\n", (int)strlen(name) - 1, name, max);
+		return -1;
+	}
+
+	*value = number;
+	return 1;
+}
+
 int main(int argc, char* argv[]) {
 	if (signal(SIGPIPE, sigpipe_handler) == SIG_ERR) {
 		fprintf(stderr, "Failed to set SIGPIPE handler\n");
 		return 1;
 	}
 
-	if (argc < 5) { // 4 arguments + 1 for the program name
-		fprintf(stderr, "Usage: %s <request pipe path> <response pipe path> <server pipe path> <.jobs file path>\n", argv[0]);
+	char* program_name = argv[0];
+	while (argc > 1) { // --window=N keeps up to N requests in flight, --batch=N sends up to N creates and reserves at once
+		if (strcmp(argv[1], "--fixed-encoding") == 0) { // numbers are sent as they are in memory (no varints)
+			ems_set_compact_encoding(0);
+			argc--;
+			argv++;
+			continue;
+		}
+
+		if (strcmp(argv[1], "--no-show-cache") == 0) { // every seat is sent each time an event is shown
+			ems_set_show_cache(0);
+			argc--;
+			argv++;
+			continue;
+		}
+
+		int parsed = parse_number_option(argv[1], "--window=", EMS_MAX_WINDOW, &window);
+
+		if (parsed == 0) {
+			parsed = parse_number_option(argv[1], "--batch=", MAX_BATCH_SIZE, &batch_size);
+		}
+
+		if (parsed == -1) {
+			return 1;
+		} else if (parsed == 0) {
+			break;
+		}
+
+		argc--;
+		argv++;
+	}
+
+	ems_transport transport = EMS_TRANSPORT_FIFO;
+	char const* req_pipe_path = NULL;
+	char const* resp_pipe_path = NULL;
+	char const* server_path;
+	char* jobs_path;
+
+	if (argc == 4 && (strcmp(argv[1], "--socket") == 0 || strcmp(argv[1], "--shm") == 0)) { // the server was started with --socket, no pipes are needed
+		transport = strcmp(argv[1], "--shm") == 0 ? EMS_TRANSPORT_SHM : EMS_TRANSPORT_SOCKET; // --shm then moves the session to shared memory
+		server_path = argv[2];
+		jobs_path = argv[3];
+	} else if (argc >= 5) { // 4 arguments + 1 for the program name
+		req_pipe_path = argv[1];
+		resp_pipe_path = argv[2];
+		server_path = argv[3];
+		jobs_path = argv[4];
+	} else {
+		fprintf(stderr, "Usage: %s [--window=N] [--batch=N] [--fixed-encoding] [--no-show-cache] <request pipe path> <response pipe path> <server pipe path> <.jobs file path>\n", program_name);
+		fprintf(stderr, "       %s [--window=N] [--batch=N] [--fixed-encoding] [--no-show-cache] --socket|--shm <server socket path> <.jobs file path>\n", program_name);
 		return 1;
 	}
 
-	const char* dot = strrchr(argv[4], '.'); // Checks if the file path is valid
-	if (dot == NULL || dot == argv[4] || strlen(dot) != 5 || strcmp(dot, ".jobs") ||
-			strlen(argv[4]) > MAX_JOB_FILE_NAME_SIZE) {
-		fprintf(stderr, "The provided .jobs file path is not valid. Path: %s\n", argv[1]);
+	const char* dot = strrchr(jobs_path, '.'); // Checks if the file path is valid
+	if (dot == NULL || dot == jobs_path || strlen(dot) != 5 || strcmp(dot, ".jobs") ||
+			strlen(jobs_path) > MAX_JOB_FILE_NAME_SIZE) {
+		fprintf(stderr, "The provided .jobs file path is not valid. Path: %s\n", jobs_path);
 		return 1;
 	}
 
 	char out_path[MAX_JOB_FILE_NAME_SIZE];
-	strcpy(out_path, argv[4]);
+	strcpy(out_path, jobs_path);
 	strcpy(strrchr(out_path, '.'), ".out");
 
-	int in_fd = open(argv[4], O_RDONLY); // opens the input file
+	int in_fd = open(jobs_path, O_RDONLY); // opens the input file
 	if (in_fd == -1) {
-		fprintf(stderr, "Failed to open input file. Path: %s\n", argv[4]);
+		fprintf(stderr, "Failed to open input file. Path: %s\n", jobs_path);
 		return 1;
 	}
 
@@ -50,7 +204,7 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 	
-	ems_setup_data setup_info = ems_setup(argv[1], argv[2], argv[3]); // setup the client
+	ems_setup_data setup_info = ems_setup(req_pipe_path, resp_pipe_path, server_path, transport); // setup the client
 
 	if (setup_info.return_code == 1) {
 		fprintf(stderr, "Failed to set up the client\n");
@@ -59,6 +213,9 @@ int main(int argc, char* argv[]) {
 
 	printf("The server received our request. Our session ID is %d\n", setup_info.session_id);
 
+	ems_set_window(window);
+	ems_batch_init(&batch);
+
 	while (1) {
 		unsigned int event_id;
 		size_t num_rows, num_columns, num_coords;
@@ -74,10 +231,18 @@ int main(int argc, char* argv[]) {
 					continue;
 				}
 
-				if (ems_create(event_id, num_rows, num_columns, setup_info.req_fd, setup_info.resp_fd) != 0) {
-					fprintf(stderr, "Failed to create event\n");
+				if (batch_size > 0) {
+					if (ems_batch_add_create(&batch, event_id, num_rows, num_columns) != 0) {
+						fprintf(stderr, "Failed to create event\n");
+					} else {
+						add_to_batch("Failed to create event", setup_info.req_fd, setup_info.resp_fd);
+					}
+					break;
 				}
 
+				add_request(ems_create_async(event_id, num_rows, num_columns, setup_info.req_fd, setup_info.resp_fd),
+						"Failed to create event", setup_info.resp_fd);
+
 				break;
 
 			case CMD_RESERVE:
@@ -88,10 +253,18 @@ int main(int argc, char* argv[]) {
 					continue;
 				}
 
-				if (ems_reserve(event_id, num_coords, xs, ys, setup_info.req_fd, setup_info.resp_fd) != 0) {
-					fprintf(stderr, "Failed to reserve seats\n");
+				if (batch_size > 0) {
+					if (ems_batch_add_reserve(&batch, event_id, num_coords, xs, ys) != 0) {
+						fprintf(stderr, "Failed to reserve seats\n");
+					} else {
+						add_to_batch("Failed to reserve seats", setup_info.req_fd, setup_info.resp_fd);
+					}
+					break;
 				}
 
+				add_request(ems_reserve_async(event_id, num_coords, xs, ys, setup_info.req_fd, setup_info.resp_fd),
+						"Failed to reserve seats", setup_info.resp_fd);
+
 				break;
 
 			case CMD_SHOW:
@@ -100,16 +273,16 @@ int main(int argc, char* argv[]) {
 					continue;
 				}
 
-				if (ems_show(out_fd, event_id, setup_info.req_fd, setup_info.resp_fd) != 0) {
-					fprintf(stderr, "Failed to show event\n");
-				}
+				send_batch(setup_info.req_fd, setup_info.resp_fd); // the creates and reserves before it run first
+				add_request(ems_show_async(out_fd, event_id, setup_info.req_fd, setup_info.resp_fd),
+						"Failed to show event", setup_info.resp_fd);
 				
 				break;
 
 			case CMD_LIST_EVENTS:
-				if (ems_list_events(out_fd, setup_info.req_fd, setup_info.resp_fd) != 0) {
-					fprintf(stderr, "Failed to list events\n");
-				}
+				send_batch(setup_info.req_fd, setup_info.resp_fd);
+				add_request(ems_list_events_async(out_fd, setup_info.req_fd, setup_info.resp_fd),
+						"Failed to list events", setup_info.resp_fd);
 
 				break;
 
@@ -119,6 +292,9 @@ int main(int argc, char* argv[]) {
 						continue;
 				}
 
+				send_batch(setup_info.req_fd, setup_info.resp_fd);
+				check_requests(setup_info.resp_fd, 0); // the requests before the wait complete before it starts
+
 				if (delay > 0) {
 						printf("Waiting...\n");
 						sleep(delay);
@@ -147,8 +323,12 @@ int main(int argc, char* argv[]) {
 				break;
 
 			case EOC:
+				send_batch(setup_info.req_fd, setup_info.resp_fd);
+				check_requests(setup_info.resp_fd, 0);
+				ems_batch_destroy(&batch);
+
 				int return_code;
-				if ((return_code = ems_quit(setup_info.req_fd, setup_info.resp_fd, argv[1], argv[2])) != 0) {
+				if ((return_code = ems_quit(setup_info.req_fd, setup_info.resp_fd, req_pipe_path, resp_pipe_path)) != 0) {
 					fprintf(stderr, "Failed to quit\n");
 				}
 				close(in_fd);
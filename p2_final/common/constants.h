@@ -1,5 +1,5 @@
 #define MAX_RESERVATION_SIZE 256
 #define STATE_ACCESS_DELAY_US 500000  // 500ms
 #define MAX_JOB_FILE_NAME_SIZE 256
-#define MAX_SESSION_COUNT 8
-#define PIPE_PATH_MAX 40
\ No newline at end of file
+#define PIPE_PATH_MAX 40
+#define MAX_BATCH_SIZE 4096
\ No newline at end of file
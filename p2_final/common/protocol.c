@@ -0,0 +1,356 @@
+#include "protocol.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void frame_buffer_init(frame_buffer *buffer) {
+	buffer->data = NULL;
+	buffer->capacity = 0;
+	buffer->start = 0;
+	buffer->end = 0;
+	buffer->max_length = 0;
+}
+
+void frame_buffer_destroy(frame_buffer *buffer) {
+	free(buffer->data);
+	frame_buffer_init(buffer);
+}
+
+/// Gets the total size (header and payload) of the frame at the start of the buffer.
+/// @param buffer The frame buffer.
+/// @return The size of the frame, 0 if its header wasn't read yet.
+static size_t next_frame_size(const frame_buffer *buffer) {
+	if (buffer->end - buffer->start < sizeof(frame_header)) {
+		return 0;
+	}
+
+	frame_header header;
+	memcpy(&header, buffer->data + buffer->start, sizeof(header));
+	return sizeof(header) + header.length;
+}
+
+int frame_buffer_has_frame(const frame_buffer *buffer) {
+	size_t size = next_frame_size(buffer);
+	return size != 0 && buffer->end - buffer->start >= size;
+}
+
+/// Makes room in the buffer for a frame of the given size (at least), moving the bytes not consumed to the start.
+/// @param buffer The frame buffer.
+/// @param size The size needed after the start of the buffer.
+/// @return 0 if there is room, 1 if the memory could not be allocated.
+static int reserve_frame(frame_buffer *buffer, size_t size) {
+	if (buffer->start > 0) {
+		memmove(buffer->data, buffer->data + buffer->start, buffer->end - buffer->start);
+		buffer->end -= buffer->start;
+		buffer->start = 0;
+	}
+
+	if (size <= buffer->capacity) {
+		return 0;
+	}
+
+	size_t capacity = buffer->capacity > 0 ? buffer->capacity : FRAME_BUFFER_INITIAL_SIZE;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+
+	char *data = realloc(buffer->data, capacity);
+	if (data == NULL) {
+		return 1;
+	}
+
+	buffer->data = data;
+	buffer->capacity = capacity;
+	return 0;
+}
+
+int read_frame_from(frame_source read_some, void *source, frame_buffer *buffer, frame_header *header, const char **payload) {
+	size_t max_length = buffer->max_length != 0 ? buffer->max_length : FRAME_MAX_LENGTH;
+
+	while (!frame_buffer_has_frame(buffer)) {
+		size_t size = next_frame_size(buffer);
+
+		if (size > sizeof(frame_header) + max_length) {
+			return 1;
+		}
+
+		if (buffer->start == buffer->end) { // nothing left, the next read starts at the beginning of the buffer
+			buffer->start = 0;
+			buffer->end = 0;
+		}
+
+		size_t needed = size > 0 ? size : sizeof(frame_header); // the frame, or its header if its size isn't known yet
+		if (buffer->start + needed > buffer->capacity && reserve_frame(buffer, needed) != 0) {
+			return 1;
+		}
+
+		ssize_t read_bytes = read_some(source, buffer->data + buffer->end, buffer->capacity - buffer->end);
+		if (read_bytes == -1 && errno == EINTR) {
+			continue;
+		} else if (read_bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) { // the bytes read so far stay in the buffer
+			return 2;
+		} else if (read_bytes <= 0) {
+			return 1;
+		}
+
+		buffer->end += (size_t)read_bytes;
+	}
+
+	memcpy(header, buffer->data + buffer->start, sizeof(*header));
+	*payload = buffer->data + buffer->start + sizeof(*header);
+	buffer->start += sizeof(*header) + header->length;
+
+	return 0;
+}
+
+/// Reads from a file descriptor (the source of read_frame).
+/// @param source Pointer to the file descriptor.
+/// @param data The buffer to read to.
+/// @param size The size of the buffer.
+/// @return The number of bytes read, 0 at the end of file, -1 on error.
+static ssize_t read_fd(void *source, void *data, size_t size) {
+	return read(*(int *)source, data, size);
+}
+
+int read_frame(int fd, frame_buffer *buffer, frame_header *header, const char **payload) {
+	return read_frame_from(read_fd, &fd, buffer, header, payload);
+}
+
+int prepare_frame(frame_header *header, struct iovec *iov, char op_code, char encoding, uint32_t request_id,
+		const struct iovec *parts, int num_parts) {
+	memset(header, 0, sizeof(*header));
+	header->op_code = op_code;
+	header->encoding = encoding;
+	header->request_id = request_id;
+
+	int num_iov = 0;
+	iov[num_iov].iov_base = header;
+	iov[num_iov++].iov_len = sizeof(*header);
+
+	size_t length = 0;
+	for (int i = 0; i < num_parts && i < FRAME_MAX_PARTS; i++) {
+		if (parts[i].iov_len == 0) {
+			continue;
+		}
+
+		iov[num_iov++] = parts[i];
+		length += parts[i].iov_len;
+	}
+
+	if (length > FRAME_MAX_LENGTH) {
+		return -1;
+	}
+	header->length = (uint32_t)length;
+
+	return num_iov;
+}
+
+/// Writes to a file descriptor (the sink of write_frame and write_frame_nonblocking).
+/// @param sink Pointer to the file descriptor.
+/// @param iov The parts to write.
+/// @param num_iov The number of parts.
+/// @return The number of bytes written, -1 on error.
+static ssize_t write_fd(void *sink, const struct iovec *iov, int num_iov) {
+	return writev(*(int *)sink, iov, num_iov);
+}
+
+/// Writes parts to a sink, continuing writes that only write some of them.
+/// @param write_some The function writing to the sink.
+/// @param sink The sink, passed to write_some.
+/// @param next Pointer to the first part to write (advanced past the parts written).
+/// @param num_iov Pointer to the number of parts to write (0 once every part was written).
+/// @return 0 if every part was written, 1 if the write failed, 2 if the sink is full (non-blocking).
+static int write_parts(frame_sink write_some, void *sink, struct iovec **next, int *num_iov) {
+	while (*num_iov > 0) {
+		ssize_t written = write_some(sink, *next, *num_iov);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		} else if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return 2;
+		} else if (written == -1) {
+			return 1;
+		}
+
+		// Skips what was written (a large frame may be written in several calls)
+		size_t remaining = (size_t)written;
+		while (*num_iov > 0 && remaining >= (*next)->iov_len) {
+			remaining -= (*next)->iov_len;
+			(*next)++;
+			(*num_iov)--;
+		}
+
+		if (*num_iov > 0) {
+			(*next)->iov_base = (char *)(*next)->iov_base + remaining;
+			(*next)->iov_len -= remaining;
+		}
+	}
+
+	return 0;
+}
+
+int write_frame(int fd, char op_code, char encoding, uint32_t request_id, const struct iovec *parts, int num_parts) {
+	frame_header header;
+	struct iovec iov[FRAME_MAX_PARTS + 1];
+	int num_iov = prepare_frame(&header, iov, op_code, encoding, request_id, parts, num_parts);
+
+	if (num_iov == -1) {
+		return 1;
+	}
+
+	struct iovec *next = iov;
+	return write_parts(write_fd, &fd, &next, &num_iov) == 0 ? 0 : 1;
+}
+
+int write_frame_nonblocking(int fd, frame_buffer *pending, char op_code, char encoding, uint32_t request_id,
+		const struct iovec *parts, int num_parts) {
+	return write_frame_nonblocking_to(write_fd, &fd, pending, op_code, encoding, request_id, parts, num_parts);
+}
+
+int write_frame_nonblocking_to(frame_sink write_some, void *sink, frame_buffer *pending, char op_code, char encoding,
+		uint32_t request_id, const struct iovec *parts, int num_parts) {
+	frame_header header;
+	struct iovec iov[FRAME_MAX_PARTS + 1];
+	int num_iov = prepare_frame(&header, iov, op_code, encoding, request_id, parts, num_parts);
+
+	if (num_iov == -1) {
+		return 1;
+	}
+
+	struct iovec *next = iov;
+	if (pending->start == pending->end && write_parts(write_some, sink, &next, &num_iov) == 1) { // written now, unless frames are waiting
+		return 1;
+	}
+
+	size_t size = 0; // the size of what is left
+	for (int i = 0; i < num_iov; i++) {
+		size += next[i].iov_len;
+	}
+
+	if (size == 0) {
+		return 0;
+	}
+
+	if (reserve_frame(pending, pending->end - pending->start + size) != 0) {
+		return 1;
+	}
+
+	for (int i = 0; i < num_iov; i++) {
+		memcpy(pending->data + pending->end, next[i].iov_base, next[i].iov_len);
+		pending->end += next[i].iov_len;
+	}
+
+	return 0;
+}
+
+int flush_frames(int fd, frame_buffer *pending) {
+	return flush_frames_to(write_fd, &fd, pending);
+}
+
+int flush_frames_to(frame_sink write_some, void *sink, frame_buffer *pending) {
+	while (pending->start < pending->end) {
+		struct iovec left = {pending->data + pending->start, pending->end - pending->start};
+		ssize_t written = write_some(sink, &left, 1);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		} else if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return 2;
+		} else if (written == -1) {
+			return 1;
+		}
+
+		pending->start += (size_t)written;
+	}
+
+	if (pending->capacity > FRAME_BUFFER_INITIAL_SIZE) { // a large response doesn't keep its memory once written
+		frame_buffer_destroy(pending);
+	}
+	pending->start = 0;
+	pending->end = 0;
+
+	return 0;
+}
+
+size_t put_varint(char *out, uint64_t value) {
+	size_t size = 0;
+
+	do {
+		char byte = (char)(value & 0x7f);
+		value >>= 7;
+
+		if (out != NULL) {
+			out[size] = (char)(byte | (value != 0 ? 0x80 : 0)); // the high bit tells that more bytes follow
+		}
+		size++;
+	} while (value != 0);
+
+	return size;
+}
+
+int get_varint(const char **next, size_t *remaining, uint64_t *value) {
+	*value = 0;
+
+	for (size_t i = 0; i < VARINT_MAX_SIZE && i < *remaining; i++) {
+		unsigned char byte = (unsigned char)(*next)[i];
+		*value |= (uint64_t)(byte & 0x7f) << (7 * i);
+
+		if ((byte & 0x80) == 0) {
+			*next += i + 1;
+			*remaining -= i + 1;
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+size_t encode_seat_runs(const unsigned int *seats, size_t num_seats, char *out) {
+	size_t size = 0;
+	int64_t previous = 0; // reservation id of the previous run
+
+	for (size_t start = 0; start < num_seats;) {
+		size_t end = start + 1;
+		while (end < num_seats && seats[end] == seats[start]) {
+			end++;
+		}
+
+		int64_t delta = (int64_t)seats[start] - previous;
+		uint64_t zigzag = delta >= 0 ? (uint64_t)delta << 1 : ((uint64_t)(-delta) << 1) - 1; // small differences are small numbers
+
+		size += put_varint(out != NULL ? out + size : NULL, zigzag);
+		size += put_varint(out != NULL ? out + size : NULL, end - start);
+
+		previous = seats[start];
+		start = end;
+	}
+
+	return size;
+}
+
+int decode_seat_runs(const char *in, size_t length, unsigned int *seats, size_t num_seats) {
+	size_t decoded = 0;
+	int64_t previous = 0; // reservation id of the previous run
+
+	while (length > 0) {
+		uint64_t zigzag, run;
+
+		if (get_varint(&in, &length, &zigzag) != 0 || get_varint(&in, &length, &run) != 0 || run > num_seats - decoded) {
+			return 1;
+		}
+
+		int64_t seat = previous + ((zigzag & 1) == 0 ? (int64_t)(zigzag >> 1) : -(int64_t)((zigzag + 1) >> 1));
+
+		if (seat < 0 || seat > UINT32_MAX) {
+			return 1;
+		}
+
+		for (uint64_t i = 0; i < run; i++) {
+			seats[decoded++] = (unsigned int)seat;
+		}
+
+		previous = seat;
+	}
+
+	return decoded != num_seats;
+}
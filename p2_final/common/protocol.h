@@ -0,0 +1,164 @@
+#ifndef COMMON_PROTOCOL_H
+#define COMMON_PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "constants.h"
+
+#define FRAME_MAX_LENGTH (1u << 30) // Maximum payload length of a frame (anything longer is a corrupted stream)
+#define FRAME_MAX_RESERVE_LENGTH ((2 + 2 * MAX_RESERVATION_SIZE) * VARINT_MAX_SIZE) // Maximum payload length of a reserve (either encoding)
+#define FRAME_MAX_REQUEST_LENGTH (VARINT_MAX_SIZE + MAX_BATCH_SIZE * (2 + FRAME_MAX_RESERVE_LENGTH)) // Maximum payload length of a request (a batch of the longest reserves)
+#define FRAME_BUFFER_INITIAL_SIZE 4096 // Initial size of a frame buffer (enough for any request, it grows for large responses)
+#define FRAME_MAX_PARTS 8 // Maximum number of parts of the payload of a frame written at once
+
+#define FRAME_ENCODING_FIXED 0 // numbers of the payload as they are in memory (size_t, unsigned int)
+#define FRAME_ENCODING_COMPACT 1 // numbers of the payload as varints, and the seats of a SHOW as runs
+#define VARINT_MAX_SIZE 10 // maximum size of a varint (a 64-bit number)
+
+typedef struct {
+	char op_code; // operation code (a response carries the operation code of its request)
+	char encoding; // encoding of the payload (FRAME_ENCODING_*, a response has the encoding of its request)
+	char reserved[2]; // always 0
+	uint32_t length; // length of the payload in bytes
+	uint32_t request_id; // id chosen by the client for a request, echoed in its response (0 if unused)
+} frame_header; // header of every message of a session (requests and responses)
+
+typedef struct {
+	char* data; // bytes read and not yet consumed
+	size_t capacity; // size of data
+	size_t start; // position of the first byte not consumed
+	size_t end; // position after the last byte read
+	size_t max_length; // maximum payload length of the frames read (0 for FRAME_MAX_LENGTH, a longer frame is a corrupted stream)
+} frame_buffer; // bytes read from a file descriptor, split in frames
+
+typedef ssize_t (*frame_source)(void *source, void *data, size_t size); // reads at most size bytes, like read
+typedef ssize_t (*frame_sink)(void *sink, const struct iovec *iov, int num_iov); // writes some of the parts, like writev
+
+/// Initializes an empty frame buffer (that accepts frames up to FRAME_MAX_LENGTH).
+/// @param buffer The frame buffer to initialize.
+void frame_buffer_init(frame_buffer *buffer);
+
+/// Frees the memory of a frame buffer.
+/// @param buffer The frame buffer to destroy.
+void frame_buffer_destroy(frame_buffer *buffer);
+
+/// Checks if a whole frame was already read into the buffer (so read_frame won't read from the file descriptor).
+/// @param buffer The frame buffer.
+/// @return 1 if there is a whole frame in the buffer, 0 otherwise.
+int frame_buffer_has_frame(const frame_buffer *buffer);
+
+/// Reads the next frame. The buffer is filled with reads as large as it allows, so a frame
+/// usually costs a single read, and reads that return part of a frame are continued.
+/// On a non-blocking file descriptor, the part of a frame read so far stays in the buffer until the rest arrives.
+/// @param fd The file descriptor to read from.
+/// @param buffer The frame buffer of the file descriptor.
+/// @param header Pointer to the variable to store the header in.
+/// @param payload Pointer to the variable to store the payload in (valid until the next read from the buffer).
+/// @return 0 if a frame was read, 1 if the end of file was reached, the stream is corrupted or the read failed,
+///         2 if the rest of the frame didn't arrive yet (the file descriptor is non-blocking).
+int read_frame(int fd, frame_buffer *buffer, frame_header *header, const char **payload);
+
+/// Reads the next frame from any source of bytes (see read_frame).
+/// @param read_some The function reading from the source (it waits for at least a byte, or fails with EAGAIN).
+/// @param source The source, passed to read_some.
+/// @param buffer The frame buffer of the source.
+/// @param header Pointer to the variable to store the header in.
+/// @param payload Pointer to the variable to store the payload in (valid until the next read from the buffer).
+/// @return 0 if a frame was read, 1 if the end of the source was reached, the stream is corrupted or the read failed,
+///         2 if the rest of the frame didn't arrive yet.
+int read_frame_from(frame_source read_some, void *source, frame_buffer *buffer, frame_header *header, const char **payload);
+
+/// Prepares the header of a frame and the parts to write (the header, then the non-empty parts of the payload).
+/// @param header The header to fill.
+/// @param iov The parts to write (room for FRAME_MAX_PARTS + 1).
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return The number of parts to write, -1 if the payload is too long.
+int prepare_frame(frame_header *header, struct iovec *iov, char op_code, char encoding, uint32_t request_id,
+		const struct iovec *parts, int num_parts);
+
+/// Writes a frame with a single writev (continued if it only writes part of the frame).
+/// @param fd The file descriptor to write to.
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return 0 if the frame was written, 1 otherwise.
+int write_frame(int fd, char op_code, char encoding, uint32_t request_id, const struct iovec *parts, int num_parts);
+
+/// Writes a frame to a non-blocking file descriptor without waiting: what the file descriptor doesn't take now is
+/// kept in a buffer (after the frames already kept, so the frames stay in order) to be written by flush_frames.
+/// @param fd The file descriptor to write to.
+/// @param pending The frames not written yet.
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return 0 if the frame was written or kept, 1 otherwise.
+int write_frame_nonblocking(int fd, frame_buffer *pending, char op_code, char encoding, uint32_t request_id,
+		const struct iovec *parts, int num_parts);
+
+/// Writes a frame to any sink of bytes without waiting (see write_frame_nonblocking).
+/// @param write_some The function writing to the sink (it doesn't wait, and fails with EAGAIN if the sink is full).
+/// @param sink The sink, passed to write_some.
+/// @param pending The frames not written yet.
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return 0 if the frame was written or kept, 1 otherwise.
+int write_frame_nonblocking_to(frame_sink write_some, void *sink, frame_buffer *pending, char op_code, char encoding,
+		uint32_t request_id, const struct iovec *parts, int num_parts);
+
+/// Writes the frames kept by write_frame_nonblocking, without waiting.
+/// @param fd The file descriptor to write to.
+/// @param pending The frames not written yet.
+/// @return 0 if every frame was written, 1 if the write failed, 2 if some bytes are left (the file descriptor is full).
+int flush_frames(int fd, frame_buffer *pending);
+
+/// Writes the frames kept by write_frame_nonblocking_to, without waiting (see flush_frames).
+/// @param write_some The function writing to the sink.
+/// @param sink The sink, passed to write_some.
+/// @param pending The frames not written yet.
+/// @return 0 if every frame was written, 1 if the write failed, 2 if some bytes are left (the sink is full).
+int flush_frames_to(frame_sink write_some, void *sink, frame_buffer *pending);
+
+/// Writes a number as a LEB128 varint (7 bits per byte, the least significant first).
+/// @param out The buffer to write to (room for VARINT_MAX_SIZE bytes), or NULL to only get the size.
+/// @param value The number.
+/// @return The size of the varint.
+size_t put_varint(char *out, uint64_t value);
+
+/// Reads a LEB128 varint.
+/// @param next Pointer to the next byte to read (advanced past the varint).
+/// @param remaining Pointer to the number of bytes left (decreased by the size of the varint).
+/// @param value Pointer to the variable to store the number in.
+/// @return 0 if the varint was read, 1 if it is truncated or too long.
+int get_varint(const char **next, size_t *remaining, uint64_t *value);
+
+/// Encodes the seats of an event as runs of equal seats: each run is the difference to the previous run's
+/// reservation id (zigzag varint) and its length (varint). Most seats are 0 or in runs of the same reservation.
+/// @param seats The seats.
+/// @param num_seats The number of seats.
+/// @param out The buffer to write to, or NULL to only get the size.
+/// @return The size of the encoded seats.
+size_t encode_seat_runs(const unsigned int *seats, size_t num_seats, char *out);
+
+/// Decodes seats encoded with encode_seat_runs.
+/// @param in The encoded seats.
+/// @param length The size of the encoded seats.
+/// @param seats The array to store the seats in.
+/// @param num_seats The number of seats.
+/// @return 0 if exactly num_seats were decoded, 1 otherwise.
+int decode_seat_runs(const char *in, size_t length, unsigned int *seats, size_t num_seats);
+
+#endif  // COMMON_PROTOCOL_H
@@ -0,0 +1,265 @@
+#include "shm_ring.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/// Rings a doorbell.
+/// @param fd The eventfd of the doorbell.
+static void ring_doorbell(int fd) {
+	uint64_t one = 1;
+	while (write(fd, &one, sizeof(one)) == -1 && errno == EINTR) {
+	}
+}
+
+/// Clears a doorbell (the eventfds are non-blocking).
+/// @param fd The eventfd of the doorbell.
+static void clear_doorbell(int fd) {
+	uint64_t count;
+	while (read(fd, &count, sizeof(count)) == -1 && errno == EINTR) {
+	}
+}
+
+/// Waits for a doorbell, or for the other side to be gone.
+/// @param doorbell_fd The eventfd of the doorbell.
+/// @param peer_fd The socket of the session.
+/// @param timeout_ms The time to wait (-1 to wait forever).
+/// @return 0 if the doorbell rang (it is cleared), 1 if the other side is gone (or the time is up).
+static int wait_doorbell(int doorbell_fd, int peer_fd, int timeout_ms) {
+	struct pollfd fds[] = {{doorbell_fd, POLLIN, 0}, {peer_fd, POLLIN, 0}};
+	int ready;
+
+	while ((ready = poll(fds, 2, timeout_ms)) == -1) {
+		if (errno != EINTR) {
+			return 1;
+		}
+	}
+
+	if (ready == 0) { // the other side is not filling (or emptying) the ring
+		return 1;
+	}
+
+	if (fds[1].revents != 0) { // nothing is sent through the socket once the rings are used: it was closed
+		return 1;
+	}
+
+	clear_doorbell(doorbell_fd);
+	return 0;
+}
+
+/// Waits until a counter of a ring changes (the head for the reader, the tail for the writer). The waiting flag
+/// is set before checking the counter again, and the other side checks the flag after changing the counter:
+/// either the change is seen here, or the other side sees the flag and rings the doorbell.
+/// The timeout covers the whole wait: doorbells rung without changing the counter don't extend it.
+/// @param counter The counter changed by the other side.
+/// @param value The value the counter had.
+/// @param waiting The waiting flag of this side.
+/// @param doorbell_fd The doorbell rung by the other side.
+/// @param end The ring (its socket and timeout).
+/// @return 0 if the counter changed, 1 if the other side is gone (or the time is up).
+static int wait_counter(_Atomic uint64_t *counter, uint64_t value, _Atomic int *waiting, int doorbell_fd, const shm_ring_end *end) {
+	int gone = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	atomic_store(waiting, 1);
+	while (atomic_load(counter) == value && !gone) {
+		int timeout_ms = end->timeout_ms;
+
+		if (timeout_ms != -1) { // what is left of it
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+			timeout_ms = elapsed_ms >= timeout_ms ? 0 : timeout_ms - (int)elapsed_ms;
+		}
+
+		gone = wait_doorbell(doorbell_fd, end->peer_fd, timeout_ms);
+	}
+	atomic_store(waiting, 0);
+
+	return gone;
+}
+
+/// Reads at most size bytes from a ring, waiting for at least one (the source of read_frame_from).
+/// @param source The ring (a shm_ring_end).
+/// @param data The buffer to read to.
+/// @param size The size of the buffer.
+/// @return The number of bytes read, -1 if the other side is gone (or corrupted the ring).
+static ssize_t read_ring(void *source, void *data, size_t size) {
+	shm_ring_end *end = source;
+	shm_ring *ring = end->ring;
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	if (head == tail) {
+		if (wait_counter(&ring->head, tail, &ring->reader_waiting, end->data_fd, end) != 0) {
+			errno = EPIPE;
+			return -1;
+		}
+
+		head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	}
+
+	if (head - tail > SHM_RING_SIZE) { // the other side corrupted the ring
+		errno = EPROTO;
+		return -1;
+	}
+
+	size_t available = (size_t)(head - tail);
+	size_t count = available < size ? available : size;
+	size_t position = (size_t)(tail % SHM_RING_SIZE);
+	size_t first = count < SHM_RING_SIZE - position ? count : SHM_RING_SIZE - position; // up to the end of the ring
+
+	memcpy(data, ring->data + position, first);
+	memcpy((char *)data + first, ring->data, count - first);
+
+	atomic_store(&ring->tail, tail + count);
+	if (atomic_load(&ring->writer_waiting)) {
+		ring_doorbell(end->space_fd);
+	}
+
+	return (ssize_t)count;
+}
+
+int shm_ring_write_frame(shm_ring_end *end, char op_code, char encoding, uint32_t request_id, const struct iovec *parts,
+		int num_parts) {
+	frame_header header;
+	struct iovec iov[FRAME_MAX_PARTS + 1];
+	int num_iov = prepare_frame(&header, iov, op_code, encoding, request_id, parts, num_parts);
+
+	if (num_iov == -1) {
+		return 1;
+	}
+
+	shm_ring *ring = end->ring;
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	int part = 0;
+	size_t offset = 0; // bytes of the part already written
+
+	while (part < num_iov) {
+		uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+		if (head - tail > SHM_RING_SIZE) { // the other side corrupted the ring
+			return 1;
+		}
+
+		if (head - tail == SHM_RING_SIZE) { // full: the reader must free some space first
+			if (wait_counter(&ring->tail, tail, &ring->writer_waiting, end->space_fd, end) != 0) {
+				return 1;
+			}
+			continue;
+		}
+
+		// Copies as much as fits, then publishes it (a large frame is read while it is being written)
+		size_t free_space = SHM_RING_SIZE - (size_t)(head - tail);
+		while (part < num_iov && free_space > 0) {
+			size_t count = iov[part].iov_len - offset < free_space ? iov[part].iov_len - offset : free_space;
+			size_t position = (size_t)(head % SHM_RING_SIZE);
+			size_t first = count < SHM_RING_SIZE - position ? count : SHM_RING_SIZE - position; // up to the end of the ring
+			const char *from = (const char *)iov[part].iov_base + offset;
+
+			memcpy(ring->data + position, from, first);
+			memcpy(ring->data, from + first, count - first);
+
+			head += count;
+			free_space -= count;
+			offset += count;
+			if (offset == iov[part].iov_len) {
+				part++;
+				offset = 0;
+			}
+		}
+
+		atomic_store(&ring->head, head);
+		if (atomic_load(&ring->reader_waiting)) {
+			ring_doorbell(end->data_fd);
+		}
+	}
+
+	return 0;
+}
+
+/// Writes as many bytes of the parts as fit in a ring, without waiting (the sink of write_frame_nonblocking_to).
+/// If the ring is full, the writer is marked as waiting, so the reader rings the space doorbell once it frees space.
+/// @param sink The ring (a shm_ring_end).
+/// @param iov The parts to write.
+/// @param num_iov The number of parts.
+/// @return The number of bytes written, -1 if the ring is full (EAGAIN) or the other side corrupted it.
+static ssize_t write_ring(void *sink, const struct iovec *iov, int num_iov) {
+	shm_ring_end *end = sink;
+	shm_ring *ring = end->ring;
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+	if (head - tail == SHM_RING_SIZE) { // the flag is set before checking the tail again (see wait_counter)
+		atomic_store(&ring->writer_waiting, 1);
+		tail = atomic_load(&ring->tail);
+	}
+
+	if (head - tail > SHM_RING_SIZE) { // the other side corrupted the ring
+		errno = EPROTO;
+		return -1;
+	}
+
+	if (head - tail == SHM_RING_SIZE) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	size_t free_space = SHM_RING_SIZE - (size_t)(head - tail);
+	size_t written = 0;
+
+	for (int i = 0; i < num_iov && written < free_space; i++) {
+		size_t count = iov[i].iov_len < free_space - written ? iov[i].iov_len : free_space - written;
+		size_t position = (size_t)((head + written) % SHM_RING_SIZE);
+		size_t first = count < SHM_RING_SIZE - position ? count : SHM_RING_SIZE - position; // up to the end of the ring
+
+		memcpy(ring->data + position, iov[i].iov_base, first);
+		memcpy(ring->data, (const char *)iov[i].iov_base + first, count - first);
+		written += count;
+	}
+
+	atomic_store(&ring->head, head + written);
+	if (atomic_load(&ring->reader_waiting)) {
+		ring_doorbell(end->data_fd);
+	}
+
+	return (ssize_t)written;
+}
+
+int shm_ring_write_frame_nonblocking(shm_ring_end *end, frame_buffer *pending, char op_code, char encoding,
+		uint32_t request_id, const struct iovec *parts, int num_parts) {
+	return write_frame_nonblocking_to(write_ring, end, pending, op_code, encoding, request_id, parts, num_parts);
+}
+
+int shm_ring_flush_frames(shm_ring_end *end, frame_buffer *pending) {
+	return flush_frames_to(write_ring, end, pending);
+}
+
+int shm_ring_read_frame(shm_ring_end *end, frame_buffer *buffer, frame_header *header, const char **payload) {
+	return read_frame_from(read_ring, end, buffer, header, payload);
+}
+
+int shm_ring_readable(shm_ring_end *end) {
+	return atomic_load_explicit(&end->ring->head, memory_order_acquire) != atomic_load_explicit(&end->ring->tail, memory_order_relaxed);
+}
+
+void shm_ring_arm(shm_ring_end *end) {
+	atomic_store(&end->ring->reader_waiting, 1);
+
+	if (shm_ring_readable(end)) { // the writer may have missed the flag
+		ring_doorbell(end->data_fd);
+	}
+}
+
+void shm_ring_disarm(shm_ring_end *end) {
+	atomic_store(&end->ring->reader_waiting, 0);
+	clear_doorbell(end->data_fd);
+}
+
+void shm_ring_disarm_writer(shm_ring_end *end) {
+	atomic_store(&end->ring->writer_waiting, 0);
+	clear_doorbell(end->space_fd);
+}
@@ -0,0 +1,97 @@
+#ifndef COMMON_SHM_RING_H
+#define COMMON_SHM_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "protocol.h"
+
+#define SHM_RING_SIZE (1u << 20) // Size of the data of a ring (a power of 2, larger frames are streamed through it)
+#define SHM_RING_NUM_FDS 5 // File descriptors passed to attach a session: the shared memory and the 4 doorbells
+#define SHM_RING_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) // Seals of the shared memory (a memfd): its size never changes once it is mapped
+
+typedef struct {
+	_Alignas(64) _Atomic uint64_t head; // bytes written since the ring was created (only changed by the writer)
+	_Atomic int reader_waiting; // 1 while the reader waits (or is about to wait) for the data doorbell
+	_Alignas(64) _Atomic uint64_t tail; // bytes read since the ring was created (only changed by the reader)
+	_Atomic int writer_waiting; // 1 while the writer waits (or is about to wait) for the space doorbell
+	_Alignas(64) char data[SHM_RING_SIZE]; // the bytes, at position modulo SHM_RING_SIZE
+} shm_ring; // single-producer single-consumer ring of bytes (frames, like a pipe) in shared memory
+
+typedef struct {
+	shm_ring requests; // written by the client, read by the server
+	shm_ring responses; // written by the server, read by the client
+} shm_region; // the shared memory of a session
+
+typedef struct {
+	shm_ring *ring; // the ring
+	int data_fd; // eventfd the writer rings when it adds data to a waiting reader
+	int space_fd; // eventfd the reader rings when it frees space for a waiting writer
+	int peer_fd; // socket of the session: if it becomes readable (or is closed), the other side is gone
+	int timeout_ms; // time to wait for the other side to fill or empty the ring, then it is gone (-1 to wait forever)
+} shm_ring_end; // one side's view of a ring (the same for the reader and the writer)
+
+/// Writes a frame to a ring (see write_frame). The payload is copied straight into the ring, and the
+/// data doorbell is only rung if the reader is waiting. A frame larger than the free space is streamed:
+/// the writer waits for the reader to free space (for end->timeout_ms at most).
+/// @param end The ring.
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return 0 if the frame was written, 1 if the payload is too long, or the other side is gone (or corrupted the ring,
+///         or didn't read in time).
+int shm_ring_write_frame(shm_ring_end *end, char op_code, char encoding, uint32_t request_id, const struct iovec *parts,
+		int num_parts);
+
+/// Writes a frame to a ring without waiting (see write_frame_nonblocking): what doesn't fit in the ring now is kept
+/// in a buffer, to be written by shm_ring_flush_frames once the reader rings the space doorbell.
+/// @param end The ring.
+/// @param pending The frames not written yet.
+/// @param op_code The operation code of the frame.
+/// @param encoding The encoding of the payload.
+/// @param request_id The request id of the frame.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts (at most FRAME_MAX_PARTS).
+/// @return 0 if the frame was written or kept, 1 if the payload is too long, or the other side corrupted the ring.
+int shm_ring_write_frame_nonblocking(shm_ring_end *end, frame_buffer *pending, char op_code, char encoding,
+		uint32_t request_id, const struct iovec *parts, int num_parts);
+
+/// Writes the frames kept by shm_ring_write_frame_nonblocking, without waiting. If some bytes are left, the writer
+/// is marked as waiting (the reader rings the space doorbell once it frees space).
+/// @param end The ring.
+/// @param pending The frames not written yet.
+/// @return 0 if every frame was written, 1 if the other side corrupted the ring, 2 if some bytes are left (the ring is full).
+int shm_ring_flush_frames(shm_ring_end *end, frame_buffer *pending);
+
+/// Reads the next frame from a ring (see read_frame), waiting for the data doorbell if it is empty (for
+/// end->timeout_ms at most).
+/// @param end The ring.
+/// @param buffer The frame buffer of the ring.
+/// @param header Pointer to the variable to store the header in.
+/// @param payload Pointer to the variable to store the payload in (valid until the next read from the buffer).
+/// @return 0 if a frame was read, 1 if the stream is corrupted or the other side is gone (or didn't write in time).
+int shm_ring_read_frame(shm_ring_end *end, frame_buffer *buffer, frame_header *header, const char **payload);
+
+/// Checks if there are bytes to read in a ring.
+/// @param end The ring.
+/// @return 1 if the ring is not empty, 0 otherwise.
+int shm_ring_readable(shm_ring_end *end);
+
+/// Marks the reader of a ring as waiting, so the writer rings the data doorbell for the next bytes. If bytes
+/// arrived already, the doorbell is rung now (a reader waiting on it is woken anyway).
+/// @param end The ring.
+void shm_ring_arm(shm_ring_end *end);
+
+/// Marks the reader of a ring as not waiting (the writer stops ringing the data doorbell), and clears the doorbell.
+/// @param end The ring.
+void shm_ring_disarm(shm_ring_end *end);
+
+/// Marks the writer of a ring as not waiting (the reader stops ringing the space doorbell), and clears the doorbell.
+/// @param end The ring.
+void shm_ring_disarm_writer(shm_ring_end *end);
+
+#endif  // COMMON_SHM_RING_H
@@ -0,0 +1,70 @@
+#!/bin/bash
+
+# Measures the cost of reservations on venues of growing size (it should not depend on the size of the venue).
+# Usage: run_reserve_bench.sh <path to server> <path to client> [number of reservations] [repetitions]
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <path to server> <path to client> [number of reservations] [repetitions]"
+    exit 1
+fi
+
+server="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+client="$(cd "$(dirname "$2")" && pwd)/$(basename "$2")"
+reservations="${3:-100}"
+repetitions="${4:-3}"
+
+sizes="200 500 1000"
+seats_per_reservation=255 # the largest reservation the client parses (less than MAX_RESERVATION_SIZE)
+
+work_dir=$(mktemp -d)
+trap 'kill $server_pid 2> /dev/null; rm -rf "$work_dir"' EXIT
+
+# Workload: a square venue, and reservations of 255 seats spread over it (no seat is reserved twice while the
+# reservations fit in the smallest venue)
+make_workload() {
+    local size=$1 seat=0
+    echo "CREATE 1 $size $size"
+    for i in $(seq 1 "$reservations"); do
+        local line=""
+        for j in $(seq 1 $seats_per_reservation); do
+            local index=$(((seat * 7919) % (size * size)))
+            line="$line ($((index / size + 1)),$((index % size + 1)))"
+            seat=$((seat + 1))
+        done
+        echo "RESERVE 1 [${line# }]"
+    done
+}
+
+# Runs a workload on a new server (without delay), and prints the elapsed time in ms.
+run() {
+    local jobs=$1
+    rm -f "$work_dir/bench.sock"
+    "$server" --socket "$work_dir/bench.sock" 0 > /dev/null 2>&1 &
+    server_pid=$!
+    while [ ! -S "$work_dir/bench.sock" ]; do sleep 0.05; done
+
+    local start=$(date +%s%N)
+    "$client" --socket "$work_dir/bench.sock" "$jobs" > /dev/null 2>&1
+    local end=$(date +%s%N)
+
+    kill $server_pid 2> /dev/null
+    wait $server_pid 2> /dev/null
+    echo $(((end - start) / 1000000))
+}
+
+echo "Workload: $reservations reservations of $seats_per_reservation seats, $repetitions repetitions"
+printf "%-12s %10s %10s %16s\n" "venue" "best (ms)" "mean (ms)" "per reserve (us)"
+
+for size in $sizes; do
+    make_workload "$size" > "$work_dir/venue$size.jobs"
+
+    best=""
+    total=0
+    for repetition in $(seq 1 "$repetitions"); do
+        elapsed=$(run "$work_dir/venue$size.jobs")
+        total=$((total + elapsed))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then best=$elapsed; fi
+    done
+
+    printf "%-12s %10d %10d %16d\n" "${size}x${size}" "$best" $((total / repetitions)) $((best * 1000 / reservations))
+done
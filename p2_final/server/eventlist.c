@@ -2,6 +2,7 @@
 
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct EventList* create_list() {
 	struct EventList* list = (struct EventList*)malloc(sizeof(struct EventList));
@@ -12,11 +13,37 @@ struct EventList* create_list() {
 	}
 	list->head = NULL;
 	list->tail = NULL;
+	list->ids = NULL;
+	list->num_ids = 0;
 	return list;
 }
 
+/// Makes room for one more id in the ids of a list. A full array is copied to a larger one: the snapshots
+/// taken keep the old one, and it is freed when the last of them is released.
+/// @param list Event list.
+/// @return 0 if there is room, 1 if the memory could not be allocated.
+static int grow_event_ids(struct EventList* list) {
+	if (list->ids != NULL && list->num_ids < list->ids->capacity) return 0;
+
+	size_t capacity = list->ids != NULL ? list->ids->capacity * 2 : 16;
+	struct EventIds* ids = (struct EventIds*)malloc(sizeof(struct EventIds) + sizeof(unsigned int) * capacity);
+	if (!ids) return 1;
+
+	atomic_init(&ids->references, 1);
+	ids->capacity = capacity;
+
+	if (list->ids != NULL) {
+		memcpy(ids->ids, list->ids->ids, sizeof(unsigned int) * list->num_ids);
+		release_event_ids(list->ids);
+	}
+
+	list->ids = ids;
+	return 0;
+}
+
 int append_to_list(struct EventList* list, struct Event* event) {
 	if (!list) return 1;
+	if (grow_event_ids(list) != 0) return 1;
 
 	struct ListNode* new_node = (struct ListNode*)malloc(sizeof(struct ListNode));
 	if (!new_node) return 1;
@@ -32,12 +59,28 @@ int append_to_list(struct EventList* list, struct Event* event) {
 		list->tail = new_node;
 	}
 
+	list->ids->ids[list->num_ids++] = event->id; // past the ids of every snapshot taken, so none of them sees it
 	return 0;
 }
 
+struct EventIds* take_event_ids(struct EventList* list, size_t* num_ids) {
+	*num_ids = list->num_ids;
+	if (list->ids == NULL) return NULL;
+
+	atomic_fetch_add(&list->ids->references, 1);
+	return list->ids;
+}
+
+void release_event_ids(struct EventIds* ids) {
+	if (ids != NULL && atomic_fetch_sub(&ids->references, 1) == 1) {
+		free(ids);
+	}
+}
+
 static void free_event(struct Event* event) {
 	if (!event) return;
 	free(event->data);
+	free(event->changes);
 	free(event);
 }
 
@@ -53,6 +96,7 @@ void free_list(struct EventList* list) {
 		free(temp);
 	}
 
+	release_event_ids(list->ids);
 	free(list);
 }
 
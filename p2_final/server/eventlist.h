@@ -2,17 +2,25 @@
 #define SERVER_EVENT_LIST_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 
+#define EVENT_CHANGE_LOG_SIZE 4096  // Maximum number of seats reserved last kept per event (to send only what changed)
+
 struct Event {
 	unsigned int id;            // Event id
-	unsigned int reservations;  // Number of reservations for the event.
+	unsigned int reservations;  // Number of reservations for the event (also the version of its seats).
 
 	size_t cols;  // Number of columns.
 	size_t rows;  // Number of rows.
 
 	unsigned int* data;     // Array of size rows * cols with the reservations for each seat.
 	pthread_mutex_t mutex;  // Mutex to protect the event
+
+	size_t* changes;           // Ring with the indexes of the seats reserved last, in order (log_size entries).
+	size_t log_size;           // Size of the ring (at most EVENT_CHANGE_LOG_SIZE, at most the number of seats).
+	size_t num_changes;        // Number of seats logged since the event was created.
+	unsigned int logged_since; // The ring has every seat reserved after this version (older ones were overwritten).
 };
 
 struct ListNode {
@@ -20,18 +28,28 @@ struct ListNode {
 	struct ListNode* next;
 };
 
+// Ids of the events of a list, in order. Events are only appended, so the ids are never changed: a snapshot is
+// the array and the number of ids it had, and the array is only replaced (copied) when it is full
+struct EventIds {
+	atomic_size_t references;  // The list's reference (while it is its array) and one per snapshot being used
+	size_t capacity;           // Number of ids that fit in the array
+	unsigned int ids[];        // Ids of the events
+};
+
 // Linked list structure
 struct EventList {
 	struct ListNode* head;  // Head of the list
 	struct ListNode* tail;  // Tail of the list
 	pthread_rwlock_t rwl;   // Mutex to protect the list
+	struct EventIds* ids;   // Ids of the events (NULL while there are none)
+	size_t num_ids;         // Number of events
 };
 
 /// Creates a new event list.
 /// @return Newly created event list, NULL on failure
 struct EventList* create_list();
 
-/// Appends a new node to the list.
+/// Appends a new node to the list (and the id of its event to the ids of the list).
 /// @param list Event list to be modified.
 /// @param data Event to be stored in the new node.
 /// @return 0 if the node was appended successfully, 1 otherwise.
@@ -42,6 +60,16 @@ int append_to_list(struct EventList* list, struct Event* data);
 /// @return 0 if the node was removed successfully, 1 otherwise.
 void free_list(struct EventList* list);
 
+/// Takes a reference to the ids of the events of a list (with the rwl of the list locked).
+/// @param list Event list.
+/// @param num_ids Pointer to store the number of ids of the snapshot in.
+/// @return The ids (valid until release_event_ids is called), NULL if there are no events.
+struct EventIds* take_event_ids(struct EventList* list, size_t* num_ids);
+
+/// Releases a reference to the ids of the events of a list (freed with the last one).
+/// @param ids The ids (NULL is ignored).
+void release_event_ids(struct EventIds* ids);
+
 /// Retrieves an event in the list.
 /// @param list Event list to be searched
 /// @param event_id Event id.
@@ -12,26 +12,8 @@
 #include "common/constants.h"
 #include "common/io.h"
 #include "operations.h"
-
-typedef struct {
-	char req_pipe_path[PIPE_PATH_MAX]; // Path to the request pipe
-	char resp_pipe_path[PIPE_PATH_MAX]; // Path to the response pipe
-} session_info; // Session info struct (will be used to pass info to the threads about the client)
-
-typedef struct {
-		session_info** sessions; // Array of session info structs (buffer)
-		int* prod_ptr; // Pointer to the next free position in the array
-		int* cons_ptr; // Pointer to the next position to be consumed in the array
-		int* count; // Number of elements in the buffer
-		pthread_mutex_t* mutex; // Mutex to protect the buffer
-		pthread_cond_t* canProd; // Condition variable to signal that can produce
-		pthread_cond_t* canCons; // Condition variable to signal that can consume
-} common_args; // Common arguments for the threads (based on a producer-consumer buffer implementation)
-
-typedef struct {
-	int session_id; // Session ID
-	common_args *cmmn_args; // Common arguments
-} worker_thread_args; // Worker thread arguments
+#include "reactor.h"
+#include "requests.h"
 
 volatile sig_atomic_t sigusr1_received = 0; // global variable to store the number of SIGUSR1 signals received (it will inform the main thread that n SIGUSR1 signals were received)
 pthread_mutex_t sigusr1_mutex = PTHREAD_MUTEX_INITIALIZER; // to guarantee that the global variable is accessed atomically
@@ -56,350 +38,76 @@ void sigpipe_handler(int s) { // handler routine for the SIGPIPE signal (to prev
 	// The code will continue to run normally because the code is well prepared to deal with errors on write/read operations
 }
 
-/// @brief The routine of the worker thread. It will wait for a session to be available in the buffer,
-///        and then it will process the requests of the client. When a client quits, the thread will
-///        wait for another session to be available in the buffer.
-/// @param worker_thread_args args The arguments of the thread.
-/// @return void* ALthough it returns void*, it will never return anything
-void* worker_thread(void* args) {
-	int session_id = ((worker_thread_args*)args)->session_id; // gets the session id of the thread (it does not change)
-	common_args* cmmn_args = ((worker_thread_args*)args)->cmmn_args; // gets the common arguments
-
-	ssize_t num_bytes; // used in some read/write operations
-
-	// For handling the SIGPIPE signal:
-	signal(SIGPIPE, sigpipe_handler);
-
-	// For blocking the SIGUSR1 signal in this thread:
-	sigset_t mask; // represents a set of signals to block in this thread
-	sigemptyset(&mask); // initialize the set to an empty set
-	sigaddset(&mask, SIGUSR1); // add the SIGUSR1 signal to the set
-	pthread_sigmask(SIG_BLOCK, &mask, NULL); // block the SIGUSR1 signal in this thread
-
-	session_info* current_session_info = NULL; // to store the current session info
-
-	while (1) {
-		// A producer-consumer slot distribution implementation:
-		pthread_mutex_lock(cmmn_args->mutex); // locks the mutex
-		while (*(cmmn_args->count) == 0) { // if the buffer is empty
-			pthread_cond_wait(cmmn_args->canCons, cmmn_args->mutex); // waits until a slot is available for consumption
-		}
-		current_session_info = cmmn_args->sessions[*(cmmn_args->cons_ptr)]; // gets the session from the buffer
-		*(cmmn_args->cons_ptr) = *(cmmn_args->cons_ptr) + 1; // updates the index of the next slot to be consumed
-		if (*(cmmn_args->cons_ptr) == MAX_SESSION_COUNT) {
-			*(cmmn_args->cons_ptr) = 0; // resets the index of the next slot to be consumed
-		}
-		(*(cmmn_args->count)) = (*(cmmn_args->count)) - 1;
-		pthread_cond_signal(cmmn_args->canProd); // signals that a slot is available for production
-		pthread_mutex_unlock(cmmn_args->mutex); // unlocks the mutex
-
-		if (current_session_info == NULL) { // if the session is NULL, then the buffer is empty
-			continue;
-		}
+/// @brief Opens the pipes of a client that asked to start a session and hands the session to the reactor.
+/// @param req_pipe_path The path of the request pipe.
+/// @param resp_pipe_path The path of the response pipe.
+/// @return 0 if the session was started, 1 otherwise.
+int open_session(const char* req_pipe_path, const char* resp_pipe_path) {
+	// The request pipe is opened without waiting for the client to open it (it opens it right after registering).
+	// Both pipes stay non-blocking: the reactor never waits on the file descriptors of a session
+	int req_fd = open(req_pipe_path, O_RDONLY | O_NONBLOCK);
+
+	if (req_fd == -1) { // if the request pipe could not be opened, then it does not exist
+		fprintf(stderr, "Failed to open pipe %s\n", req_pipe_path);
+		return 1;
+	}
 
-		int req_fd = open(current_session_info->req_pipe_path, O_RDONLY); // opens the request pipe
+	// This thread reads the registrations of every client, so it doesn't wait for this one to open its response
+	// pipe: if it didn't yet (ENXIO), the reactor opens it later
+	int resp_fd = open(resp_pipe_path, O_WRONLY | O_NONBLOCK);
 
-		if (req_fd == -1) { // if the request pipe could not be opened, then it does not exist
-			fprintf(stderr, "Failed to open pipe on session %d\n", session_id);
-			continue;
-		}
+	if (resp_fd == -1 && errno != ENXIO) { // if the response pipe could not be opened, then it does not exist
+		fprintf(stderr, "Failed to open pipe %s\n", resp_pipe_path);
+		close(req_fd);
+		return 1;
+	}
 
-		int resp_fd = open(current_session_info->resp_pipe_path, O_WRONLY); // opens the response pipe
+	return reactor_add_session(req_fd, resp_fd, req_pipe_path, resp_pipe_path);
+}
 
-		if (resp_fd == -1) { // if the response pipe could not be opened, then it does not exist
-			fprintf(stderr, "Failed to open pipe on session %d\n", session_id);
-			continue;
-		}
+/// @brief Serves the clients connected to the Unix domain socket (see reactor_listen). The main thread
+///        only lists the events when SIGUSR1 is received, the requests are served by the threads of the reactor.
+/// @param socket_path The path of the socket.
+/// @return int 1 if the socket could not be set up (otherwise it never returns)
+int serve_socket(const char* socket_path) {
+	sigset_t mask, wait_mask; // SIGUSR1 is only unblocked while the main thread waits for it
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &mask, &wait_mask); // blocked before the threads of the reactor are created (they inherit the mask)
+	sigdelset(&wait_mask, SIGUSR1);
 
-		num_bytes = write(resp_fd, &session_id, sizeof(int)); // sends the session id to the client
+	if (signal(SIGUSR1, sigusr1_handler) == SIG_ERR) { // associates the SIGUSR1 signal to the handler routine
+		fprintf(stderr, "Failed to associate SIGUSR1 signal to handler routine\n");
+		return 1;
+	}
 
-		if (num_bytes != sizeof(int)) { // if the number of bytes written is not sizeof(int), then the pipe is full
-			fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-			continue;
-		}
+	if (reactor_start() != 0 || reactor_listen(socket_path) != 0) {
+		fprintf(stderr, "Failed to start serving the socket\n");
+		return 1;
+	}
 
-		int to_continue = 1; // to store if the session should continue or not
-		while (to_continue) {
-			char op_code; // to store the type of operation
-			
-			num_bytes = read(req_fd, &op_code, sizeof(op_code)); // reads the type of operation
-
-			if (num_bytes != 1) { // if the number of bytes read is not 1, then the pipe is empty
-				fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-				int return_code = 1; // 1 means that the operation failed
-				write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-				to_continue = 0;
-				break;
-			}
-
-			switch (op_code) {
-				case '2': { // the client wants to quit
-					printf("Session %d quitting\n", session_id);
-					to_continue = 0;
-					break;
-				}
-
-				case '3': { // the client wants to create an event
-					printf("Session %d creating event\n", session_id);
-					unsigned int event_id;
-					size_t num_rows;
-					size_t num_cols;
-					
-					num_bytes = read(req_fd, &event_id, sizeof(event_id)); // reads the event id
-
-					if (num_bytes != sizeof(event_id)) { // if the number of bytes read is not sizeof(event_id), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = read(req_fd, &num_rows, sizeof(num_rows)); // reads the number of rows
-
-					if (num_bytes != sizeof(num_rows)) { // if the number of bytes read is not sizeof(num_rows), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = read(req_fd, &num_cols, sizeof(num_cols)); // reads the number of columns
-
-					if (num_bytes != sizeof(num_cols)) { // if the number of bytes read is not sizeof(num_cols), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					int return_code = ems_create(event_id, num_rows, num_cols); // creates the event
-
-					if (return_code  != 0) { // creates the event
-						fprintf(stderr, "Failed to create event on session %d\n", session_id);
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						break; // it will continue the session although the event could not be created
-					}
-
-					num_bytes = write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-
-					if (num_bytes != sizeof(int)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					break;
-				}
-
-				case '4': { // the client wants to reserve seats
-					printf("Session %d reserving seats\n", session_id);
-					unsigned int event_id;
-					size_t num_seats;
-					size_t* xs;
-					size_t* ys;
-
-					num_bytes = read(req_fd, &event_id, sizeof(event_id)); // reads the event id
-
-					if (num_bytes != sizeof(event_id)) { // if the number of bytes read is not sizeof(event_id), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = read(req_fd, &num_seats, sizeof(num_seats)); // reads the number of seats
-
-					if (num_bytes != sizeof(num_seats)) { // if the number of bytes read is not sizeof(num_seats), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					xs = malloc(sizeof(size_t) * num_seats); // allocates memory for the x coordinates
-
-					if (xs == NULL) { // if the memory could not be allocated
-						fprintf(stderr, "Failed to allocate memory\n");
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						exit(EXIT_FAILURE);
-					}
-
-					ys = malloc(sizeof(size_t) * num_seats); // allocates memory for the y coordinates
-
-					if (ys == NULL) { // if the memory could not be allocated
-						fprintf(stderr, "Failed to allocate memory\n");
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						exit(EXIT_FAILURE);
-					}
-
-					num_bytes = read(req_fd, xs, sizeof(size_t) * num_seats); // reads the x coordinates
-
-					if (num_bytes != (ssize_t)(sizeof(size_t) * num_seats)) { // if the number of bytes read is not sizeof(size_t) * num_seats, then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = read(req_fd, ys, sizeof(size_t) * num_seats); // reads the y coordinates
-
-					if (num_bytes != (ssize_t)(sizeof(size_t) * num_seats)) { // if the number of bytes read is not sizeof(size_t) * num_seats, then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					int return_code = ems_reserve(event_id, num_seats, xs, ys); // reserves the seats
-
-					free(xs); // frees the memory allocated for the x coordinates
-					free(ys); // frees the memory allocated for the y coordinates
-
-					if (return_code != 0) {
-						fprintf(stderr, "Failed to reserve seats on session %d\n", session_id);
-						write(resp_fd, &return_code, sizeof(int)); // writes the response to the response pipe
-						break; // it will continue the session although the seats could not be reserved
-					}
-					
-					num_bytes = write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-
-					if (num_bytes != sizeof(int)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					break;
-				}
-
-				case '5': { // the client wants to show an event
-					printf("Session %d showing event\n", session_id);
-					unsigned int event_id;
-
-					num_bytes = read(req_fd, &event_id, sizeof(event_id)); // reads the event id
-
-					if (num_bytes != sizeof(event_id)) { // if the number of bytes read is not sizeof(event_id), then the pipe is empty
-						fprintf(stderr, "Failed to read from pipe on session %d\n", session_id);
-						int return_code = 1;
-						write(resp_fd, &return_code, sizeof(int)); // writes the return code to the response pipe
-						to_continue = 0;
-						break;
-					}
-
-					show_data data = ems_show(event_id); // gets the data needed to show the event
-
-					if (data.return_code != 0) { // if the event could not be shown
-						fprintf(stderr, "Failed to show event on session %d\n", session_id);
-						write(resp_fd, &data.return_code, sizeof(int)); // writes the return code to the response pipe
-						break; // it will continue the session although the event could not be shown
-					}
-
-					num_bytes = write(resp_fd, &data.return_code, sizeof(int)); // writes the response to the response pipe
-
-					if (num_bytes != sizeof(int)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = write(resp_fd, &data.num_rows, sizeof(data.num_rows)); // writes the number of rows to the response pipe
-
-					if (num_bytes != sizeof(data.num_rows)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = write(resp_fd, &data.num_cols, sizeof(data.num_cols)); // writes the number of columns to the response pipe
-
-					if (num_bytes != sizeof(data.num_cols)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = write(resp_fd, data.seats, sizeof(unsigned int) * data.num_rows * data.num_cols); // writes a vector with the seats to the response pipe
-					
-					if (num_bytes != (ssize_t)(sizeof(unsigned int) * data.num_rows * data.num_cols)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-					}
-
-					break;
-				}
-
-				case '6': { // the client wants to list the events
-					printf("Session %d listing events\n", session_id);
-
-					list_data data = ems_list_events(); // gets the data needed to list the events
-
-					if (data.return_code != 0) { // if the events could not be listed
-						fprintf(stderr, "Failed to list events on session %d\n", session_id);
-						write(resp_fd, &data.return_code, sizeof(int)); // writes the return code to the response pipe
-						break; // it will continue the session although the events could not be listed
-					}
-
-					num_bytes = write(resp_fd, &data.return_code, sizeof(int)); // writes the return code to the response pipe
-
-					if (num_bytes != sizeof(int)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					num_bytes = write(resp_fd, &data.num_events, sizeof(data.num_events)); // writes the number of events to the response pipe
-
-					if (num_bytes != sizeof(data.num_events)) {
-						fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
-						to_continue = 0;
-						break;
-					}
-
-					if (data.num_events == 0) { // if the number of events is 0, then there is nothing else to write
-						break;
-					}
-
-					num_bytes = write(resp_fd, data.events, sizeof(unsigned int) * data.num_events); // writes a vector with the events to the response pipe
-
-					if (num_bytes != (ssize_t)(sizeof(unsigned int) * data.num_events)) {
-						fprintf(stderr, "Failed to write to pipe\n");
-						to_continue = 0;
-					}
-
-					break;
-				}
+	while (1) {
+		sigsuspend(&wait_mask); // waits for a signal (it can't be missed, SIGUSR1 is blocked outside of this call)
 
-				default: { // the client sent an invalid operation
-					fprintf(stderr, "Invalid operation on session %d\n", session_id);
-					to_continue = 0;
-					break;
-				}
-			}
+		pthread_mutex_lock(&sigusr1_mutex);
+		while (sigusr1_received != 0) { // if there is one or more SIGUSR1 signals received
+			ems_events_info_for_signal(STDOUT_FILENO); // print in stdout a list of events IDs along with its seat status
+			sigusr1_received = sigusr1_received - 1; // update SIGUSR1 flag
 		}
-
-		close(req_fd); // closes the request pipe
-		close(resp_fd); // closes the response pipe
-		unlink(current_session_info->req_pipe_path); // unlinks the request pipe
-		unlink(current_session_info->resp_pipe_path); // unlinks the response pipe
+		pthread_mutex_unlock(&sigusr1_mutex);
 	}
-
-	// The code below is never reached (but it is here)
-	free(args);
-	return NULL;
 }
 
 int main(int argc, char* argv[]) {
+	char* program_name = argv[0];
+	int use_socket = argc > 1 && strcmp(argv[1], "--socket") == 0; // serve a Unix domain socket instead of a named pipe
+	if (use_socket) { // the remaining arguments are the same
+		argc--;
+		argv++;
+	}
+
 	if (argc < 2 || argc > 3) { // if the number of arguments is not 2 or 3
-		fprintf(stderr, "Usage: %s\n <pipe_path> [delay]\n", argv[0]);
+		fprintf(stderr, "Usage: %s\n [--socket] <pipe_path or socket_path> [delay]\n", program_name);
 		return 1;
 	}
 
@@ -421,6 +129,15 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
+	if (signal(SIGPIPE, sigpipe_handler) == SIG_ERR) { // the clients may close their pipes (or sockets) at any time
+		fprintf(stderr, "Failed to associate SIGPIPE signal to handler routine\n");
+		return 1;
+	}
+
+	if (use_socket) {
+		return serve_socket(argv[1]);
+	}
+
 	unlink(argv[1]);
 
 	if (mkfifo(argv[1], 0666) == -1) { // creates the FIFO
@@ -449,40 +166,11 @@ int main(int argc, char* argv[]) {
 		pthread_mutex_unlock(&sigusr1_mutex); 
 	}
 	
-	pthread_t threads[MAX_SESSION_COUNT]; // to store the threads for each session
-	session_info* buffer[MAX_SESSION_COUNT]; // to store the information of each session
-	memset(buffer, 0, sizeof(buffer)); // initializes the buffer to 0
-
-	int prod_ptr = 0; // to store the index of the next slot to be produced
-	int cons_ptr = 0; // to store the index of the next slot to be consumed
-	int count = 0; // to store the number of slots occupied
-	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; // to control access to the buffer
-	pthread_cond_t canProd = PTHREAD_COND_INITIALIZER; // to signal that a slot is available for production
-	pthread_cond_t canCons = PTHREAD_COND_INITIALIZER; // to signal that a slot is available for consumption
-
-	common_args* cmmn_args = malloc(sizeof(common_args)); // allocates memory for the arguments of the thread
-	cmmn_args->sessions = buffer;
-	cmmn_args->prod_ptr = &prod_ptr;
-	cmmn_args->cons_ptr = &cons_ptr;
-	cmmn_args->count = &count;
-	cmmn_args->mutex = &mutex;
-	cmmn_args->canProd = &canProd;
-	cmmn_args->canCons = &canCons;
-
-	for (int i = 1; i <= MAX_SESSION_COUNT; i++) { // initializes the sessions
-		worker_thread_args* args = malloc(sizeof(worker_thread_args)); // allocates memory for the arguments of the thread
-
-		if (args == NULL) { // if the memory could not be allocated
-			fprintf(stderr, "Failed to allocate memory\n");
-			return 1;
-		}
-
-		args->session_id = i;
-		args->cmmn_args = cmmn_args;
-		pthread_create(&threads[i - 1], NULL, worker_thread, args); // creates the thread
+	if (reactor_start() != 0) { // the sessions are served by the threads of the reactor
+		fprintf(stderr, "Failed to start the threads\n");
+		return 1;
 	}
 
-
 	char op_code; // to store the type of operation
 	ssize_t bytes_read; // to store the number of bytes read
 	while (1) {
@@ -499,34 +187,27 @@ int main(int argc, char* argv[]) {
 			continue;
 		}
 
-		session_info* session = malloc(sizeof(session_info)); // allocates memory for the session
+		char req_pipe_path[PIPE_PATH_MAX]; // to store the path of the request pipe
+		char resp_pipe_path[PIPE_PATH_MAX]; // to store the path of the response pipe
 
-		bytes_read = read(server_fd, session->req_pipe_path, sizeof(char) * PIPE_PATH_MAX); // reads the request pipe path
+		bytes_read = read(server_fd, req_pipe_path, sizeof(char) * PIPE_PATH_MAX); // reads the request pipe path
 
 		if (bytes_read != PIPE_PATH_MAX) { // if the number of bytes read is not PIPE_PATH_MAX, then the pipe is empty
 			fprintf(stderr, "Failed to read from pipe\n");
 			return 1;
 		}
 
-		bytes_read = read(server_fd, session->resp_pipe_path, sizeof(char) * PIPE_PATH_MAX); // reads the response pipe path
+		bytes_read = read(server_fd, resp_pipe_path, sizeof(char) * PIPE_PATH_MAX); // reads the response pipe path
 
 		if (bytes_read != PIPE_PATH_MAX) { // if the number of bytes read is not PIPE_PATH_MAX, then the pipe is empty
 			fprintf(stderr, "Failed to read from pipe\n");
 			return 1;
 		}
 
-		pthread_mutex_lock(&mutex); // locks the mutex
-		while (count == MAX_SESSION_COUNT) { // if the buffer is full
-			pthread_cond_wait(&canProd, &mutex); // waits until a slot is available for production
-		}
-		buffer[prod_ptr] = session; // stores the session in the buffer
-		prod_ptr++;
-		if (prod_ptr == MAX_SESSION_COUNT) { // if the index of the next slot to be produced is MAX_SESSION_COUNT, then it wraps around
-			prod_ptr = 0;
-		}
-		count++;
-		pthread_cond_signal(&canCons); // signals that a slot is available for consumption
-		pthread_mutex_unlock(&mutex); // unlocks the mutex
+		req_pipe_path[PIPE_PATH_MAX - 1] = '\0'; // the paths are padded with '\0', but a long one may not be terminated
+		resp_pipe_path[PIPE_PATH_MAX - 1] = '\0';
+
+		open_session(req_pipe_path, resp_pipe_path); // the session is served by the reactor (an idle one costs no thread)
 	}
 	
 	close(server_fd); // closes the FIFO
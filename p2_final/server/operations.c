@@ -97,9 +97,22 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols) {
 	}
 	event->data = calloc(num_rows * num_cols, sizeof(unsigned int));
 
-	if (event->data == NULL) {
+	// A seat is only reserved once, so a log as large as the event never loses a change (unless a reservation gives
+	// a seat twice: it is logged twice)
+	event->log_size = num_rows * num_cols < EVENT_CHANGE_LOG_SIZE ? num_rows * num_cols : EVENT_CHANGE_LOG_SIZE;
+	event->changes = NULL; // an event without seats never logs a change
+	event->num_changes = 0;
+	event->logged_since = 0;
+
+	if (event->log_size > 0) {
+		event->changes = malloc(sizeof(size_t) * event->log_size);
+	}
+
+	if (event->data == NULL || (event->changes == NULL && event->log_size > 0)) {
 		fprintf(stderr, "Error allocating memory for event data\n");
 		pthread_rwlock_unlock(&event_list->rwl);
+		free(event->data);
+		free(event->changes);
 		free(event);
 		return 1;
 	}
@@ -108,6 +121,7 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols) {
 		fprintf(stderr, "Error appending event to list\n");
 		pthread_rwlock_unlock(&event_list->rwl);
 		free(event->data);
+		free(event->changes);
 		free(event);
 		return 1;
 	}
@@ -116,6 +130,79 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols) {
 	return 0;
 }
 
+/// Reserves seats of an event for a new reservation.
+/// @note The mutex of the event must be locked.
+/// @param event Event to reserve the seats of.
+/// @param num_seats Number of seats to reserve.
+/// @param xs Array of rows of the seats to reserve.
+/// @param ys Array of columns of the seats to reserve.
+/// @return 0 if the seats were reserved (a seat given twice is reserved once), 1 if a seat is out of bounds, 2 if a seat
+///         is already reserved.
+static int reserve_seats(struct Event* event, size_t num_seats, size_t* xs, size_t* ys) {
+	for (size_t i = 0; i < num_seats; i++) {
+		if (xs[i] <= 0 || xs[i] > event->rows || ys[i] <= 0 || ys[i] > event->cols) {
+			fprintf(stderr, "Seat out of bounds\n");
+			return 1;
+		}
+	}
+
+	// Only the seats requested are touched: each one is checked and taken in a single pass, so a seat given twice
+	// is found taken by the reservation itself. The seats taken are freed if one is not free (no one sees them)
+	unsigned int reservation_id = event->reservations + 1;
+
+	for (size_t i = 0; i < num_seats; i++) {
+		size_t index = seat_index(event, xs[i], ys[i]);
+
+		if (event->data[index] == reservation_id) { // given earlier in this reservation
+			continue;
+		}
+
+		if (event->data[index] != 0) { // reserved before
+			fprintf(stderr, "Seat already reserved\n");
+
+			while (i > 0) {
+				i--;
+				event->data[seat_index(event, xs[i], ys[i])] = 0;
+			}
+			return 2;
+		}
+
+		event->data[index] = reservation_id;
+	}
+
+	event->reservations = reservation_id;
+
+	for (size_t i = 0; i < num_seats; i++) {
+		size_t index = seat_index(event, xs[i], ys[i]);
+		size_t position = event->num_changes % event->log_size;
+
+		if (event->num_changes >= event->log_size) { // overwrites the oldest change (the seat still has its reservation)
+			unsigned int lost_version = event->data[event->changes[position]];
+			event->logged_since = lost_version > event->logged_since ? lost_version : event->logged_since;
+		}
+
+		event->changes[position] = index;
+		event->num_changes++;
+	}
+
+	return 0;
+}
+
+/// Undoes the last reservation of an event (made with reserve_seats).
+/// @note The mutex of the event must be locked.
+/// @param event Event to undo the reservation of.
+/// @param num_seats Number of seats of the reservation.
+/// @param xs Array of rows of the seats of the reservation.
+/// @param ys Array of columns of the seats of the reservation.
+static void unreserve_seats(struct Event* event, size_t num_seats, size_t* xs, size_t* ys) {
+	for (size_t i = 0; i < num_seats; i++) {
+		event->data[seat_index(event, xs[i], ys[i])] = 0;
+	}
+
+	event->num_changes -= num_seats; // its changes were logged last (the ones they overwrote stay lost)
+	event->reservations--;
+}
+
 int ems_reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys) {
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
@@ -141,42 +228,165 @@ int ems_reserve(unsigned int event_id, size_t num_seats, size_t* xs, size_t* ys)
 		return 1;
 	}
 
-	for (size_t i = 0; i < num_seats; i++) {
-		if (xs[i] <= 0 || xs[i] > event->rows || ys[i] <= 0 || ys[i] > event->cols) {
-			fprintf(stderr, "Seat out of bounds\n");
-			pthread_mutex_unlock(&event->mutex);
+	int result = reserve_seats(event, num_seats, xs, ys);
+
+	pthread_mutex_unlock(&event->mutex);
+	return result == 1; // a seat already reserved is not reported as a failure
+}
+
+/// Compares two events by id (for qsort).
+static int compare_event_ids(const void* a, const void* b) {
+	unsigned int id_a = (*(struct Event* const*)a)->id;
+	unsigned int id_b = (*(struct Event* const*)b)->id;
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+int ems_reserve_all(size_t num_reservations, reservation_data* reservations) {
+	if (event_list == NULL) {
+		fprintf(stderr, "EMS state must be initialized\n");
+		return 1;
+	}
+
+	if (num_reservations == 0) { // nothing to reserve
+		return 0;
+	}
+
+	struct Event** events = malloc(sizeof(struct Event*) * num_reservations); // event of each reservation
+	struct Event** locked = malloc(sizeof(struct Event*) * num_reservations); // distinct events, by id
+
+	if (events == NULL || locked == NULL) {
+		fprintf(stderr, "Error allocating memory for reservations\n");
+		free(events);
+		free(locked);
+		return 1;
+	}
+
+	if (pthread_rwlock_rdlock(&event_list->rwl) != 0) {
+		fprintf(stderr, "Error locking list rwl\n");
+		free(events);
+		free(locked);
+		return 1;
+	}
+
+	for (size_t i = 0; i < num_reservations; i++) {
+		events[i] = get_event_with_delay(reservations[i].event_id, event_list->head, event_list->tail);
+
+		if (events[i] == NULL) {
+			fprintf(stderr, "Event not found\n");
+			pthread_rwlock_unlock(&event_list->rwl);
+			free(events);
+			free(locked);
 			return 1;
 		}
 	}
 
-	for (size_t i = 0; i < event->rows * event->cols; i++) {
-		for (size_t j = 0; j < num_seats; j++) {
-			if (seat_index(event, xs[j], ys[j]) != i) {
-				continue;
-			}
+	pthread_rwlock_unlock(&event_list->rwl);
 
-			if (event->data[i] != 0) {
-				fprintf(stderr, "Seat already reserved\n");
-				pthread_mutex_unlock(&event->mutex);
-				return 0;
-			}
+	// The events are locked in order of id (the only place locking more than one), so two groups can't deadlock
+	memcpy(locked, events, sizeof(struct Event*) * num_reservations);
+	qsort(locked, num_reservations, sizeof(struct Event*), compare_event_ids);
 
+	size_t num_locked = 0;
+	for (size_t i = 0; i < num_reservations; i++) {
+		if (num_locked == 0 || locked[num_locked - 1] != locked[i]) {
+			locked[num_locked++] = locked[i];
+		}
+	}
+
+	for (size_t i = 0; i < num_locked; i++) {
+		pthread_mutex_lock(&locked[i]->mutex);
+	}
+
+	// The reservations are made in order (a later one may conflict with an earlier one), and undone if one fails:
+	// no one sees them before the events are unlocked
+	size_t num_reserved = 0;
+	while (num_reserved < num_reservations) {
+		reservation_data* reservation = &reservations[num_reserved];
+
+		if (reserve_seats(events[num_reserved], reservation->num_seats, reservation->xs, reservation->ys) != 0) {
 			break;
 		}
+
+		num_reserved++;
 	}
 
-	unsigned int reservation_id = ++event->reservations;
+	int return_code = num_reserved < num_reservations;
 
-	for (size_t i = 0; i < num_seats; i++) {
-		event->data[seat_index(event, xs[i], ys[i])] = reservation_id;
+	if (return_code != 0) {
+		while (num_reserved > 0) {
+			num_reserved--;
+			unreserve_seats(events[num_reserved], reservations[num_reserved].num_seats, reservations[num_reserved].xs,
+					reservations[num_reserved].ys);
+		}
 	}
 
-	pthread_mutex_unlock(&event->mutex);
+	for (size_t i = 0; i < num_locked; i++) {
+		pthread_mutex_unlock(&locked[i]->mutex);
+	}
+
+	free(events);
+	free(locked);
+	return return_code;
+}
+
+/// Copies the seats of an event that changed since a version of it (the ones logged with a newer reservation).
+/// @note The mutex of the event must be locked.
+/// @param event Event to copy the seats of.
+/// @param since Version of the event the caller has.
+/// @param return_data The show_data to fill (the seats and changes are allocated, unless nothing changed).
+/// @return 0 if the changes were copied, 1 if they are not all known or sending them would not be smaller.
+static int copy_changes(struct Event* event, unsigned int since, show_data* return_data) {
+	if (since < event->logged_since || since > event->reservations) { // older changes were lost, or another event's version
+		return 1;
+	}
+
+	// The log is in order of reservation, so the changes since the version are the last ones
+	size_t num_logged = event->num_changes < event->log_size ? event->num_changes : event->log_size;
+	size_t num_changes = 0;
+	while (num_changes < num_logged &&
+			event->data[event->changes[(event->num_changes - num_changes - 1) % event->log_size]] > since) {
+		num_changes++;
+	}
+
+	if (num_changes * 2 >= event->rows * event->cols && num_changes > 0) { // an index and a seat each: the whole event is smaller
+		return 1;
+	}
+
+	return_data->all_seats = 0;
+
+	if (num_changes == 0) { // nothing changed since the version
+		return 0;
+	}
+
+	return_data->seats = malloc(sizeof(unsigned int) * num_changes);
+	return_data->changes = malloc(sizeof(size_t) * num_changes);
+
+	if (return_data->seats == NULL || return_data->changes == NULL) {
+		free(return_data->seats);
+		free(return_data->changes);
+		return_data->seats = NULL;
+		return_data->changes = NULL;
+		return_data->all_seats = 1;
+		return 1;
+	}
+
+	for (size_t i = 0; i < num_changes; i++) {
+		size_t index = event->changes[(event->num_changes - num_changes + i) % event->log_size];
+		return_data->changes[i] = index;
+		return_data->seats[i] = event->data[index];
+	}
+
+	return_data->num_changes = num_changes;
 	return 0;
 }
 
-show_data ems_show(unsigned int event_id) {
-	show_data return_data = {0, 0, 0, NULL};
+/// Gets the seats of an event: all of them, or only the ones that changed since a version of it.
+/// @param event_id Id of the event to show.
+/// @param changes_only 1 to get only the seats that changed since the version (if they are known), 0 for all of them.
+/// @param since Version of the event the caller has.
+/// @return a show_data struct (see ems_show_since).
+static show_data show_event(unsigned int event_id, int changes_only, unsigned int since) {
+	show_data return_data = {0, 0, 0, NULL, 0, 1, 0, NULL};
 
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
@@ -208,22 +418,40 @@ show_data ems_show(unsigned int event_id) {
 
 	return_data.num_rows = event->rows;
 	return_data.num_cols = event->cols;
-	return_data.seats = malloc(event->rows * event->cols * sizeof(unsigned int));
+	return_data.version = event->reservations;
 
-	size_t i, j;
+	if (changes_only && copy_changes(event, since, &return_data) == 0) {
+		pthread_mutex_unlock(&event->mutex);
+		return return_data;
+	}
 
-	for (i = 0; i < event->rows; i++) {
-		for (j = 0; j < event->cols; j++) {
-			return_data.seats[i * event->cols + j] = event->data[i * event->cols + j];
+	if (event->rows * event->cols > 0) { // an event without seats has nothing to copy
+		return_data.seats = malloc(event->rows * event->cols * sizeof(unsigned int));
+
+		if (return_data.seats == NULL) {
+			fprintf(stderr, "Error allocating memory for seats\n");
+			pthread_mutex_unlock(&event->mutex);
+			return_data.return_code = 1;
+			return return_data;
 		}
+
+		memcpy(return_data.seats, event->data, event->rows * event->cols * sizeof(unsigned int));
 	}
 
 	pthread_mutex_unlock(&event->mutex);
 	return return_data;
 }
 
+show_data ems_show(unsigned int event_id) {
+	return show_event(event_id, 0, 0);
+}
+
+show_data ems_show_since(unsigned int event_id, unsigned int since) {
+	return show_event(event_id, 1, since);
+}
+
 list_data ems_list_events() {
-	list_data return_data = {0, 0, NULL};
+	list_data return_data = {0, 0, NULL, NULL};
 
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
@@ -237,52 +465,19 @@ list_data ems_list_events() {
 		return return_data;
 	}
 
-	struct ListNode* to = event_list->tail;
-	struct ListNode* current = event_list->head;
-
-	if (current == NULL) {
-		pthread_rwlock_unlock(&event_list->rwl);
-		return return_data;
-	}
-
-	while (1) { // Count number of events
-		return_data.num_events++;
-
-		if (current == to) {
-			break;
-		}
-
-		current = current->next;
-	}
-
-	current = event_list->head; // Reset current
-
-	return_data.events = malloc(return_data.num_events * sizeof(unsigned int)); // Allocate memory for events
-
-	if (return_data.events == NULL) {
-		fprintf(stderr, "Error allocating memory for an array of events\n");
-		pthread_rwlock_unlock(&event_list->rwl);
-		return_data.return_code = 1;
-		return return_data;
-	}
-
-	memset(return_data.events, 0, return_data.num_events * sizeof(unsigned int)); // Zero out memory
-	
-	int i = 0;
-	while (1) {
-		return_data.events[i++] = (current->event)->id;
-
-		if (current == to) {
-			break;
-		}
-
-		current = current->next;
-	}
+	return_data.snapshot = take_event_ids(event_list, &return_data.num_events); // the ids are never changed, only appended to
+	return_data.events = return_data.snapshot != NULL ? return_data.snapshot->ids : NULL;
 
 	pthread_rwlock_unlock(&event_list->rwl);
 	return return_data;
 }
 
+void ems_list_release(list_data* data) {
+	release_event_ids(data->snapshot);
+	data->snapshot = NULL;
+	data->events = NULL;
+}
+
 void ems_aux_show_for_signal(int out_fd, unsigned int event_id) {
 	if (event_list == NULL) {
 		fprintf(stderr, "EMS state must be initialized\n");
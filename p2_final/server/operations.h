@@ -3,19 +3,33 @@
 
 #include <stddef.h>
 
+struct EventIds;
+
 typedef struct {
 	int return_code; // 0 if the operation was successful, 1 otherwise
 	size_t num_rows; // number of rows of the event
 	size_t num_cols; // number of columns of the event
-	unsigned int *seats; // array of seats
+	unsigned int *seats; // array of seats (only the ones that changed, if all_seats is 0)
+	unsigned int version; // version of the seats (the number of reservations of the event)
+	int all_seats; // 1 if seats has every seat, 0 if only the ones that changed (with ems_show_since)
+	size_t num_changes; // number of seats that changed (with ems_show_since)
+	size_t *changes; // indexes of the seats that changed (NULL if all_seats is 1, or nothing changed)
 } show_data; // struct to return the data of the show operation
 
 typedef struct {
 	int return_code; // 0 if the operation was successful, 1 otherwise
 	size_t num_events; // number of events
-	unsigned int* events; // array of events
+	const unsigned int* events; // array of events (shared, valid until ems_list_release)
+	struct EventIds* snapshot; // reference to the ids the events are in
 } list_data; // struct to return the data of the list operation
 
+typedef struct {
+	unsigned int event_id; // id of the event to reserve seats of
+	size_t num_seats; // number of seats to reserve
+	size_t *xs; // array of rows of the seats to reserve
+	size_t *ys; // array of columns of the seats to reserve
+} reservation_data; // a reservation of a group created with ems_reserve_all
+
 /// Initializes the EMS state.
 /// @param delay_us Delay in microseconds.
 /// @return 0 if the EMS state was initialized successfully, 1 otherwise.
@@ -39,15 +53,34 @@ int ems_create(unsigned int event_id, size_t num_rows, size_t num_cols);
 /// @return 0 if the reservation was created successfully, 1 otherwise.
 int ems_reserve(unsigned int event_id, size_t num_seats, size_t *xs, size_t *ys);
 
+/// Creates the given reservations, in order, as a whole: either all of them are created or none is.
+/// No other operation sees only part of them.
+/// @param num_reservations Number of reservations.
+/// @param reservations Array of reservations.
+/// @return 0 if all the reservations were created successfully, 1 otherwise (and none was created).
+int ems_reserve_all(size_t num_reservations, reservation_data *reservations);
+
 /// Prints the given event.
 /// @param event_id Id of the event to print.
 /// @return a show_data struct with the return code, the number of rows and columns and the seats.
 show_data ems_show(unsigned int event_id);
 
-/// Prints all the events.
+/// Gets the seats of the given event that changed since a version of it, or all of them if the changes are
+/// no longer known (or sending them is not smaller).
+/// @param event_id Id of the event to show.
+/// @param since Version of the event the caller has (the number of reservations it had).
+/// @return a show_data struct with the return code, the number of rows and columns, the version and the seats
+///         (with their indexes in changes, or every seat if all_seats is 1).
+show_data ems_show_since(unsigned int event_id, unsigned int since);
+
+/// Gets the ids of all the events: a snapshot of the ids kept by the list (without copying them).
 /// @return a list_data struct with the return code, the number of events and the events
 list_data ems_list_events();
 
+/// Releases the events of a list_data returned by ems_list_events.
+/// @param data The list_data.
+void ems_list_release(list_data* data);
+
 /// Prints all the events.
 /// @param out_fd File descriptor to print the events to.
 void ems_events_info_for_signal(int out_fd);
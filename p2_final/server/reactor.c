@@ -0,0 +1,662 @@
+#define _GNU_SOURCE // the seals of a shared memory file (Linux)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+#include "common/protocol.h"
+#include "common/shm_ring.h"
+#include "reactor.h"
+#include "requests.h"
+
+typedef struct {
+	int req_fd; // File descriptor to read the requests from (the request pipe or the socket)
+	int resp_fd; // File descriptor to write the responses to (the response pipe or the socket)
+	int session_id; // Session ID of the client
+	frame_buffer requests; // Bytes read from req_fd (a read may return more than one request, or part of one)
+	frame_buffer responses; // Bytes of responses not written to resp_fd yet (the client is not reading them as fast)
+	int watching_resp; // 1 if resp_fd was added to the epoll instance (a response pipe is watched while responses are left)
+	int has_pipes; // 1 if the pipes must be unlinked when the session ends
+	char req_pipe_path[PIPE_PATH_MAX]; // Path to the request pipe
+	char resp_pipe_path[PIPE_PATH_MAX]; // Path to the response pipe
+	struct stat req_pipe_status; // The request pipe opened (its path is only unlinked if it still names it)
+	struct stat resp_pipe_status; // The response pipe opened (its path is only unlinked if it still names it)
+	int open_timer_fd; // Timer of the next attempt to open the response pipe (-1 once it is open)
+	int open_retry_ms; // Time between the last attempt to open the response pipe and the next one
+	int open_waited_ms; // Time waited so far for the client to open its response pipe
+	int received_fds[SHM_RING_NUM_FDS]; // File descriptors received with the last message on the socket (to attach the shared memory)
+	int num_received_fds; // Number of file descriptors in received_fds
+	shm_region* shm; // Shared memory of the session once attached (NULL before): the requests and responses use its rings
+	shm_ring_end request_ring; // Ring the requests are read from
+	shm_ring_end response_ring; // Ring the responses are written to
+	int wait_fd; // Epoll instance with the request doorbell and the socket, watched instead of the socket once attached
+	int waiting_ring; // 1 if wait_fd was added to the epoll instance of the reactor
+} session; // A client being served by the reactor
+
+static int listen_fd = -1; // Socket where the clients connect (-1 if only named pipes are used)
+static int epoll_fd = -1; // Epoll instance with the listening socket and the request file descriptor of every session
+static atomic_int next_session_id = 1; // Session ID of the next client
+
+/// @brief Waits for the next readiness notification of a file descriptor. Every file descriptor is registered
+///        with EPOLLONESHOT, so a session is served by a single thread at a time and its requests stay in order.
+/// @param fd The file descriptor to watch.
+/// @param data The pointer returned by epoll_wait for the file descriptor (NULL for the listening socket).
+/// @param op EPOLL_CTL_ADD to register the file descriptor, EPOLL_CTL_MOD to watch it again.
+/// @return 0 if the file descriptor is being watched, 1 otherwise.
+static int watch_fd(int fd, void* data, int op) {
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.ptr = data;
+
+	return epoll_ctl(epoll_fd, op, fd, &event) == 0 ? 0 : 1;
+}
+
+/// @brief Waits until the responses left in the buffer of a session can be written. The requests of the session
+///        are not watched meanwhile: a client that doesn't read its responses doesn't get more of them.
+/// @param s The session.
+/// @return 0 if the file descriptor is being watched, 1 otherwise.
+static int watch_responses(session* s) {
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLOUT | EPOLLONESHOT;
+	event.data.ptr = s;
+
+	int op = EPOLL_CTL_MOD; // a socket was added already (it is also req_fd)
+	if (s->resp_fd != s->req_fd && !s->watching_resp) {
+		op = EPOLL_CTL_ADD;
+		s->watching_resp = 1;
+	}
+
+	return epoll_ctl(epoll_fd, op, s->resp_fd, &event) == 0 ? 0 : 1;
+}
+
+/// @brief Closes the file descriptors received on the socket that were not used.
+/// @param s The session.
+static void close_received_fds(session* s) {
+	for (int i = 0; i < s->num_received_fds; i++) {
+		close(s->received_fds[i]);
+	}
+	s->num_received_fds = 0;
+}
+
+/// @brief Allocates a session for the file descriptors of a client.
+/// @param req_fd The file descriptor to read the requests from.
+/// @param resp_fd The file descriptor to write the responses to (-1 if it is not open yet).
+/// @return The session, NULL if the memory could not be allocated.
+static session* create_session(int req_fd, int resp_fd) {
+	session* s = calloc(1, sizeof(session));
+
+	if (s == NULL) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return NULL;
+	}
+
+	s->req_fd = req_fd;
+	s->resp_fd = resp_fd;
+	s->open_timer_fd = -1;
+	frame_buffer_init(&s->requests);
+	frame_buffer_init(&s->responses);
+	s->requests.max_length = FRAME_MAX_REQUEST_LENGTH; // a longer request is never sent, so the buffer stays small
+	return s;
+}
+
+/// @brief Unlinks a pipe of a session, unless its path names another file now (a new client may have created
+///        its pipes with the same paths since).
+/// @param path The path of the pipe.
+/// @param opened The status of the pipe when it was opened.
+static void unlink_pipe(const char* path, const struct stat* opened) {
+	struct stat current;
+
+	if (stat(path, &current) == 0 && current.st_dev == opened->st_dev && current.st_ino == opened->st_ino) {
+		unlink(path);
+	}
+}
+
+/// @brief Ends a session, closing its file descriptors (and unlinking its pipes).
+/// @param s The session (not watched by any thread).
+static void close_session(session* s) {
+	if (s->has_pipes) {
+		unlink_pipe(s->req_pipe_path, &s->req_pipe_status); // unlinks the request pipe
+
+		if (s->resp_fd != -1) { // the response pipe was never opened: it is not the session's
+			unlink_pipe(s->resp_pipe_path, &s->resp_pipe_status); // unlinks the response pipe
+		}
+	}
+
+	if (s->open_timer_fd != -1) {
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->open_timer_fd, NULL);
+		close(s->open_timer_fd);
+	}
+
+	if (s->shm != NULL) {
+		if (s->waiting_ring) {
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->wait_fd, NULL);
+		}
+		close(s->wait_fd);
+		close(s->request_ring.data_fd);
+		close(s->request_ring.space_fd);
+		close(s->response_ring.data_fd);
+		close(s->response_ring.space_fd);
+		munmap(s->shm, sizeof(shm_region));
+	} else {
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->req_fd, NULL);
+	}
+
+	if (s->watching_resp) {
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->resp_fd, NULL);
+	}
+
+	close_received_fds(s);
+	close(s->req_fd);
+
+	if (s->resp_fd != s->req_fd && s->resp_fd != -1) {
+		close(s->resp_fd);
+	}
+
+	frame_buffer_destroy(&s->requests);
+	frame_buffer_destroy(&s->responses);
+	free(s);
+}
+
+/// @brief Sends the session ID to a new client and starts watching its requests.
+/// @param s The session (its file descriptors are closed on failure).
+/// @return 0 if the session was started, 1 otherwise.
+static int start_session(session* s) {
+	s->session_id = atomic_fetch_add(&next_session_id, 1);
+
+	// The session id is the first thing written to the pipe (or socket), so it fits: it is never left in the buffer
+	struct iovec parts[] = {{&s->session_id, sizeof(int)}};
+	if (write_frame_nonblocking(s->resp_fd, &s->responses, '1', FRAME_ENCODING_FIXED, 0, parts, 1) != 0 || // sends the session id to the client
+			s->responses.start != s->responses.end) {
+		fprintf(stderr, "Failed to write to pipe on session %d\n", s->session_id);
+		close_session(s);
+		return 1;
+	}
+
+	if (watch_fd(s->req_fd, s, EPOLL_CTL_ADD) != 0) {
+		fprintf(stderr, "Failed to watch requests on session %d\n", s->session_id);
+		close_session(s);
+		return 1;
+	}
+
+	return 0;
+}
+
+/// @brief Accepts every pending connection on the socket and starts its session.
+static void accept_connections() {
+	int client_fd;
+	while ((client_fd = accept(listen_fd, NULL, NULL)) != -1) { // the listening socket is non-blocking
+		// And so are the connections: a partial request doesn't keep a thread waiting
+		fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+
+		session* s = create_session(client_fd, client_fd);
+
+		if (s == NULL) {
+			close(client_fd);
+			continue;
+		}
+
+		start_session(s);
+	}
+
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+		fprintf(stderr, "Failed to accept connection\n");
+	}
+
+	if (watch_fd(listen_fd, NULL, EPOLL_CTL_MOD) != 0) {
+		fprintf(stderr, "Failed to watch socket\n");
+	}
+}
+
+/// @brief Arms the timer of the next attempt to open the response pipe of a session, and watches it.
+/// @param s The session.
+/// @param op EPOLL_CTL_ADD to register the timer, EPOLL_CTL_MOD to watch it again.
+/// @return 0 if the timer is being watched, 1 otherwise.
+static int schedule_open(session* s, int op) {
+	struct itimerspec timeout;
+	memset(&timeout, 0, sizeof(timeout));
+	timeout.it_value.tv_sec = s->open_retry_ms / 1000;
+	timeout.it_value.tv_nsec = (long)(s->open_retry_ms % 1000) * 1000000;
+
+	s->open_waited_ms += s->open_retry_ms;
+	s->open_retry_ms = s->open_retry_ms * 2 < REACTOR_OPEN_RETRY_MAX_MS ? s->open_retry_ms * 2 : REACTOR_OPEN_RETRY_MAX_MS;
+
+	if (timerfd_settime(s->open_timer_fd, 0, &timeout, NULL) == -1) {
+		return 1;
+	}
+
+	return watch_fd(s->open_timer_fd, s, op);
+}
+
+/// @brief Tries again to open the response pipe of a session whose client didn't open it yet. Once it is open
+///        the session starts, and if the client doesn't open it in time the session ends.
+/// @param s The session (its timer expired).
+static void open_response_pipe(session* s) {
+	uint64_t expirations;
+	while (read(s->open_timer_fd, &expirations, sizeof(expirations)) == -1 && errno == EINTR) { // clears the timer
+	}
+
+	s->resp_fd = open(s->resp_pipe_path, O_WRONLY | O_NONBLOCK);
+
+	if (s->resp_fd == -1) {
+		if (errno != ENXIO || s->open_waited_ms >= REACTOR_OPEN_TIMEOUT_MS) { // the client is not opening it
+			fprintf(stderr, "Failed to open pipe %s\n", s->resp_pipe_path);
+			close_session(s);
+		} else if (schedule_open(s, EPOLL_CTL_MOD) != 0) {
+			fprintf(stderr, "Failed to watch pipe %s\n", s->resp_pipe_path);
+			close_session(s);
+		}
+		return;
+	}
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->open_timer_fd, NULL);
+	close(s->open_timer_fd);
+	s->open_timer_fd = -1;
+
+	fstat(s->resp_fd, &s->resp_pipe_status);
+	start_session(s);
+}
+
+/// @brief Reads from the socket of a session, keeping the file descriptors sent with the bytes (the source of
+///        read_frame_from for sockets; a plain read would close them).
+/// @param source The session.
+/// @param data The buffer to read to.
+/// @param size The size of the buffer.
+/// @return The number of bytes read, 0 if the client closed the socket, -1 on error.
+static ssize_t receive_socket(void* source, void* data, size_t size) {
+	session* s = source;
+	char control[CMSG_SPACE(sizeof(int) * SHM_RING_NUM_FDS)];
+	struct iovec iov = {data, size};
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t read_bytes = recvmsg(s->req_fd, &message, 0);
+
+	for (struct cmsghdr* header = CMSG_FIRSTHDR(&message); read_bytes > 0 && header != NULL; header = CMSG_NXTHDR(&message, header)) {
+		if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		close_received_fds(s); // only the file descriptors of the last message are used
+		size_t num_fds = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		int fds[SHM_RING_NUM_FDS];
+		memcpy(fds, CMSG_DATA(header), sizeof(int) * (num_fds < SHM_RING_NUM_FDS ? num_fds : SHM_RING_NUM_FDS));
+
+		for (size_t i = 0; i < num_fds && i < SHM_RING_NUM_FDS; i++) {
+			s->received_fds[s->num_received_fds++] = fds[i];
+		}
+	}
+
+	return read_bytes;
+}
+
+/// @brief Checks a doorbell received from a client: it must be an eventfd (anything else could make a thread wait
+///        on it forever), and it is made non-blocking (the client may have created it blocking).
+/// @param fd The file descriptor received.
+/// @return 0 if it can be used as a doorbell, 1 otherwise.
+static int check_doorbell(int fd) {
+	char path[64];
+	char target[32];
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+
+	ssize_t size = readlink(path, target, sizeof(target) - 1); // an eventfd is the only file named like this
+	if (size == -1) {
+		return 1;
+	}
+	target[size] = '\0';
+
+	int flags = fcntl(fd, F_GETFL);
+	if (strcmp(target, "anon_inode:[eventfd]") != 0 || flags == -1) {
+		return 1;
+	}
+
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 ? 1 : 0;
+}
+
+/// @brief Attaches the shared memory sent by the client with an attach request ('9'): the shared memory and the
+///        doorbells of its request and response rings. The response is sent through the socket, and then every
+///        request and response of the session goes through the rings (the socket only tells if the client is gone).
+///        The shared memory must be a memfd whose size is sealed, so the client can't shrink it while it is mapped.
+///        If it can't be attached, the session goes on with the socket (s->shm stays NULL).
+/// @param s The session.
+/// @param request The header of the request.
+/// @return 0 if the response was written, 1 otherwise.
+static int attach_shm(session* s, const frame_header* request) {
+	int return_code = 1;
+	struct stat status;
+	int seals; // the seals of the shared memory (only a memfd has them)
+
+	if (s->has_pipes || s->num_received_fds != SHM_RING_NUM_FDS) { // only a socket can carry file descriptors
+		fprintf(stderr, "Invalid shared memory on session %d\n", s->session_id);
+	} else if (fstat(s->received_fds[0], &status) == -1 || !S_ISREG(status.st_mode) || (size_t)status.st_size < sizeof(shm_region)) {
+		fprintf(stderr, "Invalid shared memory on session %d\n", s->session_id);
+	} else if ((seals = fcntl(s->received_fds[0], F_GET_SEALS)) == -1 || (seals & SHM_RING_SEALS) != SHM_RING_SEALS) { // if the client could shrink it, reading it would crash the server
+		fprintf(stderr, "Unsealed shared memory on session %d\n", s->session_id);
+	} else if (check_doorbell(s->received_fds[1]) != 0 || check_doorbell(s->received_fds[2]) != 0 ||
+			check_doorbell(s->received_fds[3]) != 0 || check_doorbell(s->received_fds[4]) != 0) {
+		fprintf(stderr, "Invalid doorbells on session %d\n", s->session_id);
+	} else if ((s->shm = mmap(NULL, sizeof(shm_region), PROT_READ | PROT_WRITE, MAP_SHARED, s->received_fds[0], 0)) == MAP_FAILED) {
+		fprintf(stderr, "Failed to map shared memory on session %d\n", s->session_id);
+		s->shm = NULL;
+	} else if ((s->wait_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		fprintf(stderr, "Failed to create epoll instance\n");
+		munmap(s->shm, sizeof(shm_region));
+		s->shm = NULL;
+	} else {
+		// A client that stops in the middle of a request only keeps the thread for a while (responses never wait)
+		s->request_ring = (shm_ring_end){&s->shm->requests, s->received_fds[1], s->received_fds[2], s->req_fd, REACTOR_RING_TIMEOUT_MS};
+		s->response_ring = (shm_ring_end){&s->shm->responses, s->received_fds[3], s->received_fds[4], s->req_fd, REACTOR_RING_TIMEOUT_MS};
+
+		// The session is ready when the client rings the request doorbell (or the space doorbell of the responses left),
+		// or closes the socket
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		epoll_ctl(s->wait_fd, EPOLL_CTL_ADD, s->request_ring.data_fd, &event);
+		epoll_ctl(s->wait_fd, EPOLL_CTL_ADD, s->response_ring.space_fd, &event);
+		event.events = EPOLLIN | EPOLLRDHUP;
+		epoll_ctl(s->wait_fd, EPOLL_CTL_ADD, s->req_fd, &event);
+
+		close(s->received_fds[0]); // the mapping stays
+		s->num_received_fds = 0; // the doorbells are owned by the rings now
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, s->req_fd, NULL);
+		return_code = 0;
+	}
+
+	close_received_fds(s);
+
+	// No response is left in the buffer when a request is read, so this one fits the socket (it is never left either)
+	struct iovec parts[] = {{&return_code, sizeof(int)}};
+	if (write_frame_nonblocking(s->resp_fd, &s->responses, request->op_code, request->encoding, request->request_id, parts, 1) != 0 ||
+			s->responses.start != s->responses.end) {
+		fprintf(stderr, "Failed to write to pipe on session %d\n", s->session_id);
+		return 1;
+	}
+
+	return 0;
+}
+
+/// @brief Watches a session attached to shared memory again: its request doorbell, or the space doorbell of the
+///        response ring while responses are left (the next requests wait until the client reads them), and its
+///        socket. Closes the session if the client is gone.
+/// @param s The session.
+static void watch_rings(session* s) {
+	int responses_left = s->responses.start != s->responses.end;
+
+	// Nothing is sent through the socket once attached: if it is readable, the client is gone (the requests it sent
+	// before are still served, unless it doesn't read the responses)
+	struct pollfd socket_ready = {s->req_fd, POLLIN, 0};
+	if ((responses_left || !shm_ring_readable(&s->request_ring)) && poll(&socket_ready, 1, 0) > 0) {
+		fprintf(stderr, "Failed to read from pipe on session %d\n", s->session_id);
+		close_session(s);
+		return;
+	}
+
+	int op = s->waiting_ring ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	s->waiting_ring = 1; // set before watching: another thread may serve the session as soon as it is watched
+	if (!responses_left) { // shm_ring_flush_frames marked the writer as waiting otherwise
+		shm_ring_arm(&s->request_ring);
+	}
+
+	if (watch_fd(s->wait_fd, s, op) != 0) {
+		fprintf(stderr, "Failed to watch requests on session %d\n", s->session_id);
+		close_session(s);
+	}
+}
+
+/// @brief Serves the requests a session has ready, then watches it again (or closes it if the session ended).
+///        The file descriptors are non-blocking: a partial request stays in the buffer until the rest arrives, and
+///        the responses the client doesn't read yet stay in the buffer until it does, without a thread waiting.
+/// @param s The session.
+static void serve_session(session* s) {
+	if (s->resp_fd == -1) { // the timer to open the response pipe expired
+		open_response_pipe(s);
+		return;
+	}
+
+	if (s->shm != NULL) { // the client rings the doorbells only while the session waits for them
+		shm_ring_disarm(&s->request_ring);
+		shm_ring_disarm_writer(&s->response_ring);
+	}
+
+	if (s->responses.start != s->responses.end) { // there may be room for them now: the responses left are written first
+		int flushed = s->shm != NULL ? shm_ring_flush_frames(&s->response_ring, &s->responses) : flush_frames(s->resp_fd, &s->responses);
+
+		if (flushed == 1) {
+			fprintf(stderr, "Failed to write to pipe on session %d\n", s->session_id);
+			close_session(s);
+			return;
+		}
+
+		if (flushed == 2 && s->shm != NULL) { // the client is still not reading them
+			watch_rings(s);
+			return;
+		}
+
+		if (flushed == 2) {
+			if (watch_responses(s) != 0) {
+				fprintf(stderr, "Failed to watch responses on session %d\n", s->session_id);
+				close_session(s);
+			}
+			return;
+		}
+	}
+
+	for (int served = 0; ; served++) {
+		// The requests already in the buffer are always served: epoll only reports the file descriptor, so a request
+		// left in the buffer would never be read. A doorbell may also be left over from requests already served, so
+		// a ring is only read if it has bytes
+		if (!frame_buffer_has_frame(&s->requests) && (served >= REACTOR_REQUESTS_PER_WAKEUP ||
+				(s->shm != NULL && !shm_ring_readable(&s->request_ring)))) { // no more requests for now
+			break;
+		}
+
+		frame_header request; // to store the header of the request
+		const char* payload; // to store the payload of the request
+		int failed; // to store if the request could not be read
+
+		if (s->shm != NULL) {
+			failed = shm_ring_read_frame(&s->request_ring, &s->requests, &request, &payload);
+		} else if (s->has_pipes) {
+			failed = read_frame(s->req_fd, &s->requests, &request, &payload);
+		} else {
+			failed = read_frame_from(receive_socket, s, &s->requests, &request, &payload);
+		}
+
+		if (failed == 2) { // the rest of the request didn't arrive yet
+			break;
+		}
+
+		if (failed) { // the client closed the pipe (or socket) without quitting
+			fprintf(stderr, "Failed to read from pipe on session %d\n", s->session_id);
+			close_session(s);
+			return;
+		}
+
+		if (request.op_code == '9' && s->shm == NULL) { // the client wants to use shared memory
+			printf("Session %d attaching shared memory\n", s->session_id);
+
+			if (attach_shm(s, &request) != 0) { // the response could not be written
+				close_session(s);
+				return;
+			}
+
+			if (s->shm != NULL) { // the next requests are in the ring (announced by its doorbell)
+				break;
+			}
+			continue;
+		}
+
+		response_channel out = {s->resp_fd, &s->responses, s->shm != NULL ? &s->response_ring : NULL};
+		if (!process_request(s->session_id, &request, payload, &out)) { // the session ended
+			close_session(s);
+			return;
+		}
+
+		if (s->responses.start != s->responses.end) { // the next requests wait until the client reads its responses
+			break;
+		}
+	}
+
+	if (s->shm == NULL && s->responses.start != s->responses.end) {
+		if (watch_responses(s) != 0) {
+			fprintf(stderr, "Failed to watch responses on session %d\n", s->session_id);
+			close_session(s);
+		}
+		return;
+	}
+
+	if (s->shm == NULL) {
+		if (watch_fd(s->req_fd, s, EPOLL_CTL_MOD) != 0) {
+			fprintf(stderr, "Failed to watch requests on session %d\n", s->session_id);
+			close_session(s);
+		}
+		return;
+	}
+
+	watch_rings(s);
+}
+
+/// @brief The routine of the threads of the pool. Each one waits for ready sessions and serves them.
+/// @param args Unused.
+/// @return void* Although it returns void*, it only returns if waiting fails
+static void* reactor_thread(void* args) {
+	(void)args; // unused parameter
+
+	// For blocking the SIGUSR1 signal in this thread:
+	sigset_t mask; // represents a set of signals to block in this thread
+	sigemptyset(&mask); // initialize the set to an empty set
+	sigaddset(&mask, SIGUSR1); // add the SIGUSR1 signal to the set
+	pthread_sigmask(SIG_BLOCK, &mask, NULL); // block the SIGUSR1 signal in this thread
+
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+
+	while (1) {
+		int num_events = epoll_wait(epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+
+		if (num_events == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr, "Failed to wait for requests\n");
+			return NULL;
+		}
+
+		for (int i = 0; i < num_events; i++) {
+			if (events[i].data.ptr == NULL) { // the listening socket
+				accept_connections();
+			} else {
+				serve_session((session*)events[i].data.ptr);
+			}
+		}
+	}
+}
+
+int reactor_start() {
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (epoll_fd == -1) {
+		fprintf(stderr, "Failed to create epoll instance\n");
+		return 1;
+	}
+
+	for (int i = 0; i < REACTOR_THREAD_COUNT; i++) {
+		pthread_t thread;
+
+		if (pthread_create(&thread, NULL, reactor_thread, NULL) != 0) {
+			fprintf(stderr, "Failed to create thread\n");
+			return 1;
+		}
+
+		pthread_detach(thread);
+	}
+
+	return 0;
+}
+
+int reactor_add_session(int req_fd, int resp_fd, const char* req_pipe_path, const char* resp_pipe_path) {
+	session* s = create_session(req_fd, resp_fd);
+
+	if (s == NULL) {
+		close(req_fd);
+		if (resp_fd != -1) {
+			close(resp_fd);
+		}
+		return 1;
+	}
+
+	s->has_pipes = 1;
+	strncpy(s->req_pipe_path, req_pipe_path, PIPE_PATH_MAX - 1);
+	strncpy(s->resp_pipe_path, resp_pipe_path, PIPE_PATH_MAX - 1);
+	fstat(req_fd, &s->req_pipe_status);
+
+	if (resp_fd != -1) {
+		fstat(resp_fd, &s->resp_pipe_status);
+		return start_session(s);
+	}
+
+	// The client didn't open its response pipe yet: it is opened again after a while (without a thread waiting)
+	s->open_retry_ms = REACTOR_OPEN_RETRY_MS;
+	s->open_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	if (s->open_timer_fd == -1 || schedule_open(s, EPOLL_CTL_ADD) != 0) {
+		fprintf(stderr, "Failed to watch pipe %s\n", resp_pipe_path);
+		close_session(s);
+		return 1;
+	}
+
+	return 0;
+}
+
+int reactor_listen(const char* socket_path) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Socket path too long\n");
+		return 1;
+	}
+	strcpy(address.sun_path, socket_path);
+
+	unlink(socket_path);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (listen_fd == -1) {
+		fprintf(stderr, "Failed to create socket\n");
+		return 1;
+	}
+
+	if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) == -1 || listen(listen_fd, REACTOR_BACKLOG) == -1) {
+		fprintf(stderr, "Failed to bind socket\n");
+		close(listen_fd);
+		return 1;
+	}
+
+	if (watch_fd(listen_fd, NULL, EPOLL_CTL_ADD) != 0) {
+		fprintf(stderr, "Failed to watch socket\n");
+		close(listen_fd);
+		return 1;
+	}
+
+	return 0;
+}
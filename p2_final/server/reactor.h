@@ -0,0 +1,41 @@
+#ifndef SERVER_REACTOR_H
+#define SERVER_REACTOR_H
+
+#include "common/constants.h"
+
+#define REACTOR_THREAD_COUNT 8 // Number of threads serving the sessions (regardless of the number of sessions)
+#define REACTOR_MAX_EVENTS 64 // Maximum number of ready sessions taken by a thread in a single wait
+#define REACTOR_REQUESTS_PER_WAKEUP 16 // Maximum number of requests of a session read from its file descriptor before going back to the others
+#define REACTOR_BACKLOG 128 // Maximum number of pending connections on the socket
+#define REACTOR_RING_TIMEOUT_MS 5000 // Time a thread waits for the client in the middle of a request on the shared memory (responses never wait for room)
+#define REACTOR_OPEN_TIMEOUT_MS 5000 // Time a client has to open its response pipe after registering
+#define REACTOR_OPEN_RETRY_MS 1 // Time until the response pipe is opened again, if the client didn't open it yet (doubled each time)
+#define REACTOR_OPEN_RETRY_MAX_MS 256 // Maximum time between two attempts to open the response pipe
+
+/// @brief Starts the pool of threads serving the sessions. Sessions are registered in an epoll instance shared
+///        by the threads; a thread serves a session only while it has requests ready, so an idle session costs
+///        its file descriptors but no thread, and the number of sessions is not limited by the number of threads.
+///        Their file descriptors are non-blocking, so neither does a partial request or a client not reading its responses.
+///        The threads block SIGUSR1, so it is handled by the main thread.
+/// @return 0 if the threads were started, 1 otherwise.
+int reactor_start();
+
+/// @brief Starts a session of a client that connected through the named pipes: sends its session ID and
+///        hands it to the threads of the reactor, which close and unlink the pipes when the session ends.
+///        If the client didn't open its response pipe yet, the reactor opens it once the client does (and
+///        ends the session if it doesn't within REACTOR_OPEN_TIMEOUT_MS), so no thread waits for it.
+/// @param req_fd The file descriptor of the request pipe (opened for reading).
+/// @param resp_fd The file descriptor of the response pipe (opened for writing), -1 if it couldn't be opened yet.
+/// @param req_pipe_path The path of the request pipe.
+/// @param resp_pipe_path The path of the response pipe.
+/// @return 0 if the session was started, 1 otherwise (the pipes are closed).
+int reactor_add_session(int req_fd, int resp_fd, const char* req_pipe_path, const char* resp_pipe_path);
+
+/// @brief Starts accepting clients on a Unix domain stream socket. Each connection is a session: the server
+///        sends its session ID when it is accepted, and then the requests and responses use the same format as
+///        the named pipes.
+/// @param socket_path The path to bind the socket to (any existing file is removed).
+/// @return 0 if the socket is being listened to, 1 otherwise.
+int reactor_listen(const char* socket_path);
+
+#endif  // SERVER_REACTOR_H
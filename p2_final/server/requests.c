@@ -0,0 +1,677 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/constants.h"
+#include "common/protocol.h"
+#include "operations.h"
+#include "requests.h"
+
+typedef struct {
+	const char* next; // next byte to parse
+	size_t remaining; // number of bytes left in the payload
+	char encoding; // encoding of the payload (FRAME_ENCODING_*)
+} payload_reader; // cursor over the payload of a request
+
+/// @brief Copies the next field of a payload (fields are not aligned in the payload).
+/// @param reader The cursor over the payload.
+/// @param value Pointer to the variable to store the field in.
+/// @param size The size of the field.
+/// @return 0 if the field was copied, 1 if the payload is too short.
+static int take_field(payload_reader* reader, void* value, size_t size) {
+	if (reader->remaining < size) {
+		return 1;
+	}
+
+	memcpy(value, reader->next, size);
+	reader->next += size;
+	reader->remaining -= size;
+	return 0;
+}
+
+/// @brief Reads the next number (a size_t) of a payload, as a varint with the compact encoding.
+/// @param reader The cursor over the payload.
+/// @param value Pointer to the variable to store the number in.
+/// @return 0 if the number was read, 1 if the payload is too short.
+static int take_number(payload_reader* reader, size_t* value) {
+	if (reader->encoding == FRAME_ENCODING_FIXED) {
+		return take_field(reader, value, sizeof(size_t));
+	}
+
+	uint64_t number;
+	if (get_varint(&reader->next, &reader->remaining, &number) != 0 || number > SIZE_MAX) {
+		return 1;
+	}
+
+	*value = (size_t)number;
+	return 0;
+}
+
+/// @brief Reads the next id (an unsigned int) of a payload, as a varint with the compact encoding.
+/// @param reader The cursor over the payload.
+/// @param value Pointer to the variable to store the id in.
+/// @return 0 if the id was read, 1 if the payload is too short.
+static int take_id(payload_reader* reader, unsigned int* value) {
+	if (reader->encoding == FRAME_ENCODING_FIXED) {
+		return take_field(reader, value, sizeof(unsigned int));
+	}
+
+	size_t number;
+	if (take_number(reader, &number) != 0 || number > UINT_MAX) {
+		return 1;
+	}
+
+	*value = (unsigned int)number;
+	return 0;
+}
+
+/// @brief Reads the coordinates of the seats of a reservation (the rows, then the columns).
+/// @param reader The cursor over the payload.
+/// @param num_seats The number of seats.
+/// @param xs Pointer to store the rows in (allocated, NULL if there are none or the memory could not be allocated).
+/// @param ys Pointer to store the columns in (allocated, NULL if there are none or the memory could not be allocated).
+/// @return 0 if the coordinates were read, 1 if the payload is too short, there are more than MAX_RESERVATION_SIZE
+///         seats (or the memory could not be allocated).
+static int take_coordinates(payload_reader* reader, size_t num_seats, size_t** xs, size_t** ys) {
+	size_t min_size = reader->encoding == FRAME_ENCODING_FIXED ? 2 * sizeof(size_t) : 2; // size of a seat (at least)
+
+	*xs = NULL;
+	*ys = NULL;
+
+	if (num_seats > MAX_RESERVATION_SIZE || num_seats > reader->remaining / min_size) { // too many seats, or the payload can't have all the coordinates
+		return 1;
+	}
+
+	if (num_seats == 0) { // nothing to read (nor to allocate)
+		return 0;
+	}
+
+	*xs = malloc(sizeof(size_t) * num_seats); // allocates memory for the x coordinates
+	*ys = malloc(sizeof(size_t) * num_seats); // allocates memory for the y coordinates
+
+	if (*xs == NULL || *ys == NULL) { // if the memory could not be allocated
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	if (reader->encoding == FRAME_ENCODING_FIXED) {
+		take_field(reader, *xs, sizeof(size_t) * num_seats); // copies the x coordinates
+		take_field(reader, *ys, sizeof(size_t) * num_seats); // copies the y coordinates
+		return 0;
+	}
+
+	for (size_t i = 0; i < num_seats; i++) {
+		if (take_number(reader, &(*xs)[i]) != 0) {
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < num_seats; i++) {
+		if (take_number(reader, &(*ys)[i]) != 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/// @brief Appends a number to a response, as a varint with the compact encoding.
+/// @param out The buffer to append to (room for VARINT_MAX_SIZE bytes).
+/// @param encoding The encoding of the response.
+/// @param value The number.
+/// @param size The size of the number with the fixed encoding.
+/// @return The number of bytes appended.
+static size_t put_number(char* out, char encoding, uint64_t value, size_t size) {
+	if (encoding == FRAME_ENCODING_COMPACT) {
+		return put_varint(out, value);
+	}
+
+	if (size == sizeof(unsigned int)) {
+		unsigned int fixed = (unsigned int)value;
+		memcpy(out, &fixed, size);
+	} else {
+		size_t fixed = (size_t)value;
+		memcpy(out, &fixed, size);
+	}
+
+	return size;
+}
+
+/// @brief Writes a response: a frame with the operation code, encoding and request id of the request.
+/// @param out Where to write the response to.
+/// @param request The header of the request.
+/// @param parts The parts of the payload, in order.
+/// @param num_parts The number of parts.
+/// @return 0 if the response was written (or kept to be written), 1 otherwise.
+static int send_response(const response_channel* out, const frame_header* request, const struct iovec* parts, int num_parts) {
+	// What the ring or the file descriptor doesn't take now is kept, so a client not reading its responses keeps no thread
+	if (out->ring != NULL) { // the payload is copied straight into the shared memory of the session
+		return shm_ring_write_frame_nonblocking(out->ring, out->pending, request->op_code, request->encoding, request->request_id,
+				parts, num_parts);
+	}
+
+	return write_frame_nonblocking(out->fd, out->pending, request->op_code, request->encoding, request->request_id, parts, num_parts);
+}
+
+/// @brief Writes a response with only a return code.
+/// @param out Where to write the response to.
+/// @param request The header of the request.
+/// @param return_code The return code of the operation.
+/// @return 0 if the response was written, 1 otherwise.
+static int write_return_code(const response_channel* out, const frame_header* request, int return_code) {
+	struct iovec parts[] = {{&return_code, sizeof(int)}};
+	return send_response(out, request, parts, 1);
+}
+
+
+/// @brief Encodes every seat of an event for a response: as they are with the fixed encoding, as runs with the
+///        compact one (most are 0 or in runs).
+/// @param out Where the response is written to (to report a failure before exiting).
+/// @param request The header of the request.
+/// @param data The seats of the event.
+/// @param size Pointer to store the size of the encoded seats in.
+/// @return The encoded seats (data->seats itself with the fixed encoding, allocated otherwise, NULL if there are none).
+static char* encode_seats(const response_channel* out, const frame_header* request, const show_data* data, size_t* size) {
+	size_t num_seats = data->num_rows * data->num_cols;
+
+	if (request->encoding != FRAME_ENCODING_COMPACT) {
+		*size = sizeof(unsigned int) * num_seats;
+		return (char*)data->seats;
+	}
+
+	*size = encode_seat_runs(data->seats, num_seats, NULL);
+
+	if (*size == 0) { // an event without seats
+		return NULL;
+	}
+
+	char* seats = malloc(*size);
+
+	if (seats == NULL) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		write_return_code(out, request, 1);
+		exit(EXIT_FAILURE);
+	}
+
+	encode_seat_runs(data->seats, num_seats, seats);
+	return seats;
+}
+
+typedef struct {
+	char op_code; // '3' for create, '4' for reserve
+	unsigned char group; // group of a reserve (0 if it is not part of a group)
+	size_t num_rows; // number of rows of the event to create
+	size_t num_cols; // number of columns of the event to create
+	reservation_data reservation; // the event id (for both) and the seats to reserve
+} batch_operation; // an operation of a batch
+
+/// @brief Frees the coordinates of the operations of a batch.
+/// @param operations The operations.
+/// @param num_operations The number of operations.
+static void free_batch(batch_operation* operations, size_t num_operations) {
+	for (size_t i = 0; i < num_operations; i++) {
+		free(operations[i].reservation.xs);
+		free(operations[i].reservation.ys);
+	}
+
+	free(operations);
+}
+
+/// @brief Parses the operations of a batch. Each one is its operation code, its group and the payload the operation
+///        has on its own. Nothing runs before the whole batch is parsed.
+/// @param reader The cursor over the payload of the batch.
+/// @param parsed Pointer to store the operations in (freed with free_batch, NULL for an empty batch).
+/// @param num_operations Pointer to store the number of operations in.
+/// @return 0 if the batch was parsed, 1 if it is invalid.
+static int parse_batch(payload_reader* reader, batch_operation** parsed, size_t* num_operations) {
+	batch_operation* operations = NULL;
+
+	*parsed = NULL;
+
+	if (take_number(reader, num_operations) != 0 || *num_operations > MAX_BATCH_SIZE) {
+		return 1;
+	}
+
+	if (*num_operations > 0) { // an empty batch runs nothing
+		operations = calloc(*num_operations, sizeof(batch_operation));
+
+		if (operations == NULL) {
+			fprintf(stderr, "Failed to allocate memory\n");
+			return 1;
+		}
+	}
+
+	for (size_t i = 0; i < *num_operations; i++) {
+		batch_operation* operation = &operations[i];
+		reservation_data* reservation = &operation->reservation;
+
+		if (take_field(reader, &operation->op_code, sizeof(char)) != 0 || take_field(reader, &operation->group, sizeof(char)) != 0 ||
+				take_id(reader, &reservation->event_id) != 0) {
+			free_batch(operations, i);
+			return 1;
+		}
+
+		if (operation->op_code == '3' && take_number(reader, &operation->num_rows) == 0 && take_number(reader, &operation->num_cols) == 0) {
+			continue;
+		}
+
+		if (operation->op_code != '4' || take_number(reader, &reservation->num_seats) != 0 ||
+				take_coordinates(reader, reservation->num_seats, &reservation->xs, &reservation->ys) != 0) { // not a create, nor a complete reserve
+			free_batch(operations, i + 1);
+			return 1;
+		}
+	}
+
+	if (reader->remaining != 0) { // there is something after the last operation
+		free_batch(operations, *num_operations);
+		return 1;
+	}
+
+	*parsed = operations;
+	return 0;
+}
+
+/// @brief Runs the operations of a batch in order. Consecutive reserves with the same group (other than 0) are
+///        all-or-nothing: they share the result of ems_reserve_all.
+/// @param operations The operations.
+/// @param num_operations The number of operations.
+/// @param results Array to store the return code of each operation in.
+static void run_batch(batch_operation* operations, size_t num_operations, int* results) {
+	size_t i = 0;
+
+	while (i < num_operations) {
+		batch_operation* operation = &operations[i];
+
+		if (operation->op_code == '3') {
+			results[i++] = ems_create(operation->reservation.event_id, operation->num_rows, operation->num_cols);
+			continue;
+		}
+
+		if (operation->group == 0) {
+			reservation_data* reservation = &operation->reservation;
+			results[i++] = ems_reserve(reservation->event_id, reservation->num_seats, reservation->xs, reservation->ys);
+			continue;
+		}
+
+		size_t end = i + 1; // end of the group
+		while (end < num_operations && operations[end].op_code == '4' && operations[end].group == operation->group) {
+			end++;
+		}
+
+		size_t num_reservations = end - i;
+		reservation_data* reservations = malloc(sizeof(reservation_data) * num_reservations);
+		int return_code = 1;
+
+		if (reservations == NULL) {
+			fprintf(stderr, "Failed to allocate memory\n");
+		} else {
+			for (size_t j = 0; j < num_reservations; j++) {
+				reservations[j] = operations[i + j].reservation;
+			}
+
+			return_code = ems_reserve_all(num_reservations, reservations);
+			free(reservations);
+		}
+
+		while (i < end) {
+			results[i++] = return_code;
+		}
+	}
+}
+
+int process_request(int session_id, const frame_header* request, const char* payload, const response_channel* out) {
+	payload_reader reader = {payload, request->length, request->encoding};
+	int to_continue = 1; // to store if the session should continue or not
+
+	if (request->encoding != FRAME_ENCODING_FIXED && request->encoding != FRAME_ENCODING_COMPACT) {
+		fprintf(stderr, "Invalid encoding on session %d\n", session_id);
+		return 0;
+	}
+
+	switch (request->op_code) {
+		case '2': { // the client wants to quit
+			printf("Session %d quitting\n", session_id);
+			to_continue = 0;
+			break;
+		}
+
+		case '3': { // the client wants to create an event
+			printf("Session %d creating event\n", session_id);
+			unsigned int event_id;
+			size_t num_rows;
+			size_t num_cols;
+
+			if (take_id(&reader, &event_id) != 0 || take_number(&reader, &num_rows) != 0 ||
+					take_number(&reader, &num_cols) != 0 || reader.remaining != 0) { // the request is too short or too long
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			int return_code = ems_create(event_id, num_rows, num_cols); // creates the event
+
+			if (return_code != 0) {
+				fprintf(stderr, "Failed to create event on session %d\n", session_id); // it will continue the session although the event could not be created
+			}
+
+			if (write_return_code(out, request, return_code) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			break;
+		}
+
+		case '4': { // the client wants to reserve seats
+			printf("Session %d reserving seats\n", session_id);
+			unsigned int event_id;
+			size_t num_seats;
+			size_t* xs = NULL; // x coordinates
+			size_t* ys = NULL; // y coordinates
+
+			if (take_id(&reader, &event_id) != 0 || take_number(&reader, &num_seats) != 0 ||
+					take_coordinates(&reader, num_seats, &xs, &ys) != 0 || reader.remaining != 0) { // the request doesn't have all the coordinates
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				free(xs);
+				free(ys);
+				to_continue = 0;
+				break;
+			}
+
+			int return_code = ems_reserve(event_id, num_seats, xs, ys); // reserves the seats
+
+			free(xs); // frees the memory allocated for the x coordinates
+			free(ys); // frees the memory allocated for the y coordinates
+
+			if (return_code != 0) {
+				fprintf(stderr, "Failed to reserve seats on session %d\n", session_id); // it will continue the session although the seats could not be reserved
+			}
+
+			if (write_return_code(out, request, return_code) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			break;
+		}
+
+		case '5': { // the client wants to show an event
+			printf("Session %d showing event\n", session_id);
+			unsigned int event_id;
+
+			if (take_id(&reader, &event_id) != 0 || reader.remaining != 0) { // the request is too short or too long
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			show_data data = ems_show(event_id); // gets the data needed to show the event
+
+			if (data.return_code != 0) { // if the event could not be shown
+				fprintf(stderr, "Failed to show event on session %d\n", session_id);
+
+				if (write_return_code(out, request, data.return_code) != 0) {
+					fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+					to_continue = 0;
+				}
+				break; // it will continue the session although the event could not be shown
+			}
+
+			// The return code, the dimensions and the seats are written with a single writev
+			char dimensions[2 * VARINT_MAX_SIZE];
+			size_t dimensions_size = put_number(dimensions, request->encoding, data.num_rows, sizeof(size_t));
+			dimensions_size += put_number(dimensions + dimensions_size, request->encoding, data.num_cols, sizeof(size_t));
+
+			size_t seats_size;
+			char* seats = encode_seats(out, request, &data, &seats_size);
+
+			struct iovec parts[] = {
+				{&data.return_code, sizeof(int)},
+				{dimensions, dimensions_size},
+				{seats, seats_size},
+			};
+
+			if (send_response(out, request, parts, 3) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			if (seats != (char*)data.seats) {
+				free(seats);
+			}
+			free(data.seats);
+			break;
+		}
+
+		case 'A': { // the client wants to show an event it has an older version of
+			printf("Session %d showing event changes\n", session_id);
+			unsigned int event_id;
+			unsigned int since; // version of the event the client has
+
+			if (take_id(&reader, &event_id) != 0 || take_id(&reader, &since) != 0 || reader.remaining != 0) { // the request is too short or too long
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			show_data data = ems_show_since(event_id, since); // gets the seats that changed (or all of them)
+
+			if (data.return_code != 0) { // if the event could not be shown
+				fprintf(stderr, "Failed to show event on session %d\n", session_id);
+
+				if (write_return_code(out, request, data.return_code) != 0) {
+					fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+					to_continue = 0;
+				}
+				break; // it will continue the session although the event could not be shown
+			}
+
+			// The version, whether every seat follows, and the dimensions
+			char full = (char)data.all_seats;
+			char header[3 * VARINT_MAX_SIZE + 1];
+			size_t header_size = put_number(header, request->encoding, data.version, sizeof(size_t));
+			header[header_size++] = full;
+			header_size += put_number(header + header_size, request->encoding, data.num_rows, sizeof(size_t));
+			header_size += put_number(header + header_size, request->encoding, data.num_cols, sizeof(size_t));
+
+			size_t seats_size;
+			char* seats;
+
+			if (full) { // as in a SHOW
+				seats = encode_seats(out, request, &data, &seats_size);
+			} else { // the number of changes, and the index and reservation of each seat that changed
+				seats = malloc(VARINT_MAX_SIZE * (1 + 2 * data.num_changes));
+
+				if (seats == NULL) {
+					fprintf(stderr, "Failed to allocate memory\n");
+					write_return_code(out, request, 1);
+					exit(EXIT_FAILURE);
+				}
+
+				seats_size = put_number(seats, request->encoding, data.num_changes, sizeof(size_t));
+				for (size_t i = 0; i < data.num_changes; i++) {
+					seats_size += put_number(seats + seats_size, request->encoding, data.changes[i], sizeof(size_t));
+					seats_size += put_number(seats + seats_size, request->encoding, data.seats[i], sizeof(unsigned int));
+				}
+			}
+
+			struct iovec parts[] = {
+				{&data.return_code, sizeof(int)},
+				{header, header_size},
+				{seats, seats_size},
+			};
+
+			if (send_response(out, request, parts, 3) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			if (seats != (char*)data.seats) {
+				free(seats);
+			}
+			free(data.seats);
+			free(data.changes);
+			break;
+		}
+
+		case '6': { // the client wants to list the events
+			printf("Session %d listing events\n", session_id);
+
+			if (reader.remaining != 0) { // a list has no payload
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			list_data data = ems_list_events(); // gets the data needed to list the events
+
+			if (data.return_code != 0) { // if the events could not be listed
+				fprintf(stderr, "Failed to list events on session %d\n", session_id);
+
+				if (write_return_code(out, request, data.return_code) != 0) {
+					fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+					to_continue = 0;
+				}
+				break; // it will continue the session although the events could not be listed
+			}
+
+			// The return code, the number of events and the events are written with a single writev
+			char num_events[VARINT_MAX_SIZE];
+			char* events = (char*)data.events; // with the fixed encoding, the ids are sent straight from the snapshot
+			size_t events_size = sizeof(unsigned int) * data.num_events;
+
+			if (request->encoding == FRAME_ENCODING_COMPACT && data.num_events > 0) {
+				events = malloc(VARINT_MAX_SIZE * data.num_events);
+
+				if (events == NULL) {
+					fprintf(stderr, "Failed to allocate memory\n");
+					write_return_code(out, request, 1);
+					exit(EXIT_FAILURE);
+				}
+
+				events_size = 0;
+				for (size_t i = 0; i < data.num_events; i++) {
+					events_size += put_number(events + events_size, request->encoding, data.events[i], sizeof(unsigned int));
+				}
+			}
+
+			struct iovec parts[] = {
+				{&data.return_code, sizeof(int)},
+				{num_events, put_number(num_events, request->encoding, data.num_events, sizeof(size_t))},
+				{events, events_size},
+			};
+
+			if (send_response(out, request, parts, 3) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			if (events != (const char*)data.events) {
+				free(events);
+			}
+			ems_list_release(&data);
+			break;
+		}
+
+		case '7': { // the client wants to run a batch of operations
+			printf("Session %d running a batch\n", session_id);
+			size_t num_operations;
+			batch_operation* operations;
+
+			if (parse_batch(&reader, &operations, &num_operations) != 0) { // the batch is invalid (none of its operations runs)
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			int return_code = 0;
+			int* results = NULL; // return code of each operation (none for an empty batch)
+			char* encoded = malloc(VARINT_MAX_SIZE * (num_operations + 1)); // the number of results and the results
+
+			if (num_operations > 0) {
+				results = malloc(sizeof(int) * num_operations);
+			}
+
+			if ((results == NULL && num_operations > 0) || encoded == NULL) {
+				fprintf(stderr, "Failed to allocate memory\n");
+				write_return_code(out, request, 1);
+				exit(EXIT_FAILURE);
+			}
+
+			run_batch(operations, num_operations, results);
+			free_batch(operations, num_operations);
+
+			size_t encoded_size = put_number(encoded, request->encoding, num_operations, sizeof(size_t));
+			for (size_t i = 0; i < num_operations; i++) {
+				if (request->encoding == FRAME_ENCODING_COMPACT) {
+					encoded_size += put_varint(encoded + encoded_size, (uint64_t)results[i]);
+				} else {
+					memcpy(encoded + encoded_size, &results[i], sizeof(int));
+					encoded_size += sizeof(int);
+				}
+			}
+
+			// The return code, the number of results and the results are written with a single writev
+			struct iovec parts[] = {
+				{&return_code, sizeof(int)},
+				{encoded, encoded_size},
+			};
+
+			if (send_response(out, request, parts, 2) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			free(encoded);
+			free(results);
+			break;
+		}
+
+		case '8': { // the client wants to agree on the encoding of its requests
+			printf("Session %d negotiating encoding\n", session_id);
+			char encoding; // the most compact encoding the client knows
+
+			if (take_field(&reader, &encoding, sizeof(char)) != 0 || reader.remaining != 0) { // the request is too short or too long
+				fprintf(stderr, "Invalid request on session %d\n", session_id);
+				write_return_code(out, request, 1);
+				to_continue = 0;
+				break;
+			}
+
+			int return_code = 0;
+			char accepted = FRAME_ENCODING_FIXED; // an encoding the server doesn't know falls back to the fixed one
+			if (encoding == FRAME_ENCODING_COMPACT) {
+				accepted = FRAME_ENCODING_COMPACT;
+			}
+
+			struct iovec parts[] = {
+				{&return_code, sizeof(int)},
+				{&accepted, sizeof(char)},
+			};
+
+			if (send_response(out, request, parts, 2) != 0) {
+				fprintf(stderr, "Failed to write to pipe on session %d\n", session_id);
+				to_continue = 0;
+			}
+
+			break;
+		}
+
+		default: { // the client sent an invalid operation
+			fprintf(stderr, "Invalid operation on session %d\n", session_id);
+			to_continue = 0;
+			break;
+		}
+	}
+
+	return to_continue;
+}
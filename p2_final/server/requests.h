@@ -0,0 +1,23 @@
+#ifndef SERVER_REQUESTS_H
+#define SERVER_REQUESTS_H
+
+#include "common/protocol.h"
+#include "common/shm_ring.h"
+
+typedef struct {
+	int fd; // File descriptor to write the responses to (the response pipe or the socket, non-blocking), if ring is NULL
+	frame_buffer* pending; // Responses fd (or the ring) didn't take yet, written once there is room for them
+	shm_ring_end* ring; // Ring of the shared memory of the session to write the responses to (NULL if not attached)
+} response_channel; // Where the responses of a session are written to
+
+/// @brief Processes a request of a client: parses its payload, runs the operation and writes the response
+///        (a frame with the same operation code and request id). It is shared by every transport.
+///        The requests of a session are processed in order, so its responses are sent in the order of the requests.
+/// @param session_id The session ID of the client.
+/// @param request The header of the request.
+/// @param payload The payload of the request (request->length bytes).
+/// @param out Where to write the response to.
+/// @return 1 if the session should continue, 0 if it ended (the client quit or the request failed).
+int process_request(int session_id, const frame_header* request, const char* payload, const response_channel* out);
+
+#endif  // SERVER_REQUESTS_H